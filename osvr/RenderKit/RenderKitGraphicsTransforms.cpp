@@ -24,9 +24,10 @@ Russ Taylor working through ReliaSolve.com for Sensics, Inc.
 
 // Internal Includes
 #include "RenderKitGraphicsTransforms.h"
+#include "RenderKitPoseMath.h"
 
 // Library/third-party includes
-#include <quat.h>
+#include <Eigen/Core>
 
 // Standard includes
 #include <iostream>
@@ -43,18 +44,23 @@ namespace renderkit {
             return false;
         }
 
-        // Move the Pose information into Quatlib data structures so
-        // we can operate on it using its functions.
-        q_xyz_quat_type info;
-        info.xyz[0] = state_in.translation.data[0];
-        info.xyz[1] = state_in.translation.data[1];
-        info.xyz[2] = state_in.translation.data[2];
-        info.quat[Q_X] = osvrQuatGetX(&state_in.rotation);
-        info.quat[Q_Y] = osvrQuatGetY(&state_in.rotation);
-        info.quat[Q_Z] = osvrQuatGetZ(&state_in.rotation);
-        info.quat[Q_W] = osvrQuatGetW(&state_in.rotation);
-
-        q_xyz_quat_to_ogl_matrix(OpenGL_out, &info);
+        // The matrix is column-major, which is what OpenGL expects.
+        Eigen::Map<Eigen::Matrix4d> out(OpenGL_out);
+        out = posemath::toMatrix(posemath::fromOSVR<double>(state_in));
+        return true;
+    }
+
+    bool OSVR_PoseStates_to_OpenGL(double* OpenGL_out,
+                                   const OSVR_PoseState* states_in,
+                                   size_t count) {
+        if ((OpenGL_out == nullptr) || (states_in == nullptr && count > 0)) {
+            std::cerr << "OSVR_PoseStates_to_OpenGL called with NULL pointer"
+                      << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            OSVR_PoseState_to_OpenGL(OpenGL_out + 16 * i, states_in[i]);
+        }
         return true;
     }
 
@@ -205,35 +211,63 @@ namespace renderkit {
             return false;
         }
 
-        // Move the Pose information into Quatlib data structures so
-        // we can operate on it using its functions.
-        q_xyz_quat_type info;
-        info.xyz[0] = state_in.translation.data[0];
-        info.xyz[1] = state_in.translation.data[1];
-        info.xyz[2] = state_in.translation.data[2];
-        info.quat[Q_X] = osvrQuatGetX(&state_in.rotation);
-        info.quat[Q_Y] = osvrQuatGetY(&state_in.rotation);
-        info.quat[Q_Z] = osvrQuatGetZ(&state_in.rotation);
-        info.quat[Q_W] = osvrQuatGetW(&state_in.rotation);
-
-        double rightHandedMatrix[16];
-        q_xyz_quat_to_ogl_matrix(&rightHandedMatrix[0], &info);
+        // The math is done in single precision, since that is what the
+        // output is.
+        Eigen::Matrix4f matrix =
+            posemath::toMatrix(posemath::fromOSVR<float>(state_in));
 
         // Negate Z to switch the handedness of the matrix
         // so that we can use a right-handed projection matrix above.
         // @todo switch the above matrix to left handed and remove this.
-        for (size_t i = 0; i < 4; i++) {
-            rightHandedMatrix[2 * 4 + i] *= -1;
+        matrix.col(2) *= -1;
+
+        // Copy to the output matrix, in the same order as OpenGL.
+        Eigen::Map<Eigen::Matrix4f> out(D3D_out);
+        out = matrix;
+
+        return true;
+    }
+
+    bool OSVR_PoseStates_to_D3D(float* D3D_out,
+                                const OSVR_PoseState* states_in,
+                                size_t count) {
+        if ((nullptr == D3D_out) || (nullptr == states_in && count > 0)) {
+            std::cerr << "OSVR_PoseStates_to_D3D called with NULL pointer"
+                      << std::endl;
+            return false;
         }
+        for (size_t i = 0; i < count; i++) {
+            OSVR_PoseState_to_D3D(D3D_out + 16 * i, states_in[i]);
+        }
+        return true;
+    }
 
-        // Copy to the output matrix
-        for (size_t i = 0; i < 4; i++) {
-            for (size_t j = 0; j < 4; j++) {
-                D3D_out[i * 4 + j] =
-                    static_cast<float>(rightHandedMatrix[i * 4 + j]);
-            }
+    bool OSVR_Projections_to_OpenGL(double* OpenGL_out,
+                                    const OSVR_ProjectionMatrix* projections_in,
+                                    size_t count) {
+        if ((OpenGL_out == nullptr) ||
+            (projections_in == nullptr && count > 0)) {
+            std::cerr << "OSVR_Projections_to_OpenGL called with NULL pointer"
+                      << std::endl;
+            return false;
         }
+        for (size_t i = 0; i < count; i++) {
+            OSVR_Projection_to_OpenGL(OpenGL_out + 16 * i, projections_in[i]);
+        }
+        return true;
+    }
 
+    bool OSVR_Projections_to_D3D(float* D3D_out,
+                                 const OSVR_ProjectionMatrix* projections_in,
+                                 size_t count) {
+        if ((nullptr == D3D_out) || (nullptr == projections_in && count > 0)) {
+            std::cerr << "OSVR_Projections_to_D3D called with NULL pointer"
+                      << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            OSVR_Projection_to_D3D(D3D_out + 16 * i, projections_in[i]);
+        }
         return true;
     }
 
@@ -32,6 +32,7 @@ Russ Taylor working through ReliaSolve.com for Sensics, Inc.
 
 // Standard includes
 #include <memory>
+#include <cstddef>
 
 namespace osvr {
 namespace renderkit {
@@ -80,6 +81,15 @@ namespace renderkit {
     bool OSVR_RENDERMANAGER_EXPORT
     OSVR_PoseState_to_D3D(float D3D_out[16], const OSVR_PoseState& state_in);
 
+    /// @brief Produce OpenGL ModelView transforms for count poses at once,
+    /// such as those for all eyes, writing 16 values per pose.
+    bool OSVR_RENDERMANAGER_EXPORT OSVR_PoseStates_to_OpenGL(
+        double* OpenGL_out, const OSVR_PoseState* states_in, size_t count);
+    /// @brief Produce D3D ModelView transforms for count poses at once,
+    /// writing 16 values per pose.
+    bool OSVR_RENDERMANAGER_EXPORT OSVR_PoseStates_to_D3D(
+        float* D3D_out, const OSVR_PoseState* states_in, size_t count);
+
     //=========================================================================
     // Routines to turn the 4x4 projection matrices returned as part of the
     // RenderCallback class into Projection matrices for OpenGL and
@@ -94,6 +104,17 @@ namespace renderkit {
     bool OSVR_RENDERMANAGER_EXPORT OSVR_Projection_to_D3D(
         float D3D_out[16], OSVR_ProjectionMatrix projection_in);
 
+    /// @brief Produce OpenGL Projection matrices for count projections at
+    /// once, writing 16 values per projection.
+    bool OSVR_RENDERMANAGER_EXPORT OSVR_Projections_to_OpenGL(
+        double* OpenGL_out, const OSVR_ProjectionMatrix* projections_in,
+        size_t count);
+    /// @brief Produce Direct3D Projection matrices for count projections at
+    /// once, writing 16 values per projection.
+    bool OSVR_RENDERMANAGER_EXPORT OSVR_Projections_to_D3D(
+        float* D3D_out, const OSVR_ProjectionMatrix* projections_in,
+        size_t count);
+
     //=========================================================================
     // Routines to turn the OSVR viewpoint descriptor into appropriate values
     // for OpenGL and Direct3D (which have different Normalized Device
@@ -0,0 +1,150 @@
+/** @file
+@brief Header file with the internal pose math used on the per-frame path,
+working directly on OSVR_PoseState using Eigen
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Library/third-party includes
+#include <osvr/Util/ClientReportTypesC.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace osvr {
+namespace renderkit {
+
+    /// @brief Pose math on OSVR_PoseState, replacing the quatlib calls that
+    /// used to be made every frame.
+    ///
+    /// Poses are rigid transforms made of a rotation quaternion and a
+    /// translation, composed as (A * B)(p) = A(B(p)), matching
+    /// q_xyz_quat_compose().  The Scalar template parameter selects the
+    /// precision the math is done in; float lets Eigen use four-wide SIMD
+    /// for the quaternion and 4x4 matrix operations, while double matches
+    /// the precision of OSVR_PoseState.
+    ///  This header is internal to the library; it is not installed.
+    namespace posemath {
+
+        /// Rotation and translation in the chosen precision.
+        template <typename Scalar> struct Pose {
+            typedef Eigen::Quaternion<Scalar> Quaternion;
+            typedef Eigen::Matrix<Scalar, 3, 1> Vector;
+            Quaternion rotation;
+            Vector translation;
+
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        };
+
+        /// Read an OSVR_PoseState into a Pose.
+        template <typename Scalar>
+        inline Pose<Scalar> fromOSVR(const OSVR_PoseState& pose) {
+            Pose<Scalar> ret;
+            ret.rotation = typename Pose<Scalar>::Quaternion(
+                static_cast<Scalar>(osvrQuatGetW(&pose.rotation)),
+                static_cast<Scalar>(osvrQuatGetX(&pose.rotation)),
+                static_cast<Scalar>(osvrQuatGetY(&pose.rotation)),
+                static_cast<Scalar>(osvrQuatGetZ(&pose.rotation)));
+            ret.translation = typename Pose<Scalar>::Vector(
+                static_cast<Scalar>(osvrVec3GetX(&pose.translation)),
+                static_cast<Scalar>(osvrVec3GetY(&pose.translation)),
+                static_cast<Scalar>(osvrVec3GetZ(&pose.translation)));
+            return ret;
+        }
+
+        /// Write a Pose into an OSVR_PoseState.
+        template <typename Scalar>
+        inline void toOSVR(OSVR_PoseState& out, const Pose<Scalar>& pose) {
+            osvrVec3SetX(&out.translation, pose.translation.x());
+            osvrVec3SetY(&out.translation, pose.translation.y());
+            osvrVec3SetZ(&out.translation, pose.translation.z());
+            osvrQuatSetW(&out.rotation, pose.rotation.w());
+            osvrQuatSetX(&out.rotation, pose.rotation.x());
+            osvrQuatSetY(&out.rotation, pose.rotation.y());
+            osvrQuatSetZ(&out.rotation, pose.rotation.z());
+        }
+
+        /// Identity pose.
+        template <typename Scalar> inline Pose<Scalar> identity() {
+            Pose<Scalar> ret;
+            ret.rotation.setIdentity();
+            ret.translation.setZero();
+            return ret;
+        }
+
+        /// Pure rotation by angleRadians around the given axis.
+        template <typename Scalar>
+        inline Pose<Scalar>
+        fromAxisAngle(const typename Pose<Scalar>::Vector& axis,
+                      Scalar angleRadians) {
+            Pose<Scalar> ret;
+            ret.rotation = typename Pose<Scalar>::Quaternion(
+                Eigen::AngleAxis<Scalar>(angleRadians, axis.normalized()));
+            ret.translation.setZero();
+            return ret;
+        }
+
+        /// Returns aFromB * bFromC = aFromC.  The rotation of aFromB must
+        /// be of unit length, as the poses OSVR reports are.
+        template <typename Scalar>
+        inline Pose<Scalar> compose(const Pose<Scalar>& aFromB,
+                                    const Pose<Scalar>& bFromC) {
+            Pose<Scalar> ret;
+            ret.rotation = aFromB.rotation * bFromC.rotation;
+            ret.translation =
+                aFromB.translation + aFromB.rotation * bFromC.translation;
+            return ret;
+        }
+
+        /// Returns the inverse of aFromB, which is bFromA.  Like quatlib,
+        /// this uses the true inverse of the quaternion, so it does not
+        /// require it to be of unit length.  Eigen's quaternion-vector
+        /// product assumes a unit quaternion, so the translation is
+        /// rotated by the normalized inverse.
+        template <typename Scalar>
+        inline Pose<Scalar> invert(const Pose<Scalar>& aFromB) {
+            Pose<Scalar> ret;
+            ret.rotation = aFromB.rotation.inverse();
+            ret.translation =
+                -(ret.rotation.normalized() * aFromB.translation);
+            return ret;
+        }
+
+        /// 4x4 homogeneous matrix for the pose, which transforms column
+        /// vectors.  Its data() is in the column-major order that OpenGL
+        /// expects, matching q_xyz_quat_to_ogl_matrix().  The rotation is
+        /// normalized first, as quatlib does.
+        template <typename Scalar>
+        inline Eigen::Matrix<Scalar, 4, 4> toMatrix(const Pose<Scalar>& pose) {
+            Eigen::Matrix<Scalar, 4, 4> ret;
+            ret.template topLeftCorner<3, 3>() =
+                pose.rotation.normalized().toRotationMatrix();
+            ret.template topRightCorner<3, 1>() = pose.translation;
+            ret.template bottomLeftCorner<1, 3>().setZero();
+            ret(3, 3) = 1;
+            return ret;
+        }
+
+    } // namespace posemath
+
+} // namespace renderkit
+} // namespace osvr
@@ -42,6 +42,9 @@ Russ Taylor working through ReliaSolve.com for Sensics, Inc.
 #include <memory>
 #include <mutex>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
 
 namespace osvr {
 namespace renderkit {
@@ -67,6 +70,7 @@ namespace renderkit {
     /// and also #include the appropriate file that describes the class.
     class GraphicsLibraryD3D11;
     class GraphicsLibraryOpenGL;
+    class DynamicResolutionController;
     class GraphicsLibrary {
       public:
         GraphicsLibraryD3D11* D3D11 =
@@ -191,6 +195,36 @@ namespace renderkit {
         OSVR_TimeValue deadline //< When the frame should be sent to the screen
         );
 
+    /// @brief Describes the parameters for a stereo render callback handler.
+    ///
+    /// Like RenderCallback, but called once per space for several eyes at
+    /// once, so that the application can submit its geometry once and
+    /// draw it for every eye with instancing.  The arrays hold one entry
+    /// per eye, in eye order.  When the renderer supports single-pass
+    /// stereo, all eyes are passed and each eye is a layer of a layered
+    /// render target (in OpenGL, eye i is gl_Layer i of the bound
+    /// framebuffer); otherwise the callback is called once per eye with a
+    /// single eye, with that eye's buffer set up as for RenderCallback.
+    /// Unlike RenderCallback, the ModelView and projection are not set in
+    /// the graphics library's fixed-function state.
+    typedef void (*StereoRenderCallback)(
+        void* userData //< Passed into AddStereoRenderCallback
+        ,
+        GraphicsLibrary library //< Graphics library context to use
+        ,
+        RenderBuffer buffers //< Information on buffers to render to
+        ,
+        size_t numEyes //< How many entries are in each array below
+        ,
+        const OSVR_ViewportDescription* viewports //< Viewport of each eye
+        ,
+        const OSVR_PoseState* poses //< ModelView of each eye
+        ,
+        const OSVR_ProjectionMatrix* projections //< Projection of each eye
+        ,
+        OSVR_TimeValue deadline //< When the frame should be sent to the screen
+        );
+
     /// @brief Describes the parameters needed to render to an eye.
     ///
     /// Description of what is needed to construct and fill in a
@@ -223,6 +257,31 @@ namespace renderkit {
     /// 2D float data, like a texture coordinate for example.
     using Float2 = std::array<float, 2>;
 
+    /// @brief Renders to HMDs and other displays on behalf of a client.
+    ///
+    /// Thread safety: all public methods may be called from any thread.
+    /// They are grouped as follows by what they wait for.
+    ///  - Graphics submission (OpenDisplay(), Render(),
+    /// RegisterRenderBuffers(), PresentRenderBuffers() and the GPU part of
+    /// UpdateDistortionMeshes()) is serialized by m_mutex, which is held
+    /// for the whole call, including any wait for vertical sync and any
+    /// client callbacks.  Callbacks must not call back into the
+    /// RenderManager from another thread and wait for it.
+    ///  - LatchRenderInfo() does not wait for graphics submission; it only
+    /// waits for other users of the client context (m_stateMutex), which
+    /// are held briefly.  It publishes an immutable snapshot of the
+    /// RenderInfo it computes.
+    ///  - GetRenderInfo(size_t) only reads the most-recently published
+    /// snapshot and never blocks.  Values returned by the indexed calls
+    /// made after a LatchRenderInfo() may come from a newer snapshot if
+    /// another thread latches in between; use GetRenderInfoSnapshot() to
+    /// read a consistent set.
+    ///  - LatchFrameRenderInfo() updates the client context at most once
+    /// per frame, so that all of the callers asking for a frame's render
+    /// info share one update and one head pose.  GetRenderInfo() and
+    /// LatchRenderInfo() update it on every call.
+    ///  - UpdateDistortionMeshes() computes the new meshes before taking
+    /// m_mutex, so only the swap of GPU buffers waits for a present.
     class RenderManager {
       public:
         ///-------------------------------------------------------------
@@ -311,6 +370,32 @@ namespace renderkit {
             void* userData = nullptr //< Pointer given to AddRenderCallback
             );
 
+        /// @brief Add a stereo render callback for a given space.
+        ///
+        /// As AddRenderCallback(), but the callback is handed all of the
+        /// eyes at once where the renderer supports it; see
+        /// StereoRenderCallback.  Stereo callbacks are called after the
+        /// per-eye render callbacks for the frame.
+        bool OSVR_RENDERMANAGER_EXPORT AddStereoRenderCallback(
+            const std::string&
+                interfaceName //< Name of the space, or "/" for world
+            ,
+            StereoRenderCallback callback //< Function to call to render
+            ,
+            void* userData = nullptr //< Passed to callback function
+            );
+        /// @brief Remove a previously-added stereo callback handler.
+        bool OSVR_RENDERMANAGER_EXPORT RemoveStereoRenderCallback(
+            const std::string&
+                interfaceName //< Name given to AddStereoRenderCallback
+            ,
+            StereoRenderCallback
+                callback //< Function pointer given to AddStereoRenderCallback
+            ,
+            void* userData = nullptr //< Pointer given to
+                                     /// AddStereoRenderCallback
+            );
+
         ///-------------------------------------------------------------
         /// @brief Parameters passed to Render() method
         ///
@@ -382,13 +467,23 @@ namespace renderkit {
         inline std::vector<RenderInfo> OSVR_RENDERMANAGER_EXPORT
         GetRenderInfo(const RenderParams& params = RenderParams()) {
             std::vector<RenderInfo> ret;
-            size_t num = LatchRenderInfo(params);
-            for (size_t i = 0; i < num; i++) {
-                ret.push_back(GetRenderInfo(i));
-            }
+            GetRenderInfo(params, ret);
             return ret;
         }
 
+        /// @brief Gets the parameters needed to render all eyes into
+        /// caller-provided storage.
+        ///
+        /// Same as above, but fills in infoOut, reusing its storage, so
+        /// that a render loop that keeps the vector between frames does
+        /// not allocate.
+        ///  Both versions update the client context and read new poses on
+        /// every call, as LatchRenderInfo() does, and publish the result
+        /// for GetRenderInfo(size_t).
+        ///  @return True on success; false (with infoOut empty) on failure.
+        bool OSVR_RENDERMANAGER_EXPORT GetRenderInfo(
+            const RenderParams& params, std::vector<RenderInfo>& infoOut);
+
         /// @brief Registers texture buffers to be used to render all eyes and
         /// displays.
         ///
@@ -494,6 +589,33 @@ namespace renderkit {
             return false;
         }
 
+        ///-------------------------------------------------------------
+        /// @brief Get the time-warp threshold currently in effect
+        ///
+        /// Reports how many milliseconds before vsync PresentRenderBuffers()
+        /// stops waiting and applies time warp.  This is the configured
+        /// m_maxMSBeforeVsyncTimeWarp unless m_adaptiveTimeWarpThreshold is
+        /// set, in which case it is the value computed from recently
+        /// measured present durations.  Does not lock the mutex, so it can
+        /// be polled from another thread while a present is in progress.
+        ///  Renderers that harness another one to present report its
+        /// threshold.
+        virtual float OSVR_RENDERMANAGER_EXPORT
+        GetTimeWarpThresholdMS() const {
+            return m_timeWarpThresholdMS;
+        }
+
+        ///-------------------------------------------------------------
+        /// @brief Get the resolution scale currently in effect
+        ///
+        /// Reports the fraction of each dimension of the eye textures that
+        /// is rendered into, which is adjusted at run time when
+        /// m_dynamicResolution is set and is 1 otherwise.  Does not lock
+        /// the mutex.
+        float OSVR_RENDERMANAGER_EXPORT GetResolutionScale() const {
+            return m_resolutionScale;
+        }
+
         ///-------------------------------------------------------------
         /// Class that stores one of a set of possible distortion parameters.
         /// The type of parameters is determined by the m_type, and which
@@ -628,13 +750,40 @@ namespace renderkit {
                 m_bitsPerColor = 8;
 
                 m_renderOverfillFactor = 1.0f;
+                m_tightOverfill = false;
+                m_tightOverfillTimeWarpMargin = 0.05f;
                 m_renderOversampleFactor = 1.0f;
                 m_enableTimeWarp = true;
                 m_asynchronousTimeWarp = false;
                 m_maxMSBeforeVsyncTimeWarp = 3.0f;
+                m_adaptiveTimeWarpThreshold = false;
+                m_adaptiveTimeWarpMinMS = 1.0f;
+                m_adaptiveTimeWarpMaxMS = 8.0f;
+                m_adaptiveTimeWarpPercentile = 95.0f;
+                m_adaptiveTimeWarpMarginMS = 0.5f;
+                m_adaptiveTimeWarpWindow = 120;
+                m_dynamicResolution = false;
+                m_dynamicResolutionMinScale = 0.5f;
+                m_dynamicResolutionMaxScale = 1.0f;
+                m_dynamicResolutionTargetMS = 0.0f;
+                m_dynamicResolutionHeadroom = 0.15f;
+                m_dynamicResolutionStep = 0.05f;
+                m_dynamicResolutionHoldFrames = 15;
+                m_multiResolutionProfile = MultiResolution_Off;
+                m_multiResolutionCenterFraction = 0.6f;
+                m_multiResolutionBorderScale = 0.5f;
+                m_hiddenAreaDepthMask = false;
+                m_hiddenAreaDepthClearValue = 0.0f;
+                m_hiddenAreaTimeWarpMargin = 0.1f;
 
                 m_distortionCorrection = false;
 
+                m_synchronousGLErrorChecks = false;
+                m_renderTargetColorFormat = Color_Default;
+                m_renderTargetDepthFormat = Depth_Default;
+                m_renderTargetTextureArray = false;
+                m_parallelEyeRendering = false;
+
                 m_graphicsLibrary = GraphicsLibrary();
             }
             typedef enum {
@@ -643,6 +792,26 @@ namespace renderkit {
                 OneEighty,
                 TwoSeventy
             } Display_Rotation;
+            typedef enum {
+                Color_Default, //< 8-bit RGB, as before formats were selectable
+                Color_RGBA8,
+                Color_RGB10_A2,
+                Color_R11G11B10F,
+                Color_RGBA16F
+            } Render_Target_Color_Format;
+            typedef enum {
+                Depth_Default, //< Unsized; the driver picks (usually 24 bits)
+                Depth_16,
+                Depth_24,
+                Depth_32F
+            } Render_Target_Depth_Format;
+            typedef enum {
+                MultiResolution_Off, //< Render each eye at one resolution
+                MultiResolution_Conservative, //< 70% center, 3/4 borders
+                MultiResolution_Balanced,     //< 60% center, 1/2 borders
+                MultiResolution_Aggressive,   //< 50% center, 1/3 borders
+                MultiResolution_Custom //< From the two parameters below
+            } Multi_Resolution_Profile;
 
             bool m_directMode; //< Should we render using DirectMode?
 
@@ -687,6 +856,15 @@ namespace renderkit {
             /// render 4x as many pixels (2x in both X and Y).
             float m_renderOverfillFactor;
 
+            /// Size the overfill for each edge of each eye from the part of
+            /// the render texture that its distortion mesh samples, plus
+            /// m_tightOverfillTimeWarpMargin (a fraction of the screen's
+            /// width or height) on each edge when time warp is enabled,
+            /// in place of m_renderOverfillFactor.  See
+            /// ComputeTightOverfill().
+            bool m_tightOverfill;
+            float m_tightOverfillTimeWarpMargin; //< Margin for time warp
+
             /// This inreases the density of the render texture, adding more
             /// pixels within the texture, so that when it is rendered into
             /// the final buffer with distortion correction it can be
@@ -710,6 +888,113 @@ namespace renderkit {
             /// timewarp (requires enable)
             float m_maxMSBeforeVsyncTimeWarp;
 
+            /// Replace m_maxMSBeforeVsyncTimeWarp with a value derived from
+            /// the measured cost of presenting: the given percentile of the
+            /// present durations over the last m_adaptiveTimeWarpWindow
+            /// frames, plus m_adaptiveTimeWarpMarginMS, clamped to
+            /// [m_adaptiveTimeWarpMinMS, m_adaptiveTimeWarpMaxMS].  The
+            /// configured m_maxMSBeforeVsyncTimeWarp is used until the
+            /// window has enough samples.
+            bool m_adaptiveTimeWarpThreshold;
+            float m_adaptiveTimeWarpMinMS; //< Lower bound on the threshold
+            float m_adaptiveTimeWarpMaxMS; //< Upper bound on the threshold
+            float m_adaptiveTimeWarpPercentile; //< 0-100, which sample to use
+            float m_adaptiveTimeWarpMarginMS;   //< Added to the percentile
+            unsigned m_adaptiveTimeWarpWindow;  //< How many frames to track
+
+            /// Render each eye into a part of its texture whose size is
+            /// adjusted from frame to frame to hold the time taken by a
+            /// frame (from the end of one present to the end of the next,
+            /// less any time spent waiting for the time-warp threshold)
+            /// within m_dynamicResolutionTargetMS, which defaults to the
+            /// display's refresh interval.  The viewport
+            /// in each RenderInfo reports the part to render, starting at
+            /// the lower-left corner of a texture of the size it has when
+            /// the scale is 1 (the size reported before the first frame is
+            /// presented); presenting crops to the part that was rendered
+            /// when no cropping viewport is given for an eye.
+            ///   The scale (of each dimension) is reduced by
+            /// m_dynamicResolutionStep while the smoothed frame time is
+            /// above the target and increased by it while it is more than
+            /// m_dynamicResolutionHeadroom (a fraction of the target)
+            /// below it, waiting m_dynamicResolutionHoldFrames frames after
+            /// each change.
+            ///   It is turned off when presents wait for vertical sync
+            /// without time warp, since the wait then happens in the
+            /// driver and frames never measure shorter than the refresh
+            /// interval, so there would be no way to raise the scale.
+            bool m_dynamicResolution;
+            float m_dynamicResolutionMinScale; //< Smallest scale to use
+            float m_dynamicResolutionMaxScale; //< Largest scale, at most 1
+            float m_dynamicResolutionTargetMS; //< 0 to derive from timing
+            float m_dynamicResolutionHeadroom; //< Margin before growing
+            float m_dynamicResolutionStep;     //< Change per adjustment
+            unsigned m_dynamicResolutionHoldFrames; //< Frames between changes
+
+            /// Render the periphery of each eye, which lens distortion
+            /// shrinks when it is presented, at a lower resolution than the
+            /// center.  See GetNumRenderRegions().  The custom profile
+            /// renders the given fraction of each dimension of the eye at
+            /// full resolution, and the border around it with each
+            /// dimension scaled by m_multiResolutionBorderScale.
+            Multi_Resolution_Profile m_multiResolutionProfile;
+            float m_multiResolutionCenterFraction; //< Custom center, 0-1
+            float m_multiResolutionBorderScale;    //< Custom border scale, 0-1
+
+            /// Clear the depth buffer of each eye to
+            /// m_hiddenAreaDepthClearValue in the parts that are never seen
+            /// once distortion is corrected (see GetHiddenAreaMesh()),
+            /// after the view callback has been called, so that the
+            /// application's depth test rejects what it draws there.  Only
+            /// done by the OpenGL renderers, including the one that
+            /// presents through D3D11; Direct3D applications have to draw
+            /// the mesh from GetHiddenAreaMesh() themselves.
+            bool m_hiddenAreaDepthMask;
+            /// Depth to clear the hidden area to.  The default of 0 is the
+            /// near plane for a less or less-equal depth test; applications
+            /// that use reversed depth, with a greater test, need 1.
+            float m_hiddenAreaDepthClearValue;
+            /// Fraction of each dimension of the eye kept out of the hidden
+            /// area around the parts that the distortion mesh samples when
+            /// time warp is enabled, since it can bring them into view.
+            float m_hiddenAreaTimeWarpMargin;
+
+            /// OpenGL renderers normally have errors reported asynchronously
+            /// by a KHR_debug callback when the driver supports one.  This
+            /// diagnostic switch instead calls glGetError() after each step
+            /// of rendering, which pinpoints errors but stalls the pipeline.
+            bool m_synchronousGLErrorChecks;
+
+            /// If not empty, an existing directory where OpenGL renderers
+            /// keep the linked binaries of their shader programs, so that
+            /// later runs on the same driver can skip compiling them.
+            std::string m_programBinaryCacheDirectory;
+
+            /// Formats of the color and depth buffers that renderers which
+            /// allocate them (those used through Render()) create for each
+            /// eye.  Smaller formats reduce the bandwidth of rendering and
+            /// of reading the eyes back during distortion correction.  A
+            /// format the driver cannot render to is replaced by the
+            /// default, with a warning.
+            Render_Target_Color_Format m_renderTargetColorFormat;
+            Render_Target_Depth_Format m_renderTargetDepthFormat;
+
+            /// Allocate the eye color buffers as the layers of one
+            /// texture array, with a framebuffer per layer that is built
+            /// once, rather than as a texture per eye attached to a shared
+            /// framebuffer each time an eye is rendered.  Only used by the
+            /// OpenGL renderers, when all eyes are the same size.
+            bool m_renderTargetTextureArray;
+
+            /// Have Render() render each eye on its own thread, with its
+            /// own OpenGL context sharing objects with the application's.
+            /// The render callbacks for different eyes are then called at
+            /// the same time, from threads other than the one that called
+            /// Render(), with a context in which objects that OpenGL does
+            /// not share between contexts (vertex arrays and framebuffers)
+            /// are not available.  Only used by the OpenGL renderers.
+            bool m_parallelEyeRendering;
+
             OSVRDisplayConfiguration
                 m_displayConfiguration; //< Display configuration
 
@@ -736,6 +1021,8 @@ namespace renderkit {
         /// Compute the rendering info for all display surfaces based on the
         /// passed-in
         /// rendering parameters.  Store it internally for later retrieval.
+        /// Unlike LatchFrameRenderInfo(), this always updates the client
+        /// context and reads new poses.
         /// @return The number of stored RenderInfos, one per surface.
         virtual size_t OSVR_RENDERMANAGER_EXPORT
         LatchRenderInfo(const RenderParams& params = RenderParams());
@@ -746,6 +1033,105 @@ namespace renderkit {
         virtual RenderInfo OSVR_RENDERMANAGER_EXPORT
         GetRenderInfo(size_t index);
 
+        /// @brief Get the most-recently latched RenderInfo for all surfaces.
+        ///
+        /// The returned snapshot is never modified, so it stays consistent
+        /// while other threads latch new ones.  Does not block.
+        /// @return The snapshot, which is empty if nothing has been latched.
+        std::shared_ptr<const std::vector<RenderInfo> >
+            OSVR_RENDERMANAGER_EXPORT GetRenderInfoSnapshot();
+
+        /// @brief RenderInfo for all surfaces as latched for one frame.
+        struct FrameRenderInfo {
+            /// Number of frames that had been presented when this was
+            /// latched, which identifies the frame it is to be used for.
+            uint64_t frameId = 0;
+
+            /// When the frame is expected to be shown, which is the
+            /// vertical retrace after the next present would be made.
+            /// (0,0) if the RenderManager cannot report its timing.
+            OSVR_TimeValue predictedDisplayTime = {0, 0};
+
+            std::vector<RenderInfo> renderInfo; //< One per surface
+        };
+
+        /// @brief Get the RenderInfo for all surfaces for the current frame.
+        ///
+        /// The first call in each frame latches the render info, updating
+        /// the client context and reading the head pose.  Later calls in
+        /// the same frame never update it again: with the same parameters
+        /// they return that snapshot, and with different ones they get a
+        /// new snapshot made from the same head pose with their
+        /// parameters applied.  So every caller in a frame renders from
+        /// the same tracking data.  A frame ends when
+        /// PresentRenderBuffers() or Render() is called.  A call to
+        /// GetRenderInfo() or LatchRenderInfo() during the frame reads new
+        /// poses, which later calls to this one then share.
+        /// Also publishes the snapshot for GetRenderInfo(size_t).
+        /// @return The snapshot, which is never modified.  Its renderInfo
+        /// is empty on failure.
+        std::shared_ptr<const FrameRenderInfo> OSVR_RENDERMANAGER_EXPORT
+        LatchFrameRenderInfo(const RenderParams& params = RenderParams());
+
+        /// @brief Number of regions each eye is rendered in.
+        ///
+        /// This is 1 unless m_multiResolutionProfile is set.  Then, each
+        /// eye is split into a 3x3 grid of regions: a center rendered at
+        /// full resolution, with borders and corners around it rendered at
+        /// a lower resolution, all packed into a texture that is smaller
+        /// than the one for the whole eye at full resolution.  The
+        /// viewport in the eye's RenderInfo covers the packed texture.
+        /// The regions are to be rendered one at a time using
+        /// GetRenderRegion(); presenting puts them back together.  The
+        /// Render() path calls the render callbacks once per region.
+        size_t OSVR_RENDERMANAGER_EXPORT GetNumRenderRegions() const;
+
+        /// @brief Get the parameters for rendering one region of an eye.
+        ///
+        /// Fills in regionOut from the RenderInfo for the eye, with the
+        /// viewport and projection replaced by those of the region.  The
+        /// regions are numbered by row from the lower left of the view and
+        /// tile the eye's viewport.  With one region, this is the eye's
+        /// RenderInfo.
+        /// @return True on success, false if region is out of range.
+        bool OSVR_RENDERMANAGER_EXPORT GetRenderRegion(
+            const RenderInfo& eyeInfo, size_t region,
+            RenderInfo& regionOut) const;
+
+        /// Pixels rendered each frame, summed over all eyes, with one of
+        /// the multi-resolution profiles.
+        struct MultiResolutionPixelCounts {
+            ConstructorParameters::Multi_Resolution_Profile profile;
+            size_t fullPixels;     //< Without multi-resolution rendering
+            size_t renderedPixels; //< With the profile
+        };
+
+        /// @brief Report the pixels rendered with each multi-resolution
+        /// profile, including the custom one, for the displays in use and
+        /// a resolution scale of 1.
+        std::vector<MultiResolutionPixelCounts> OSVR_RENDERMANAGER_EXPORT
+        GetMultiResolutionPixelCounts();
+
+        /// @brief Get a mesh covering the parts of an eye that are never
+        /// seen once distortion is corrected.
+        ///
+        /// Fills in triangles (sets of three vertices) in coordinates
+        /// normalized to the eye's viewport, with (0,0) at the lower left
+        /// of the image and (1,1) at the upper right, so scaling them by 2
+        /// and subtracting 1 gives normalized device coordinates.  The
+        /// mesh is found from the distortion mesh and is conservative:
+        /// it covers whole cells of a coarse grid over the eye that are
+        /// never sampled, leaving a margin for time warp if it is on.
+        /// Applications can draw it into their depth or stencil buffer
+        /// before rendering so that those pixels are not shaded; only the
+        /// OpenGL renderers can do that for them (see
+        /// ConstructorParameters::m_hiddenAreaDepthMask).  It is
+        /// computed when the display is opened and again by
+        /// UpdateDistortionMeshes().
+        /// @return False if the eye does not have a distortion mesh yet.
+        bool OSVR_RENDERMANAGER_EXPORT
+        GetHiddenAreaMesh(size_t eye, std::vector<Float2>& triangles);
+
         //=============================================================
         // Destroy the existing distortion meshes and create new ones with the
         // given parameters.
@@ -783,16 +1169,86 @@ namespace renderkit {
         RenderManager(std::shared_ptr<osvr::clientkit::ClientContext> context,
                       const ConstructorParameters& p);
 
-        /// Mutex to provide thread safety to this class and its
-        /// subclasses.  NOTE: All subclasses must lock this mutex
-        /// for the duration of all public methods besides their
-        /// constructor.
+        /// Mutex that serializes graphics submission in this class and its
+        /// subclasses.  NOTE: All subclasses must lock this mutex for the
+        /// duration of all public methods besides their constructor, other
+        /// than those the class documentation lists as not waiting for
+        /// graphics submission.
         std::mutex m_mutex;
 
+        /// Mutex guarding the client context, the callback list and the
+        /// poses they update, so that render info can be computed while
+        /// another thread is presenting.  Held only briefly.  When both are
+        /// needed, m_mutex must be locked first.
+        std::mutex m_stateMutex;
+
+        /// @brief Poses read once per frame, from which the ModelView
+        /// transform for any eye and space is made with a single compose.
+        struct FramePoses {
+            /// Per eye: the inverse of worldFromRoom * roomFromHead *
+            /// headFromEye, and the same without worldFromRoom.
+            std::vector<OSVR_PoseState> eyeFromWorld;
+            std::vector<OSVR_PoseState> eyeFromRoom;
+
+            /// Per callback space.  Spaces with no interface are in world
+            /// space; the others are valid if their pose could be read.
+            struct Space {
+                bool inWorldSpace;
+                bool valid;
+                OSVR_PoseState roomFromSpace;
+            };
+            std::vector<Space> spaces;
+
+            /// The head pose read from the tracker, even when
+            /// RenderParams::roomFromHeadReplace was used instead of it.
+            OSVR_PoseState trackedRoomFromHead;
+        };
+
+        /// @brief Per-eye values that depend only on the display
+        /// configuration and on the IPD and clip planes, so that they need
+        /// not be recomputed every frame.  Read them with GetEyeTransforms().
+        struct EyeTransforms {
+            /// Frustum edges on a plane at unit distance from the eye,
+            /// including the center of projection and the overfill.
+            struct Frustum {
+                double left;
+                double right;
+                double top;
+                double bottom;
+            };
+            std::vector<Frustum> unitFrustum;
+
+            /// Overlap rotation and IPD offset, for IPDMeters.
+            std::vector<OSVR_PoseState> headFromEye;
+            double IPDMeters = 0;
+
+            /// Projections for the clip planes below; projectionsOkay is
+            /// false if ConstructProjection() failed for any eye.
+            std::vector<OSVR_ProjectionMatrix> projection;
+            bool projectionsOkay = false;
+            double nearClipDistanceMeters = 0;
+            double farClipDistanceMeters = 0;
+        };
+
         /// Internal versions of functions that require a mutex, so that
         /// we can call them from functions with a mutex without blocking.
-        virtual std::vector<RenderInfo>
-        GetRenderInfoInternal(const RenderParams& params = RenderParams());
+        ///  If framePoses is not null, the poses used to compute the render
+        /// info are stored there so that callback spaces can be rendered
+        /// from the same snapshot.
+        ///  The render info is stored into ret, reusing its storage.
+        /// @return True on success, false (with ret empty) on failure.
+        virtual bool
+        GetRenderInfoInternal(const RenderParams& params,
+                              std::vector<RenderInfo>& ret,
+                              FramePoses* framePoses = nullptr);
+
+        /// The part of GetRenderInfoInternal() after the client context
+        /// has been updated: reads the poses into framePoses and computes
+        /// the render info from them.  Must be called with m_stateMutex
+        /// locked.
+        bool ComputeRenderInfoLocked(const RenderParams& params,
+                                     std::vector<RenderInfo>& ret,
+                                     FramePoses& framePoses);
 
         virtual bool RegisterRenderBuffersInternal(
             const std::vector<RenderBuffer>& buffers,
@@ -814,8 +1270,148 @@ namespace renderkit {
                 distort //< Distortion parameters
             ) = 0;
 
-        std::vector<RenderInfo>
-            m_latchedRenderInfo; //< Stores vector of latched RenderInfo
+        /// Add the measured duration of one present (from the end of the
+        /// vsync wait to the end of PresentFrameFinalize(), less the time
+        /// reported to AddPresentBlockedTime()) to the sliding window and,
+        /// if adaptive time warp threshold is enabled, update
+        /// m_timeWarpThresholdMS from it.
+        void RecordPresentDuration(float ms);
+
+        /// Called by PresentDisplayFinalize() and PresentFrameFinalize()
+        /// implementations, with m_mutex locked, with the time spent in a
+        /// call that can block until vertical sync, such as a buffer swap.
+        /// That time depends on where in the refresh the present started
+        /// rather than on how much work it did, so it is left out of the
+        /// present duration; counted in, it would push the threshold up
+        /// to fill the refresh.
+        void AddPresentBlockedTime(std::chrono::steady_clock::duration t) {
+            m_presentBlocked += t;
+        }
+        std::chrono::steady_clock::duration
+            m_presentBlocked; //< Blocked time in the current present
+
+        std::vector<float>
+            m_presentDurationsMS; //< Sliding window of present durations
+        size_t m_nextPresentDuration; //< Next slot to fill in the window
+        std::vector<float>
+            m_presentDurationsSorted; //< Scratch for percentile selection
+        std::atomic<float>
+            m_timeWarpThresholdMS; //< Threshold before vsync in effect
+
+        /// Layout of each eye's texture when rendering at multiple
+        /// resolutions.  Along each axis, the boundaries between the lower
+        /// border, center and upper border are given as fractions of the
+        /// whole eye at full resolution (unpacked) and of the packed
+        /// texture.  Computed at construction and not changed after.
+        struct MultiResolutionLayout {
+            bool enabled = false;
+            double unpacked[2][4]; //< X and Y boundaries in the whole eye
+            double packed[2][4];   //< X and Y boundaries in the texture
+            double unpackedSize[2] = {0, 0}; //< Whole eye, in pixels
+            double packedSize[2] = {0, 0};   //< Packed texture, in pixels
+        };
+        MultiResolutionLayout m_multiResolution;
+
+        /// Compute the layout for a profile and the size of the whole eye.
+        /// @return True if the profile splits the eye into regions.
+        bool ComputeMultiResolutionLayout(
+            ConstructorParameters::Multi_Resolution_Profile profile,
+            double width, double height, MultiResolutionLayout& layout) const;
+
+        /// Are the viewports that the application renders with measured
+        /// from the top of the texture, as in Direct3D, rather than from
+        /// the bottom, as in OpenGL?  This depends on the library the
+        /// application renders with, not the one that presents, so the
+        /// OpenGL renderer that presents through Direct3D says no.
+        virtual bool ViewportOriginIsTop() const { return false; }
+
+        /// Piecewise-linear mapping, for the present shaders, from
+        /// coordinates in the whole eye to coordinates in the packed
+        /// texture, as X and Y pairs.  Below low, coordinates are scaled
+        /// by slopeLow; between low and high by slopeCenter, continuing
+        /// from there; above high by slopeHigh.
+        struct MultiResolutionRemap {
+            float low[2];
+            float high[2];
+            float slopeLow[2];
+            float slopeCenter[2];
+            float slopeHigh[2];
+        };
+        /// @return False if we are not rendering at multiple resolutions.
+        bool GetMultiResolutionRemap(MultiResolutionRemap& remap) const;
+
+        /// Record that a frame has finished presenting and, if
+        /// m_dynamicResolution is set, adjust the resolution scale from
+        /// the time since the previous one.  Called with m_mutex locked.
+        void RecordFramePresented();
+
+        /// Scale of each dimension of the eye viewports in effect.
+        std::atomic<float> m_resolutionScale;
+        /// Picks the scale, if m_dynamicResolution is set.  Accessed with
+        /// m_mutex locked.
+        std::unique_ptr<DynamicResolutionController> m_resolutionController;
+        /// Time the last present spent waiting for the time-warp
+        /// threshold.  Atomic because the asynchronous time-warp threads
+        /// present without m_mutex.
+        std::atomic<float> m_timeWarpWaitMS;
+
+        /// Most-recent RenderInfo published by LatchRenderInfo() or
+        /// LatchFrameRenderInfo().  Only accessed through
+        /// std::atomic_load() and std::atomic_store().
+        std::shared_ptr<const FrameRenderInfo> m_latchedRenderInfo;
+
+        /// Returns a snapshot buffer that nobody else holds, from
+        /// m_latchPool if there is one, so that latching does not allocate.
+        std::shared_ptr<FrameRenderInfo> takeLatchBuffer();
+
+        /// Snapshot buffers recycled by LatchRenderInfo(), guarded by
+        /// m_latchPoolLock.
+        static const size_t LATCH_POOL_SIZE = 4;
+        std::vector<std::shared_ptr<FrameRenderInfo> > m_latchPool;
+        std::mutex m_latchPoolLock;
+
+        /// Copy of the RenderParams that the latched snapshot was computed
+        /// with, holding the values of the poses they point to.
+        struct LatchedParams {
+            bool haveWorldFromRoom = false;
+            OSVR_PoseState worldFromRoom;
+            bool haveRoomFromHead = false;
+            OSVR_PoseState roomFromHead;
+            double nearClipDistanceMeters = 0;
+            double farClipDistanceMeters = 0;
+            double IPDMeters = 0;
+        };
+
+        /// Latches and publishes a new snapshot.  If sameFrame is null,
+        /// the client context is updated and the head pose read for a new
+        /// frame.  Otherwise, params are applied to the head pose read for
+        /// sameFrame, which must be the current frame's snapshot, without
+        /// updating the context.  Called with m_frameLatchLock locked.
+        std::shared_ptr<const FrameRenderInfo>
+        latchRenderInfoLocked(const RenderParams& params,
+                              const FrameRenderInfo* sameFrame = nullptr);
+
+        /// Serializes latching, so that only one caller latches each frame.
+        /// Guards m_latchedParams, m_frameLatchPoses and
+        /// m_frameRoomFromHead.
+        std::mutex m_frameLatchLock;
+        LatchedParams m_latchedParams;
+
+        /// Poses computed while latching, and the head pose read from the
+        /// tracker when the current frame was first latched.
+        FramePoses m_frameLatchPoses;
+        OSVR_PoseState m_frameRoomFromHead;
+
+        /// Number of frames presented, by PresentRenderBuffers() or Render().
+        std::atomic<uint64_t> m_frameCount;
+
+        /// Poses used by GetRenderInfoInternal() when the caller does not
+        /// want them, accessed with m_stateMutex locked.
+        FramePoses m_latchFramePoses;
+
+        /// Render info for the current poses, computed while presenting to
+        /// find the time warp.  Accessed with m_mutex locked.
+        std::vector<RenderInfo> m_presentRenderInfo;
 
         /// OSVR context to use.
         std::shared_ptr<osvr::clientkit::ClientContext> m_context;
@@ -861,6 +1457,8 @@ namespace renderkit {
             std::string m_interfaceName;
             OSVR_ClientInterface m_interface;
             RenderCallback m_callback;
+            StereoRenderCallback m_stereoCallback; //< Set instead of
+                                                   /// m_callback for stereo
             void* m_userData;
             OSVR_PoseState m_state;
         };
@@ -922,6 +1520,20 @@ namespace renderkit {
         /// the Present() rendering approach.
         RenderParams m_renderParamsForRender;
         std::vector<RenderInfo> m_renderInfoForRender;
+        FramePoses m_renderFramePoses;
+
+        /// Cache returned by GetEyeTransforms(), accessed with m_stateMutex
+        /// locked.  The frusta are built at construction and rebuilt by
+        /// GetEyeTransforms() when m_eyeTransformsValid is cleared by
+        /// InvalidateEyeTransforms().
+        EyeTransforms m_eyeTransforms;
+        bool m_eyeTransformsValid = false;
+
+        /// Per-eye arrays handed to stereo render callbacks, kept so that
+        /// they are not reallocated every frame.
+        std::vector<OSVR_ViewportDescription> m_stereoViewports;
+        std::vector<OSVR_PoseState> m_stereoPoses;
+        std::vector<OSVR_ProjectionMatrix> m_stereoProjections;
 
         /// @brief Use current and previous values above to compute ATWs for
         /// each eye.
@@ -963,10 +1575,10 @@ namespace renderkit {
         /// translation impact.
         ///  @return True on success, false (with empty transforms vector) on
         /// failure.
-        virtual bool
-        ComputeAsynchronousTimeWarps(std::vector<RenderInfo> usedRenderInfo,
-                                     std::vector<RenderInfo> currentRenderInfo,
-                                     float assumedDepth = 2.0f);
+        virtual bool ComputeAsynchronousTimeWarps(
+            const std::vector<RenderInfo>& usedRenderInfo,
+            const std::vector<RenderInfo>& currentRenderInfo,
+            float assumedDepth = 2.0f);
 
         /// Asynchronous time warp matrices suitable for use in OpenGL,
         /// taking (-0.5,-0.5) to (0.5,0.5) coordinates into the appropriate new
@@ -994,7 +1606,10 @@ namespace renderkit {
 
         /// @brief Fill in a projection transform for a given eye
         /// This routine computes the projection matrix needed for the
-        /// oversized view required by the m_renderOverfillFactor.
+        /// oversized view required by the eye's overfill margins, by
+        /// scaling the cached unit frustum for the eye.  Does not rebuild
+        /// the frusta, so it can be called without m_stateMutex unless
+        /// InvalidateEyeTransforms() is in use.
         /// @return True on success, false on failure.
         virtual bool ConstructProjection(
             size_t whichEye //< Input; index of the eye to use
@@ -1007,7 +1622,7 @@ namespace renderkit {
 
         /// @brief Fill in the viewport for a given eye on the Render path
         /// This routine computes the viewport size with the
-        /// amount needed by the m_renderOverfillFactor and the
+        /// amount needed by the eye's overfill margins and the
         /// m_renderOversampleFactor.  It also
         /// does not include the shift needed to move the eye to the
         /// correct location in the output display.
@@ -1019,7 +1634,7 @@ namespace renderkit {
 
         /// @brief Fill in the viewport for a given eye on the Present path
         /// This routine computes the viewport size without the
-        /// amount needed by the m_renderOverfillFactor or the
+        /// amount needed by the overfill margins or the
         /// m_renderOversampleFactor; if these
         /// is required, they should be added by the caller.  It also
         /// always includes the shift needed to move the eye to the
@@ -1048,6 +1663,8 @@ namespace renderkit {
 
         /// @brief Construct ModelView for a given eye, space, and RenderParams
         ///
+        /// Reads the current poses.  Rendering instead reads them once per
+        /// frame with ConstructFramePoses() and uses ComposeModelView().
         /// @return True on success, false on failure.
         virtual bool ConstructModelView(
             size_t whichSpace //< Input; index of the space to use
@@ -1057,6 +1674,66 @@ namespace renderkit {
                 eyeFromSpace //< Output info needed to make ModelView
             );
 
+        /// @brief Return the cached per-eye transforms, recomputing the
+        /// parts that depend on the IPD or the clip planes if they differ
+        /// from the ones in params.  Must be called with m_stateMutex
+        /// locked; the reference is valid until the next call.
+        const EyeTransforms& GetEyeTransforms(const RenderParams& params);
+
+        /// @brief Compute the unit frusta for all eyes from the display
+        /// configuration and mark the cache as valid.
+        void ConstructUnitFrusta();
+
+        /// How far each eye's render texture extends past each edge of
+        /// the screen, as fractions of the screen's width and height.
+        struct OverfillMargins {
+            double left;
+            double right;
+            double bottom;
+            double top;
+        };
+
+        /// @brief The overfill margins for an eye: those found by
+        /// ComputeTightOverfill() if it succeeded, otherwise half of the
+        /// extra size from m_renderOverfillFactor on every edge.
+        OverfillMargins GetOverfillMargins(size_t eye) const;
+
+        /// @brief Find tight overfill margins for each eye if
+        /// m_tightOverfill is set.  Builds each eye's distortion mesh with
+        /// no overfill, whose texture coordinates are then in the space
+        /// of the screen, and takes the bounds of what it samples.  All
+        /// eyes are given the same render-texture size, by growing the
+        /// margins of the smaller ones evenly.  Called at construction.
+        void ComputeTightOverfill();
+
+        /// Per-eye margins from ComputeTightOverfill(), empty if it was
+        /// not used.  Not changed after construction.
+        std::vector<OverfillMargins> m_overfillMargins;
+
+        /// @brief Make the next GetEyeTransforms() rebuild everything.
+        /// Call this after changing any of m_params that they depend on,
+        /// such as the overfill factor.  Must be called with m_stateMutex
+        /// locked.
+        void InvalidateEyeTransforms() { m_eyeTransformsValid = false; }
+
+        /// @brief Read the head and callback-space poses and compute the
+        /// per-eye transforms for one frame.  Must be called with
+        /// m_stateMutex locked, after the client context has been updated.
+        void ConstructFramePoses(const RenderParams& params,
+                                 FramePoses& poses);
+
+        /// @brief Construct the ModelView for a given eye and space from
+        /// poses made by ConstructFramePoses().  Does not read any state.
+        /// @return True on success, false if the eye is out of range or
+        /// the space's pose could not be read.
+        bool ComposeModelView(
+            const FramePoses& poses //< Input; poses for this frame
+            , size_t whichSpace //< Input; index of the space to use
+            , size_t whichEye //< Input; index of the eye to use
+            , OSVR_PoseState&
+                eyeFromSpace //< Output info needed to make ModelView
+            ) const;
+
         /// @brief Compute in-display rotations/flip matrix.
         ///  Assumes that it is starting in a world-space quad render that has
         /// (-1,-1) at the lower left corner of the screen and (1,1) at the
@@ -1196,6 +1873,10 @@ namespace renderkit {
         /// when it is using an unstructured grid.
         std::vector<UnstructuredMeshInterpolator *> m_interpolators;
 
+        /// Guards m_interpolators, so that meshes can be computed without
+        /// holding m_mutex.
+        std::mutex m_interpolatorMutex;
+
         /// @brief Distortion-correct a texture coordinate in PresentMode
         ///  Takes a texture coordinate that is specified in the coordinate
         /// system of a Presented texture for a given eye, which has (0,0)
@@ -1260,6 +1941,51 @@ namespace renderkit {
             , DistortionParameters distort //< Distortion parameters
             );
 
+        /// @brief Get the distortion mesh for an eye from within
+        /// UpdateDistortionMeshesInternal().
+        ///
+        /// Returns the mesh precomputed by UpdateDistortionMeshes() if it
+        /// was computed for this type and parameter vector, and otherwise
+        /// calls ComputeDistortionMesh().  Also updates the eye's hidden
+        /// area from the mesh.  Call with m_mutex locked.
+        std::vector<DistortionMeshVertex> GetDistortionMesh(
+            size_t eye //< Which eye?
+            , DistortionMeshType type //< Type of mesh to produce
+            , std::vector<DistortionParameters> const&
+                distort //< Distortion parameters for all eyes
+            );
+
+        /// @brief Do these parameters describe no distortion at all?
+        /// True for polynomials that leave the radius unchanged, such as
+        /// the default-constructed parameters, whose mesh maps each
+        /// texture coordinate to itself.
+        static bool DistortionIsIdentity(const DistortionParameters& distort);
+
+        /// @brief Meshes that UpdateDistortionMeshes() computed before
+        /// calling UpdateDistortionMeshesInternal().  Accessed with
+        /// m_mutex locked.
+        struct {
+            std::vector<DistortionParameters> const* distort = nullptr;
+            DistortionMeshType type = SQUARE;
+            std::vector<std::vector<DistortionMeshVertex> > meshes;
+        } m_precomputedMeshes;
+
+        /// Number of cells along each side of the grid over the eye used
+        /// to find the parts that are never sampled.
+        static const int HIDDEN_AREA_GRID_SIZE = 64;
+
+        /// @brief Find the parts of an eye that a distortion mesh never
+        /// samples, as rectangles normalized to the eye's viewport.
+        void ComputeHiddenArea(const std::vector<DistortionMeshVertex>& mesh,
+                               std::vector<OSVR_ViewportDescription>& rects);
+
+        /// Rectangles of each eye that are never sampled, normalized to
+        /// its viewport.  Guarded by m_hiddenAreaLock, which is never held
+        /// while locking another mutex, so that they can be read from
+        /// within render callbacks.
+        std::vector<std::vector<OSVR_ViewportDescription> > m_hiddenAreas;
+        std::mutex m_hiddenAreaLock;
+
         //=============================================================
         // These methods must be implemented by all derived classes.
         //  They enable the Render() method above to do the generic work
@@ -1290,6 +2016,15 @@ namespace renderkit {
         virtual bool RenderEyeInitialize(size_t eye //< Which eye (0-indexed)
                                          ) = 0;
 
+        /// @brief Mask off the parts of an eye that are never seen, if
+        /// m_hiddenAreaDepthMask is set.  Called after the view callback,
+        /// which is where applications clear their buffers.  The default
+        /// does nothing; only the OpenGL renderers implement it.
+        virtual bool RenderEyeHiddenArea(size_t eye //< Which eye (0-indexed)
+                                         ) {
+            return true;
+        }
+
         /// @brief Render objects in a specified space (from m_callbacks)
         virtual bool
         RenderSpace(size_t whichSpace //< Index into m_callbacks vector
@@ -1311,6 +2046,56 @@ namespace renderkit {
         /// @brief Finalize rendering for a new frame
         virtual bool RenderFrameFinalize() { return true; }
 
+        /// @brief Render all of the eyes on a display, between its
+        /// RenderDisplayInitialize() and RenderDisplayFinalize().  The
+        /// default calls RenderEye() for each in turn on this thread;
+        /// renderers that can render eyes concurrently override it to call
+        /// RenderEye() for several eyes at once, from other threads.
+        virtual bool
+        RenderDisplayEyes(size_t display //< Which display (0-indexed)
+                          , const RenderParams& params //< Passed to Render()
+                          , bool stereoPerEye //< Passed on to RenderEye()
+                          );
+
+        /// @brief Everything Render() does for one eye, from
+        /// RenderEyeInitialize() to RenderEyeFinalize(), including calling
+        /// the render callbacks.  Safe to call for different eyes at the
+        /// same time if the renderer's per-eye methods are.
+        bool RenderEye(size_t eye //< Which eye (0-indexed)
+                       , const RenderParams& params //< Passed to Render()
+                       , bool stereoPerEye //< Call stereo callbacks too?
+                       );
+
+        //=============================================================
+        // Renderers that can draw all eyes in one pass override these to
+        // handle stereo render callbacks.  If CanRenderStereo() is true,
+        // they are called after the displays have been rendered and
+        // before RenderFrameFinalize():
+        //  RenderStereoInitialize
+        //      RenderStereoSpace
+        //  RenderStereoFinalize
+        // Otherwise, RenderStereoSpace is called for each eye with a
+        // single eye, after that eye's RenderSpace calls.
+
+        /// @brief Can all eyes be rendered at once?
+        virtual bool CanRenderStereo() { return false; }
+
+        /// @brief Set up a render target holding all eyes
+        virtual bool RenderStereoInitialize() { return true; }
+
+        /// @brief Render objects in a specified space (from m_callbacks)
+        /// for the given eyes.  The default calls the stereo callback.
+        virtual bool RenderStereoSpace(
+            size_t whichSpace //< Index into m_callbacks vector
+            , size_t numEyes //< How many eyes are we rendering for?
+            , const OSVR_PoseState* poses //< ModelView for each eye
+            , const OSVR_ViewportDescription* viewports //< For each eye
+            , const OSVR_ProjectionMatrix* projections //< For each eye
+            );
+
+        /// @brief Finalize rendering to the target holding all eyes
+        virtual bool RenderStereoFinalize() { return true; }
+
         //=============================================================
         // These methods must be implemented by all derived classes.
         // They enable the PresentRenderBuffers() method above to do the
@@ -1367,6 +2152,44 @@ namespace renderkit {
         };
         virtual bool PresentEye(PresentEyeParameters params) = 0;
 
+        /// @brief Present-path state for an eye that depends only on the
+        /// configuration and on the parameters passed to PresentEye(), not
+        /// on the poses, so that it can be reused from frame to frame.
+        /// The matrices are in OpenGL (column-major) order.
+        struct PresentEyeTransforms {
+            OSVR_ViewportDescription viewport; //< Rotated display viewport
+            matrix16 projection; //< Undoes the render overfill margins
+            matrix16 modelView;  //< Display rotation and flip in Y
+            matrix16 crop; //< Texture matrix without asynchronous time warp
+        };
+
+        /// @brief Get the present-path state for an eye, computing it only
+        /// on the first present for that eye or when the rotation, flip,
+        /// eye swap or cropping viewport differ from the last present.
+        ///  Called by PresentEye() implementations, with m_mutex locked.
+        /// @return nullptr on failure.
+        const PresentEyeTransforms*
+        GetPresentEyeTransforms(const PresentEyeParameters& params,
+                                bool swapEyes //< Swap left and right eyes?
+                                );
+
+        /// @brief Discard the state cached by GetPresentEyeTransforms().
+        /// Must be called, with m_mutex locked, after changing any of the
+        /// configuration that it depends on.
+        void InvalidatePresentEyeTransforms();
+
+        /// Cached PresentEyeTransforms, one per eye, along with the
+        /// parameters they were computed from.
+        struct CachedPresentEyeTransforms {
+            bool valid = false;
+            double rotateDegrees;
+            bool flipInY;
+            bool swapEyes;
+            OSVR_ViewportDescription normalizedCroppingViewport;
+            PresentEyeTransforms transforms;
+        };
+        std::vector<CachedPresentEyeTransforms> m_presentEyeTransforms;
+
         /// @brief Finalize presentation for a new display
         virtual bool
         PresentDisplayFinalize(size_t display //< Which display (0-indexed)
@@ -0,0 +1,194 @@
+/** @file
+@brief Source file implementing the graphics-library-independent scheduling
+logic for asynchronous time warp
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "RenderManagerATWScheduler.h"
+
+// Standard includes
+#include <thread>
+
+/// Convert an OSVR time value into a std::chrono duration.
+static osvr::renderkit::ATWScheduler::Clock::duration
+timeValueToDuration(const OSVR_TimeValue& tv) {
+    return std::chrono::duration_cast<
+        osvr::renderkit::ATWScheduler::Clock::duration>(
+        std::chrono::seconds(tv.seconds) +
+        std::chrono::microseconds(tv.microseconds));
+}
+
+namespace osvr {
+namespace renderkit {
+
+    const float ATWScheduler::DEFAULT_THRESHOLD_MS = 1.0f;
+
+    ATWScheduler::ATWScheduler(Hooks hooks)
+        : m_hooks(hooks), m_haveFrame(false), m_droppedFrames(0) {
+        if (!m_hooks.now) {
+            m_hooks.now = []() { return Clock::now(); };
+        }
+        if (!m_hooks.sleepUntil) {
+            // Operating-system sleeps can overshoot by a millisecond or
+            // more, so we sleep most of the way and yield the rest.
+            m_hooks.sleepUntil = [](Clock::time_point when) {
+                auto coarse = when - std::chrono::milliseconds(2);
+                if (Clock::now() < coarse) {
+                    std::this_thread::sleep_until(coarse);
+                }
+                while (Clock::now() < when) {
+                    std::this_thread::yield();
+                }
+            };
+        }
+    }
+
+    bool ATWScheduler::submit(Frame frame) {
+        m_frames.writeBuffer() = std::move(frame);
+        return submit();
+    }
+
+    ATWScheduler::Frame& ATWScheduler::nextFrame() {
+        return m_frames.writeBuffer();
+    }
+
+    bool ATWScheduler::submit() {
+        Frame& frame = m_frames.writeBuffer();
+        frame.index = m_nextIndex++;
+        frame.submitTime = m_hooks.now();
+        bool replaced = m_frames.publish();
+
+        // The frame is only announced once it has been published, so that
+        // tick() never presents the empty frame the buffer starts with.
+        m_haveFrame.store(true, std::memory_order_release);
+
+        // If the frame we replaced was never taken, it is dropped.
+        if (!replaced) {
+            return false;
+        }
+        m_droppedFrames++;
+        return true;
+    }
+
+    bool ATWScheduler::hasFrame() {
+        return m_haveFrame.load(std::memory_order_acquire);
+    }
+
+    ATWScheduler::Statistics ATWScheduler::getStatistics() {
+        std::lock_guard<std::mutex> lock(m_statsLock);
+        Statistics ret = m_stats;
+        ret.droppedFrames = m_droppedFrames.load();
+        return ret;
+    }
+
+    ATWScheduler::TickResult ATWScheduler::tick() {
+        if (!hasFrame()) {
+            m_hooks.sleepUntil(m_hooks.now() + std::chrono::milliseconds(1));
+            return IDLE;
+        }
+
+        // Wait until we're within the threshold of the next vertical
+        // retrace.  We use the timing info from the first display.
+        // @todo Need one thread per display if we have displays that are
+        // not gen-locked.
+        RenderTimingInfo timing;
+        bool haveTiming = m_hooks.getTimingInfo && m_hooks.getTimingInfo(timing);
+        Clock::duration untilRetrace = Clock::duration::zero();
+        if (haveTiming) {
+            float thresholdMS =
+                m_hooks.getThresholdMS ? m_hooks.getThresholdMS() : 0;
+            if (thresholdMS <= 0) {
+                thresholdMS = DEFAULT_THRESHOLD_MS;
+            }
+            Clock::duration threshold =
+                std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<float, std::milli>(thresholdMS));
+            untilRetrace =
+                timeValueToDuration(timing.hardwareDisplayInterval) -
+                timeValueToDuration(timing.timeSincelastVerticalRetrace);
+            if (untilRetrace > threshold) {
+                m_hooks.sleepUntil(m_hooks.now() + (untilRetrace - threshold));
+                untilRetrace = threshold;
+            }
+        }
+
+        // Take the newest frame and present it, holding the renderer's lock
+        // if we were given one.  The frame we take is ours until the next
+        // take(), so the application can keep submitting in the meantime.
+        // If the renderer finds that the application has already moved on
+        // from it, the newer frame has been published by then, so we take
+        // that one and present it within this same refresh.
+        Clock::time_point start = m_hooks.now();
+        bool isNew;
+        uint64_t superseded = 0;
+        PresentResult result;
+        {
+            std::unique_lock<std::mutex> presentLock;
+            if (m_hooks.presentLock) {
+                presentLock = std::unique_lock<std::mutex>(*m_hooks.presentLock);
+            }
+            isNew = m_frames.take();
+            result = m_hooks.present(m_frames.readBuffer());
+            while (result == PRESENT_SUPERSEDED) {
+                superseded++;
+                if (!m_frames.take()) {
+                    break;
+                }
+                isNew = true;
+                result = m_hooks.present(m_frames.readBuffer());
+            }
+        }
+        if (result == PRESENT_FAILED) {
+            return FAILED;
+        }
+        if (result == PRESENT_SUPERSEDED) {
+            std::lock_guard<std::mutex> lock(m_statsLock);
+            m_stats.supersededFrames += superseded;
+            return SKIPPED;
+        }
+        const Frame& frame = m_frames.readBuffer();
+        Clock::time_point end = m_hooks.now();
+        if (m_hooks.afterPresent) {
+            m_hooks.afterPresent();
+        }
+
+        std::lock_guard<std::mutex> lock(m_statsLock);
+        m_stats.supersededFrames += superseded;
+        m_stats.presents++;
+        if (isNew) {
+            m_stats.newFrames++;
+            m_stats.lastLatency = end - frame.submitTime;
+            if (m_stats.lastLatency > m_stats.maxLatency) {
+                m_stats.maxLatency = m_stats.lastLatency;
+            }
+        } else {
+            m_stats.repeatedFrames++;
+        }
+        if (haveTiming && (end - start > untilRetrace)) {
+            m_stats.missedDeadlines++;
+        }
+        return PRESENTED;
+    }
+
+} // namespace renderkit
+} // namespace osvr
@@ -0,0 +1,178 @@
+/** @file
+@brief Header file describing the graphics-library-independent scheduling
+logic for asynchronous time warp
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Internal Includes
+#include "RenderManager.h"
+#include "TripleBuffer.h"
+
+// Standard includes
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace osvr {
+namespace renderkit {
+
+    /// @brief Decides when an asynchronous time warp thread re-presents,
+    /// and with which frame.
+    ///
+    /// This holds the parts of asynchronous time warp that do not depend on
+    /// the graphics library: keeping the latest frame handed over by the
+    /// application, waiting until the time-warp threshold before the next
+    /// vertical retrace, presenting the newest frame (or re-presenting the
+    /// previous one if the application has not delivered a new one), and
+    /// keeping statistics on latency and missed retraces.
+    ///  Everything it needs from the outside world (the clock, sleeping,
+    /// display timing, the threshold and the present itself) is passed in
+    /// as Hooks, so that it can be driven by a simulated clock and a
+    /// software present sink as well as by a real renderer.
+    ///  The owner runs its own thread and calls tick() in a loop from it.
+    /// Frames are handed over through a TripleBuffer, so submit() never
+    /// waits for a present that is in progress.
+    class ATWScheduler {
+      public:
+        typedef std::chrono::steady_clock Clock;
+
+        /// Frame handed from the application to the ATW thread.
+        struct Frame {
+            std::vector<RenderBuffer> renderBuffers;
+            std::vector<RenderInfo> renderInfo;
+            std::vector<OSVR_ViewportDescription> normalizedCroppingViewports;
+            RenderManager::RenderParams renderParams;
+            bool flipInY = false;
+
+            uint64_t index = 0;        //< Filled in by submit(), from 1
+            Clock::time_point submitTime; //< Filled in by submit()
+        };
+
+        /// What happened when the present hook was called.
+        typedef enum {
+            PRESENT_DONE,       //< The frame was presented
+            PRESENT_SUPERSEDED, //< A newer frame was submitted before the
+                                //  hook could present this one, so it
+                                //  presented nothing
+            PRESENT_FAILED      //< Presenting failed
+        } PresentResult;
+
+        /// Connections to the renderer and the system.  The present hook
+        /// is required; defaults are used for now and sleepUntil if they
+        /// are empty.  If getTimingInfo is empty or fails, frames are
+        /// presented as fast as present returns, which is paced by vsync
+        /// when that is enabled.
+        struct Hooks {
+            std::function<Clock::time_point()> now;
+            std::function<void(Clock::time_point)> sleepUntil;
+            std::function<bool(RenderTimingInfo&)> getTimingInfo;
+            std::function<float()> getThresholdMS;
+            std::function<PresentResult(const Frame&)> present;
+
+            /// Called after present, once presentLock has been released.
+            std::function<void()> afterPresent;
+
+            /// If non-null, locked while the frame to present is picked and
+            /// presented.  Renderers that submit() while holding the same
+            /// lock are guaranteed that a superseded frame is never
+            /// presented after submit() returns, at the cost of submit()
+            /// waiting for any present in progress.  Renderers that can
+            /// tell when they have moved on to a new frame, and report
+            /// PRESENT_SUPERSEDED for the old one, should leave this null.
+            std::mutex* presentLock = nullptr;
+        };
+
+        /// Counters describing how the scheduler has been doing.
+        struct Statistics {
+            uint64_t presents = 0;        //< Calls to the present hook
+            uint64_t newFrames = 0;       //< Presents of a not-yet-seen frame
+            uint64_t repeatedFrames = 0;  //< Re-presents of an older frame
+            uint64_t missedDeadlines = 0; //< Presents that ran past retrace
+            uint64_t droppedFrames = 0;   //< Frames never presented
+            uint64_t supersededFrames = 0; //< Presents given up on because
+                                           //  the frame had been replaced
+            Clock::duration lastLatency = Clock::duration::zero();
+            Clock::duration maxLatency = Clock::duration::zero();
+        };
+
+        typedef enum {
+            IDLE,      //< No frame has been submitted yet
+            PRESENTED, //< The latest frame was presented
+            SKIPPED,   //< The frame taken was superseded before it could be
+                       //  presented and no newer one had been published
+            FAILED     //< The present hook failed
+        } TickResult;
+
+        explicit ATWScheduler(Hooks hooks);
+
+        /// Hand a new frame to the scheduler, replacing any that has not
+        /// yet been presented.  Does not block.  Only one thread at a time
+        /// may call this.
+        /// @return True if a frame that was never presented was replaced.
+        bool submit(Frame frame);
+
+        /// The frame that the no-argument submit() hands over.  It holds
+        /// an older frame, so assigning into its members reuses their
+        /// storage rather than allocating.  Only the thread that submits
+        /// may use it.
+        Frame& nextFrame();
+
+        /// Hand over nextFrame(), as above.
+        bool submit();
+
+        /// Has any frame been submitted?
+        bool hasFrame();
+
+        /// Wait until it is time to present, then present the most-recently
+        /// submitted frame.  Returns immediately (after a short sleep) if
+        /// no frame has been submitted.  If the present hook reports that
+        /// the frame was superseded, the newer frame is taken and
+        /// presented straight away, without waiting for another retrace.
+        /// Only one thread at a time may call this.
+        TickResult tick();
+
+        /// Returns a copy of the statistics.  Thread-safe.
+        Statistics getStatistics();
+
+        /// How long before vsync we present if we're not given a
+        /// threshold; gives us some time to swap things out.
+        static const float DEFAULT_THRESHOLD_MS;
+
+      private:
+        Hooks m_hooks;
+
+        TripleBuffer<Frame> m_frames;
+        std::atomic<bool> m_haveFrame;
+        uint64_t m_nextIndex = 1; //< Only touched by submit()
+
+        std::mutex m_statsLock; //< Guards m_stats
+        Statistics m_stats;
+        std::atomic<uint64_t> m_droppedFrames; //< Counted by submit()
+    };
+
+} // namespace renderkit
+} // namespace osvr
@@ -45,9 +45,14 @@ Russ Taylor working through ReliaSolve.com for Sensics, Inc.
 
 #ifdef RM_USE_OPENGL
 #include "RenderManagerOpenGL.h"
+#ifndef RM_USE_OPENGLES20
+#include "RenderManagerOpenGLATW.h"
+#endif
 #endif
 
 #include "VendorIdTools.h"
+#include "RenderKitPoseMath.h"
+#include "RenderManagerDynamicResolution.h"
 
 // OSVR Includes
 #include <osvr/ClientKit/InterfaceStateC.h>
@@ -143,37 +148,8 @@ static double interpolate(double p1X, double p1Y, double val1, double p2X,
     return -(ABC[0] * pointX + ABC[1] * pointY + D) / ABC[2];
 }
 
-/// @brief Static helper function to make the identity xform
-/// @todo Remove this once we use Eigen code below.
-static void makeIdentity(q_xyz_quat_type& xform) {
-    xform.xyz[Q_X] = xform.xyz[Q_Y] = xform.xyz[Q_Z] = 0;
-    xform.quat[Q_X] = xform.quat[Q_Y] = xform.quat[Q_Z] = 0;
-    xform.quat[Q_W] = 1;
-}
-
-/// @brief Static helper function to make the identity xform
-/// @todo Remove this once we use Eigen code below.
-static void q_from_OSVR(q_xyz_quat_type& xform, const OSVR_PoseState& pose) {
-    xform.xyz[Q_X] = pose.translation.data[0];
-    xform.xyz[Q_Y] = pose.translation.data[1];
-    xform.xyz[Q_Z] = pose.translation.data[2];
-    xform.quat[Q_X] = osvrQuatGetX(&pose.rotation);
-    xform.quat[Q_Y] = osvrQuatGetY(&pose.rotation);
-    xform.quat[Q_Z] = osvrQuatGetZ(&pose.rotation);
-    xform.quat[Q_W] = osvrQuatGetW(&pose.rotation);
-}
-
-/// @brief Static helper function to make the identity xform
-/// @todo Remove this once we use Eigen code below.
-static void OSVR_from_q(OSVR_PoseState& pose, const q_xyz_quat_type& xform) {
-    pose.translation.data[0] = xform.xyz[Q_X];
-    pose.translation.data[1] = xform.xyz[Q_Y];
-    pose.translation.data[2] = xform.xyz[Q_Z];
-    osvrQuatSetX(&pose.rotation, xform.quat[Q_X]);
-    osvrQuatSetY(&pose.rotation, xform.quat[Q_Y]);
-    osvrQuatSetZ(&pose.rotation, xform.quat[Q_Z]);
-    osvrQuatSetW(&pose.rotation, xform.quat[Q_W]);
-}
+/// @brief Poses are composed in double precision to match OSVR_PoseState.
+typedef osvr::renderkit::posemath::Pose<double> Pose;
 
 namespace osvr {
 namespace renderkit {
@@ -187,6 +163,43 @@ namespace renderkit {
         // initialization if they are re-ordered in the header file.
         m_params = p;
 
+        /// Start out using the configured time-warp threshold, kept within
+        /// the adaptive bounds if we'll be adjusting it later.
+        m_nextPresentDuration = 0;
+        m_presentBlocked = std::chrono::steady_clock::duration::zero();
+        float threshold = m_params.m_maxMSBeforeVsyncTimeWarp;
+        if (m_params.m_adaptiveTimeWarpThreshold) {
+            threshold = std::max(threshold, m_params.m_adaptiveTimeWarpMinMS);
+            threshold = std::min(threshold, m_params.m_adaptiveTimeWarpMaxMS);
+        }
+        m_timeWarpThresholdMS = threshold;
+        m_frameCount = 0;
+
+        /// Dynamic resolution needs to see how long frames take, which it
+        /// can't when presents wait for vertical sync in the driver.
+        m_resolutionScale = 1.0f;
+        m_timeWarpWaitMS = 0;
+        if (m_params.m_dynamicResolution && m_params.m_verticalSync &&
+            !m_params.m_asynchronousTimeWarp &&
+            !(m_params.m_enableTimeWarp && threshold > 0)) {
+            std::cerr << "RenderManager::RenderManager: Dynamic resolution "
+                         "needs time warp when vertical sync is on, "
+                         "disabling it"
+                      << std::endl;
+            m_params.m_dynamicResolution = false;
+        }
+        if (m_params.m_dynamicResolution) {
+            DynamicResolutionController::Settings settings;
+            settings.minScale = m_params.m_dynamicResolutionMinScale;
+            settings.maxScale = m_params.m_dynamicResolutionMaxScale;
+            settings.headroom = m_params.m_dynamicResolutionHeadroom;
+            settings.step = m_params.m_dynamicResolutionStep;
+            settings.holdFrames = m_params.m_dynamicResolutionHoldFrames;
+            m_resolutionController.reset(
+                new DynamicResolutionController(settings));
+            m_resolutionScale = m_resolutionController->scale();
+        }
+
         /// Clear the callback for display, so it will
         /// not be present until set
         m_displayCallback.m_callback = nullptr;
@@ -217,9 +230,25 @@ namespace renderkit {
             throw std::runtime_error("Can't get head interface.");
         }
         osvrPose3SetIdentity(&m_roomFromHead);
+        osvrPose3SetIdentity(&m_frameRoomFromHead);
 
         // We haven't yet registered our render buffers, so can't present them
         m_renderBuffersRegistered = false;
+
+        // Size the overfill from the distortion if asked to, which sets
+        // the size of each eye, and then build the unit frusta from it
+        // before any other thread can ask for a projection.
+        ComputeTightOverfill();
+        ConstructUnitFrusta();
+
+        // Work out how the regions of each eye are packed if we're
+        // rendering at multiple resolutions, from the size of a whole eye.
+        OSVR_ViewportDescription eyeViewport;
+        if (ConstructViewportForRender(0, eyeViewport)) {
+            ComputeMultiResolutionLayout(m_params.m_multiResolutionProfile,
+                                         eyeViewport.width, eyeViewport.height,
+                                         m_multiResolution);
+        }
     }
 
     bool RenderManager::SetDisplayCallback(DisplayCallback callback,
@@ -269,6 +298,7 @@ namespace renderkit {
         // All public methods that use internal state should be guarded
         // by a mutex.
         std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
 
         // Make sure we have valid data
         if (callback == nullptr) {
@@ -282,6 +312,7 @@ namespace renderkit {
         // pose be the identity pose until we hear otherwise.
         RenderCallbackInfo cb;
         cb.m_callback = callback;
+        cb.m_stereoCallback = nullptr;
         cb.m_userData = userData;
         cb.m_interfaceName = interfaceName;
         cb.m_interface = nullptr;
@@ -310,6 +341,7 @@ namespace renderkit {
         // All public methods that use internal state should be guarded
         // by a mutex.
         std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
 
         // Look up an entry matching all three paramaters.  If we
         // find one, remove it from the list after removing its
@@ -319,6 +351,7 @@ namespace renderkit {
         for (size_t i = 0; i < m_callbacks.size(); i++) {
             RenderCallbackInfo& ci = m_callbacks[i];
             if ((interfaceName == ci.m_interfaceName) &&
+                (ci.m_stereoCallback == nullptr) &&
                 (callback == ci.m_callback) && (userData == ci.m_userData)) {
                 if (ci.m_interface != nullptr) {
                     if (osvrClientFreeInterface(m_context->get(),
@@ -339,21 +372,121 @@ namespace renderkit {
         return false;
     }
 
+    bool RenderManager::AddStereoRenderCallback(
+        const std::string& interfaceName, StereoRenderCallback callback,
+        void* userData) {
+        // All public methods that use internal state should be guarded
+        // by a mutex.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
+
+        // Make sure we have valid data
+        if (callback == nullptr) {
+            std::cerr << "RenderManager::AddStereoRenderCallback: NULL "
+                         "callback handler"
+                      << std::endl;
+            return false;
+        }
+
+        // Stereo callbacks live alongside the per-eye ones, so that they
+        // share the handling of interfaces and poses.
+        RenderCallbackInfo cb;
+        cb.m_callback = nullptr;
+        cb.m_stereoCallback = callback;
+        cb.m_userData = userData;
+        cb.m_interfaceName = interfaceName;
+        cb.m_interface = nullptr;
+        osvrPose3SetIdentity(&cb.m_state);
+
+        if ((interfaceName.size() > 0) && (interfaceName != "/")) {
+            if (osvrClientGetInterface(m_context->get(), interfaceName.c_str(),
+                                       &cb.m_interface) ==
+                OSVR_RETURN_FAILURE) {
+                std::cerr << "RenderManager::AddStereoRenderCallback(): "
+                             "Can't get interface "
+                          << interfaceName << std::endl;
+            }
+        }
+
+        m_callbacks.push_back(cb);
+        return true;
+    }
+
+    bool RenderManager::RemoveStereoRenderCallback(
+        const std::string& interfaceName, StereoRenderCallback callback,
+        void* userData) {
+        // All public methods that use internal state should be guarded
+        // by a mutex.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
+
+        for (size_t i = 0; i < m_callbacks.size(); i++) {
+            RenderCallbackInfo& ci = m_callbacks[i];
+            if ((interfaceName == ci.m_interfaceName) &&
+                (ci.m_stereoCallback != nullptr) &&
+                (callback == ci.m_stereoCallback) &&
+                (userData == ci.m_userData)) {
+                if (ci.m_interface != nullptr) {
+                    if (osvrClientFreeInterface(m_context->get(),
+                                                ci.m_interface) ==
+                        OSVR_RETURN_FAILURE) {
+                        std::cerr << "RenderManager::"
+                                     "RemoveStereoRenderCallback(): Could "
+                                     "not free the interface for this "
+                                     "callback."
+                                  << std::endl;
+                        return false;
+                    }
+                }
+                m_callbacks.erase(m_callbacks.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
     RenderManager::~RenderManager() {
         // Unregister any remaining callback handlers for devices that
         // are set to update our transformation matrices.
         while (m_callbacks.size() > 0) {
             RenderCallbackInfo& cb = m_callbacks.front();
-            RemoveRenderCallback(cb.m_interfaceName, cb.m_callback,
-                                 cb.m_userData);
+            bool removed;
+            if (cb.m_stereoCallback != nullptr) {
+                removed = RemoveStereoRenderCallback(
+                    cb.m_interfaceName, cb.m_stereoCallback, cb.m_userData);
+            } else {
+                removed = RemoveRenderCallback(cb.m_interfaceName,
+                                               cb.m_callback, cb.m_userData);
+            }
+            if (!removed) {
+                break;
+            }
         }
     }
 
+    bool RenderManager::RenderStereoSpace(
+        size_t whichSpace, size_t numEyes, const OSVR_PoseState* poses,
+        const OSVR_ViewportDescription* viewports,
+        const OSVR_ProjectionMatrix* projections) {
+        /// @todo Fill in the timing information
+        OSVR_TimeValue deadline;
+        deadline.microseconds = 0;
+        deadline.seconds = 0;
+
+        RenderCallbackInfo& cb = m_callbacks[whichSpace];
+        cb.m_stereoCallback(cb.m_userData, m_library, m_buffers, numEyes,
+                            viewports, poses, projections, deadline);
+        return true;
+    }
+
     bool RenderManager::Render(const RenderParams& params) {
         // All public methods that use internal state should be guarded
         // by a mutex.
         std::lock_guard<std::mutex> lock(m_mutex);
 
+        // Render info latched from now on is for the next frame.
+        m_frameCount++;
+
         // Make sure we're doing okay.
         if (!doingOkay()) {
             std::cerr << "RenderManager::Render(): Display not opened."
@@ -361,22 +494,27 @@ namespace renderkit {
             return false;
         }
 
-        // Update the transformations so that we have the most-recent
-        // state in them.
-        if (osvrClientUpdate(m_context->get()) == OSVR_RETURN_FAILURE) {
-            std::cerr
-                << "RenderManager::Render(): client context update failed."
-                << std::endl;
+        // Read the transformations.  This updates the client context so
+        // that we have the most-recent state in them.
+        m_renderParamsForRender = params;
+        if (!GetRenderInfoInternal(params, m_renderInfoForRender,
+                                   &m_renderFramePoses)) {
             return false;
         }
 
-        // Read the transformations
-        m_renderParamsForRender = params;
-        m_renderInfoForRender = GetRenderInfoInternal(params);
-
         /// @todo Use acceleration and velocity to predict viewpoint at the
         // time we expect to render.
 
+        // Stereo callbacks get all of the eyes at once if the renderer
+        // can draw them in one pass, and are otherwise handled per eye.
+        bool haveStereoCallbacks = false;
+        for (size_t i = 0; i < m_callbacks.size(); i++) {
+            if (m_callbacks[i].m_stereoCallback != nullptr) {
+                haveStereoCallbacks = true;
+            }
+        }
+        bool singlePassStereo = haveStereoCallbacks && CanRenderStereo();
+
         // Initialize the rendering for the whole frame.
         if (!RenderFrameInitialize()) {
             return false;
@@ -398,127 +536,384 @@ namespace renderkit {
 
             // Render for each eye, setting up the appropriate projection matrix
             // and viewport.
-            for (size_t eyeInDisplay = 0; eyeInDisplay < GetNumEyesPerDisplay();
-                 eyeInDisplay++) {
+            if (!RenderDisplayEyes(display, params,
+                                   haveStereoCallbacks && !singlePassStereo)) {
+                return false;
+            }
 
-                // Figure out which overall eye this is.
-                size_t eye = eyeInDisplay + display * GetNumEyesPerDisplay();
+            if (!RenderDisplayFinalize(display)) {
+                std::cerr
+                    << "RenderManager::Render(): Could not finalize display "
+                    << display << std::endl;
+                return false;
+            }
+        }
 
-                // Initialize the projection matrix and viewport.
-                // Then call any user callback to handle whatever else
-                // needs doing (clearing the screen, for example).
-                // Compute and set the viewport and projection matrix.
-                // Use our internal member variables to store them so
-                // they will be available for the render space callbacks
-                // as well.
-                // Every eye is on its own display now, so we need to
-                // initialize and finalize the displays as well.
-                if (!RenderEyeInitialize(eye)) {
-                    std::cerr
-                        << "RenderManager::Render(): Could not initialize eye."
-                        << std::endl;
-                    return false;
+        // Render the stereo callbacks for all eyes at once.
+        if (singlePassStereo) {
+            if (!RenderStereoInitialize()) {
+                std::cerr << "RenderManager::Render(): Could not initialize "
+                             "stereo rendering."
+                          << std::endl;
+                return false;
+            }
+            size_t numEyes = m_renderInfoForRender.size();
+            m_stereoViewports.resize(numEyes);
+            m_stereoPoses.resize(numEyes);
+            m_stereoProjections.resize(numEyes);
+            for (size_t i = 0; i < m_callbacks.size(); i++) {
+                if (m_callbacks[i].m_stereoCallback == nullptr) {
+                    continue;
                 }
-                if (m_viewCallback.m_callback != nullptr) {
-                    m_viewCallback.m_callback(
-                        m_viewCallback.m_userData, m_library, m_buffers,
-                        m_renderInfoForRender[eye].viewport,
-                        m_renderInfoForRender[eye].projection, eye);
+                // A space is only drawn if we have its pose for every eye.
+                bool havePoses = true;
+                for (size_t eye = 0; eye < numEyes && havePoses; eye++) {
+                    havePoses = ComposeModelView(m_renderFramePoses, i, eye,
+                                                 m_stereoPoses[eye]);
                 }
-
-                /// @todo Consider adding a shear to do with current
-                /// head velocity to the transform.  Probably in
-                /// the RenderParams structure passed in.
-
-                // Render objects in the callback spaces.
-                for (size_t i = 0; i < m_callbacks.size(); i++) {
-
-                    /// Construct the ModelView transform to use and then render
-                    /// the
-                    /// space.  We can't just re-use the ones we got above
-                    /// because
-                    /// they are all done in world space.
-                    ///  If we don't get a modelview matrix for a particular
-                    ///  space,
-                    /// we just don't render anything into that space.  For
-                    /// example,
-                    /// the example demos look for left and right hands and they
-                    /// might
-                    /// not be defined.
-                    OSVR_PoseState pose;
-                    if (!ConstructModelView(i, eye, params, pose)) {
-                        continue;
+                if (!havePoses) {
+                    continue;
+                }
+                // Each pass draws the same region of every eye.
+                for (size_t r = 0; r < GetNumRenderRegions(); r++) {
+                    for (size_t eye = 0; eye < numEyes; eye++) {
+                        RenderInfo region;
+                        GetRenderRegion(m_renderInfoForRender[eye], r, region);
+                        m_stereoViewports[eye] = region.viewport;
+                        m_stereoProjections[eye] = region.projection;
                     }
-                    if (!RenderSpace(i, eye, pose,
-                                     m_renderInfoForRender[eye].viewport,
-                                     m_renderInfoForRender[eye].projection)) {
+                    if (!RenderStereoSpace(i, numEyes, m_stereoPoses.data(),
+                                           m_stereoViewports.data(),
+                                           m_stereoProjections.data())) {
                         return false;
                     }
                 }
-
-                // Done with this eye.
-                if (!RenderEyeFinalize(eye)) {
-                    std::cerr
-                        << "RenderManager::Render(): Could not finalize eye."
-                        << std::endl;
-                    return false;
-                }
             }
+            if (!RenderStereoFinalize()) {
+                std::cerr << "RenderManager::Render(): Could not finalize "
+                             "stereo rendering."
+                          << std::endl;
+                return false;
+            }
+        }
 
-            if (!RenderDisplayFinalize(display)) {
-                std::cerr
-                    << "RenderManager::Render(): Could not finalize display "
-                    << display << std::endl;
+        // Finalize the rendering for the whole frame, which presents it.
+        bool finalized = RenderFrameFinalize();
+        RecordFramePresented();
+        if (!finalized) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool RenderManager::RenderDisplayEyes(size_t display,
+                                          const RenderParams& params,
+                                          bool stereoPerEye) {
+        for (size_t eyeInDisplay = 0; eyeInDisplay < GetNumEyesPerDisplay();
+             eyeInDisplay++) {
+
+            // Figure out which overall eye this is.
+            size_t eye = eyeInDisplay + display * GetNumEyesPerDisplay();
+            if (!RenderEye(eye, params, stereoPerEye)) {
                 return false;
             }
         }
+        return true;
+    }
 
-        // Finalize the rendering for the whole frame.
-        if (!RenderFrameFinalize()) {
+    bool RenderManager::RenderEye(size_t eye, const RenderParams& params,
+                                  bool stereoPerEye) {
+        // Initialize the projection matrix and viewport.
+        // Then call any user callback to handle whatever else
+        // needs doing (clearing the screen, for example).
+        // Compute and set the viewport and projection matrix.
+        // Use our internal member variables to store them so
+        // they will be available for the render space callbacks
+        // as well.
+        // Every eye is on its own display now, so we need to
+        // initialize and finalize the displays as well.
+        if (!RenderEyeInitialize(eye)) {
+            std::cerr << "RenderManager::Render(): Could not initialize eye."
+                      << std::endl;
+            return false;
+        }
+        if (m_viewCallback.m_callback != nullptr) {
+            m_viewCallback.m_callback(m_viewCallback.m_userData, m_library,
+                                      m_buffers,
+                                      m_renderInfoForRender[eye].viewport,
+                                      m_renderInfoForRender[eye].projection,
+                                      eye);
+        }
+        if (!RenderEyeHiddenArea(eye)) {
+            std::cerr << "RenderManager::Render(): Could not mask hidden "
+                         "area of eye."
+                      << std::endl;
             return false;
         }
 
-        // Keep track of the timing information.
-        /// @todo
+        /// @todo Consider adding a shear to do with current
+        /// head velocity to the transform.  Probably in
+        /// the RenderParams structure passed in.
+
+        // Render objects in the callback spaces.
+        for (size_t i = 0; i < m_callbacks.size(); i++) {
+            if (m_callbacks[i].m_stereoCallback != nullptr) {
+                continue;
+            }
+
+            /// Construct the ModelView transform to use and then render
+            /// the space.  We can't just re-use the ones we got above
+            /// because they are all done in world space.
+            ///  If we don't get a modelview matrix for a particular space,
+            /// we just don't render anything into that space.  For example,
+            /// the example demos look for left and right hands and they
+            /// might not be defined.
+            ///  The poses were all read once for this frame, so this is
+            /// the same snapshot for every eye and space.
+            OSVR_PoseState pose;
+            if (!ComposeModelView(m_renderFramePoses, i, eye, pose)) {
+                continue;
+            }
+            for (size_t r = 0; r < GetNumRenderRegions(); r++) {
+                RenderInfo region;
+                GetRenderRegion(m_renderInfoForRender[eye], r, region);
+                if (!RenderSpace(i, eye, pose, region.viewport,
+                                 region.projection)) {
+                    return false;
+                }
+            }
+        }
+
+        // Without single-pass stereo, stereo callbacks are handed one eye
+        // at a time.
+        for (size_t i = 0; stereoPerEye && i < m_callbacks.size(); i++) {
+            if (m_callbacks[i].m_stereoCallback == nullptr) {
+                continue;
+            }
+            OSVR_PoseState pose;
+            if (!ComposeModelView(m_renderFramePoses, i, eye, pose)) {
+                continue;
+            }
+            for (size_t r = 0; r < GetNumRenderRegions(); r++) {
+                RenderInfo region;
+                GetRenderRegion(m_renderInfoForRender[eye], r, region);
+                if (!RenderStereoSpace(i, 1, &pose, &region.viewport,
+                                       &region.projection)) {
+                    return false;
+                }
+            }
+        }
 
+        // Done with this eye.
+        if (!RenderEyeFinalize(eye)) {
+            std::cerr << "RenderManager::Render(): Could not finalize eye."
+                      << std::endl;
+            return false;
+        }
         return true;
     }
 
+    /// Is the pose we stored (if any) the same as the one passed in (if any)?
+    static bool samePose(bool haveA, const OSVR_PoseState& a,
+                         const OSVR_PoseState* b) {
+        if (!haveA || b == nullptr) {
+            return !haveA && b == nullptr;
+        }
+        return osvrVec3GetX(&a.translation) == osvrVec3GetX(&b->translation) &&
+               osvrVec3GetY(&a.translation) == osvrVec3GetY(&b->translation) &&
+               osvrVec3GetZ(&a.translation) == osvrVec3GetZ(&b->translation) &&
+               osvrQuatGetW(&a.rotation) == osvrQuatGetW(&b->rotation) &&
+               osvrQuatGetX(&a.rotation) == osvrQuatGetX(&b->rotation) &&
+               osvrQuatGetY(&a.rotation) == osvrQuatGetY(&b->rotation) &&
+               osvrQuatGetZ(&a.rotation) == osvrQuatGetZ(&b->rotation);
+    }
+
     size_t RenderManager::LatchRenderInfo(const RenderParams& params) {
-        // All public methods that use internal state should be guarded
-        // by a mutex.
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> lock(m_frameLatchLock);
+        return latchRenderInfoLocked(params)->renderInfo.size();
+    }
+
+    std::shared_ptr<const RenderManager::FrameRenderInfo>
+    RenderManager::LatchFrameRenderInfo(const RenderParams& params) {
+        std::lock_guard<std::mutex> lock(m_frameLatchLock);
+
+        // Once this frame has been latched, the client context is not
+        // updated again until the next one.  The snapshot is reused if it
+        // has the same parameters; otherwise these are applied to the
+        // head pose that was read for the frame.  Only successful latches
+        // count, so that a failure does not stick for the rest of the
+        // frame.
+        std::shared_ptr<const FrameRenderInfo> latched =
+            std::atomic_load(&m_latchedRenderInfo);
+        if (!latched || latched->renderInfo.empty() ||
+            latched->frameId != m_frameCount.load()) {
+            return latchRenderInfoLocked(params);
+        }
+        const LatchedParams& p = m_latchedParams;
+        if (samePose(p.haveWorldFromRoom, p.worldFromRoom,
+                     params.worldFromRoomAppend) &&
+            samePose(p.haveRoomFromHead, p.roomFromHead,
+                     params.roomFromHeadReplace) &&
+            p.nearClipDistanceMeters == params.nearClipDistanceMeters &&
+            p.farClipDistanceMeters == params.farClipDistanceMeters &&
+            p.IPDMeters == params.IPDMeters) {
+            return latched;
+        }
+        return latchRenderInfoLocked(params, latched.get());
+    }
 
-        m_latchedRenderInfo = GetRenderInfoInternal(params);
-        return m_latchedRenderInfo.size();
+    std::shared_ptr<const RenderManager::FrameRenderInfo>
+    RenderManager::latchRenderInfoLocked(const RenderParams& params,
+                                         const FrameRenderInfo* sameFrame) {
+        // This does not lock m_mutex, so that render info can be latched
+        // while another thread is presenting.  GetRenderInfoInternal()
+        // locks the state that it reads.  The snapshot is filled in
+        // place, reusing the storage of one that nobody holds any more;
+        // it is not modified after it has been published.
+        std::shared_ptr<FrameRenderInfo> snapshot = takeLatchBuffer();
+        if (sameFrame != nullptr) {
+            // Use the frame's head pose unless the caller replaces it,
+            // and the frame's prediction of when it will be shown.
+            RenderParams frameParams = params;
+            if (frameParams.roomFromHeadReplace == nullptr) {
+                frameParams.roomFromHeadReplace = &m_frameRoomFromHead;
+            }
+            snapshot->frameId = sameFrame->frameId;
+            snapshot->predictedDisplayTime = sameFrame->predictedDisplayTime;
+            snapshot->renderInfo.clear();
+            if (doingOkay()) {
+                std::lock_guard<std::mutex> stateLock(m_stateMutex);
+                ComputeRenderInfoLocked(frameParams, snapshot->renderInfo,
+                                        m_frameLatchPoses);
+            }
+        } else {
+            snapshot->frameId = m_frameCount.load();
+            GetRenderInfoInternal(params, snapshot->renderInfo,
+                                  &m_frameLatchPoses);
+            m_frameRoomFromHead = m_frameLatchPoses.trackedRoomFromHead;
+
+            // Predict when the frame will be shown from the timing of the
+            // first display, assuming the others are synchronized to it.
+            // The present will be made at the next retrace unless that is
+            // already within the time-warp threshold, in which case it
+            // will be at the one after.
+            snapshot->predictedDisplayTime.seconds = 0;
+            snapshot->predictedDisplayTime.microseconds = 0;
+            RenderTimingInfo timing;
+            if (GetTimingInfo(0, timing)) {
+                OSVR_TimeValue untilRetrace = timing.hardwareDisplayInterval;
+                osvrTimeValueDifference(&untilRetrace,
+                                        &timing.timeSincelastVerticalRetrace);
+                double untilRetraceMS = untilRetrace.seconds * 1e3 +
+                                        untilRetrace.microseconds / 1e3;
+                OSVR_TimeValue predicted;
+                osvrTimeValueGetNow(&predicted);
+                osvrTimeValueSum(&predicted, &untilRetrace);
+                if (untilRetraceMS < m_timeWarpThresholdMS) {
+                    osvrTimeValueSum(&predicted,
+                                     &timing.hardwareDisplayInterval);
+                }
+                snapshot->predictedDisplayTime = predicted;
+            }
+        }
+
+        // Record the parameters, along with the poses they point to.
+        LatchedParams& p = m_latchedParams;
+        p.haveWorldFromRoom = params.worldFromRoomAppend != nullptr;
+        if (p.haveWorldFromRoom) {
+            p.worldFromRoom = *params.worldFromRoomAppend;
+        }
+        p.haveRoomFromHead = params.roomFromHeadReplace != nullptr;
+        if (p.haveRoomFromHead) {
+            p.roomFromHead = *params.roomFromHeadReplace;
+        }
+        p.nearClipDistanceMeters = params.nearClipDistanceMeters;
+        p.farClipDistanceMeters = params.farClipDistanceMeters;
+        p.IPDMeters = params.IPDMeters;
+
+        std::shared_ptr<const FrameRenderInfo> ret(snapshot);
+        std::atomic_store(&m_latchedRenderInfo, ret);
+        return ret;
+    }
+
+    std::shared_ptr<RenderManager::FrameRenderInfo>
+    RenderManager::takeLatchBuffer() {
+        std::lock_guard<std::mutex> lock(m_latchPoolLock);
+
+        // A buffer held only by the pool is neither published nor being
+        // read, and no new references to it can be made, so it is ours.
+        for (size_t i = 0; i < m_latchPool.size(); i++) {
+            if (m_latchPool[i].use_count() == 1) {
+                return m_latchPool[i];
+            }
+        }
+
+        // Readers are holding on to all of them; add another one, up to a
+        // limit beyond which we stop keeping them.
+        std::shared_ptr<FrameRenderInfo> ret =
+            std::make_shared<FrameRenderInfo>();
+        if (m_latchPool.size() < LATCH_POOL_SIZE) {
+            m_latchPool.push_back(ret);
+        }
+        return ret;
+    }
+
+    bool RenderManager::GetRenderInfo(const RenderParams& params,
+                                      std::vector<RenderInfo>& infoOut) {
+        // Always read new poses, as LatchRenderInfo() does.
+        std::shared_ptr<const FrameRenderInfo> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(m_frameLatchLock);
+            snapshot = latchRenderInfoLocked(params);
+        }
+        infoOut.assign(snapshot->renderInfo.begin(),
+                       snapshot->renderInfo.end());
+        return !infoOut.empty();
     }
 
     RenderInfo RenderManager::GetRenderInfo(size_t index) {
-        // All public methods that use internal state should be guarded
-        // by a mutex.
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::shared_ptr<const FrameRenderInfo> snapshot =
+            std::atomic_load(&m_latchedRenderInfo);
 
         RenderInfo ret;
-        if (index < m_latchedRenderInfo.size()) {
-            ret = m_latchedRenderInfo[index];
+        if (snapshot && index < snapshot->renderInfo.size()) {
+            ret = snapshot->renderInfo[index];
         }
         return ret;
     }
 
-    std::vector<RenderInfo>
-    RenderManager::GetRenderInfoInternal(const RenderParams& params) {
+    std::shared_ptr<const std::vector<RenderInfo> >
+    RenderManager::GetRenderInfoSnapshot() {
+        std::shared_ptr<const FrameRenderInfo> snapshot =
+            std::atomic_load(&m_latchedRenderInfo);
+        if (!snapshot) {
+            return std::make_shared<const std::vector<RenderInfo> >();
+        }
+        // Share ownership of the whole snapshot.
+        return std::shared_ptr<const std::vector<RenderInfo> >(
+            snapshot, &snapshot->renderInfo);
+    }
+
+    bool RenderManager::GetRenderInfoInternal(const RenderParams& params,
+                                              std::vector<RenderInfo>& ret,
+                                              FramePoses* framePoses) {
         // Start with an empty vector, which will be returned as such on
-        // failure.
-        std::vector<RenderInfo> ret;
+        // failure.  Clearing it keeps its storage for reuse.
+        ret.clear();
 
         // Make sure we're doing okay.
         if (!doingOkay()) {
             std::cerr << "RenderManager::GetRenderInfo(): Display not opened."
                       << std::endl;
             ret.clear();
-            return ret;
+            return false;
         }
 
+        // The context and the poses it updates may be in use by another
+        // thread if we were called without m_mutex.
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
+
         // Update the transformations so that we have the most-recent
         // state in them.  Record the time at which we got this state.
         if (osvrClientUpdate(m_context->get()) == OSVR_RETURN_FAILURE) {
@@ -526,12 +921,29 @@ namespace renderkit {
                          "update failed."
                       << std::endl;
             ret.clear();
-            return ret;
+            return false;
         }
 
         /// @todo Use acceleration and velocity to predict viewpoint at the
         // time we expect to render.
 
+        FramePoses& poses = framePoses ? *framePoses : m_latchFramePoses;
+        return ComputeRenderInfoLocked(params, ret, poses);
+    }
+
+    bool RenderManager::ComputeRenderInfoLocked(const RenderParams& params,
+                                                std::vector<RenderInfo>& ret,
+                                                FramePoses& poses) {
+        ret.clear();
+
+        // Read the poses once for all of the eyes.
+        ConstructFramePoses(params, poses);
+        const EyeTransforms& eyeTransforms = GetEyeTransforms(params);
+        if (!eyeTransforms.projectionsOkay) {
+            ret.clear();
+            return false;
+        }
+
         // Determine parameters for each eye, filling in all relevant
         // parameters.
         size_t numEyes = GetNumEyes();
@@ -547,34 +959,37 @@ namespace renderkit {
             OSVR_ViewportDescription v;
             if (!ConstructViewportForRender(eye, v)) {
                 ret.clear();
-                return ret;
+                return false;
             }
-            info.viewport = v;
 
-            // Construct the projection matrix.
-            if (!ConstructProjection(eye, params.nearClipDistanceMeters,
-                                     params.farClipDistanceMeters,
-                                     info.projection)) {
-                ret.clear();
-                return ret;
+            // Only the lower-left part of the texture is rendered into
+            // when the resolution is scaled down.
+            if (m_params.m_dynamicResolution) {
+                float scale = m_resolutionScale;
+                v.width = std::floor(v.width * scale + 0.5);
+                v.height = std::floor(v.height * scale + 0.5);
             }
+            info.viewport = v;
+
+            // Use the cached projection matrix.
+            info.projection = eyeTransforms.projection[eye];
 
             // Construct a ModelView transform for world space.
             // By passing m_callbacks.size(), we guarantee world space.
-            if (!ConstructModelView(m_callbacks.size(), eye, params,
-                                    info.pose)) {
+            if (!ComposeModelView(poses, m_callbacks.size(), eye,
+                                  info.pose)) {
                 std::cerr << "RenderManagerBase::GetRenderInfo(): Could not "
-                             "ConstructModelView"
+                             "ComposeModelView"
                           << std::endl;
                 ret.clear();
-                return ret;
+                return false;
             }
 
             // Add this to the list of eyes to be rendered.
             ret.push_back(info);
         }
 
-        return ret;
+        return true;
     }
 
     bool RenderManager::RegisterRenderBuffers(
@@ -606,9 +1021,14 @@ namespace renderkit {
         // by a mutex.
         std::lock_guard<std::mutex> lock(m_mutex);
 
-        return PresentRenderBuffersInternal(
+        // Render info latched from now on is for the next frame.
+        m_frameCount++;
+
+        bool ret = PresentRenderBuffersInternal(
             buffers, renderInfoUsed, renderParams, normalizedCroppingViewports,
             flipInY);
+        RecordFramePresented();
+        return ret;
     }
 
     bool RenderManager::PresentRenderBuffersInternal(
@@ -635,6 +1055,7 @@ namespace renderkit {
         }
 
         // Initialize the presentation for the whole frame.
+        m_timeWarpWaitMS = 0;
         if (!PresentFrameInitialize()) {
             std::cerr << "RenderManager::PresentRenderBuffers(): "
                          "PresentFrameInitialize() failed."
@@ -648,13 +1069,14 @@ namespace renderkit {
         // are, then we continue to update our context state until we're
         // within the required threshold.
 
-        if (m_params.m_enableTimeWarp &&
-            (m_params.m_maxMSBeforeVsyncTimeWarp > 0)) {
+        auto waitStart = std::chrono::steady_clock::now();
+        float thresholdMS = m_timeWarpThresholdMS;
+        if (m_params.m_enableTimeWarp && (thresholdMS > 0)) {
             int count = 0;
 
             // Compute the threshold interval we need to be below.
             // Convert from milliseconds to seconds
-            float thresholdF = m_params.m_maxMSBeforeVsyncTimeWarp / 1e3f;
+            float thresholdF = thresholdMS / 1e3f;
             OSVR_TimeValue threshold;
             threshold.seconds = static_cast<OSVR_TimeValue_Seconds>(thresholdF);
             thresholdF -= threshold.seconds;
@@ -667,12 +1089,18 @@ namespace renderkit {
                 proceed = true;
 
                 // Update the client context so we keep getting all required
-                // callbacks called during our busy-wait.
-                if (osvrClientUpdate(m_context->get()) == OSVR_RETURN_FAILURE) {
-                    std::cerr << "RenderManager::PresentRenderBuffers(): "
-                                 "client context update failed."
-                              << std::endl;
-                    return false;
+                // callbacks called during our busy-wait.  The state lock is
+                // only held for each update, so other threads can latch
+                // render info while we wait.
+                {
+                    std::lock_guard<std::mutex> stateLock(m_stateMutex);
+                    if (osvrClientUpdate(m_context->get()) ==
+                        OSVR_RETURN_FAILURE) {
+                        std::cerr << "RenderManager::PresentRenderBuffers(): "
+                                     "client context update failed."
+                                  << std::endl;
+                        return false;
+                    }
                 }
 
                 // Check to see if we are able to determine the timing info.
@@ -703,18 +1131,25 @@ namespace renderkit {
             */
         }
 
+        // Start timing the present, so that we know how far ahead of vsync
+        // we need to stop waiting.
+        auto presentStart = std::chrono::steady_clock::now();
+        std::chrono::duration<float, std::milli> timeWarpWait =
+            presentStart - waitStart;
+        m_timeWarpWaitMS = timeWarpWait.count();
+        m_presentBlocked = std::chrono::steady_clock::duration::zero();
+
         // Store the previous matrices we returned to the client and a new set
         // using
         // the same transformation hierarchy.  This is a side effect of the
         // GetRenderInfo function.  Use these parameters to construct info
         // needed
         // to perform Asynchronous Time Warp.
-        std::vector<RenderInfo> currentRenderInfo =
-            GetRenderInfoInternal(renderParams);
+        GetRenderInfoInternal(renderParams, m_presentRenderInfo);
         // @todo make the depth for ATW a parameter?
         if (m_params.m_enableTimeWarp) {
-            if (!ComputeAsynchronousTimeWarps(renderInfoUsed, currentRenderInfo,
-                                              2.0f)) {
+            if (!ComputeAsynchronousTimeWarps(renderInfoUsed,
+                                              m_presentRenderInfo, 2.0f)) {
                 std::cerr << "RenderManager::PresentRenderBuffers: Could not "
                              "compute ATWs"
                           << std::endl;
@@ -813,8 +1248,24 @@ namespace renderkit {
                 // passed in.
                 // If they didn't pass anything, use the full buffer.
                 OSVR_ViewportDescription bufferCrop;
+                OSVR_ViewportDescription fullViewport;
                 if (eye < normalizedCroppingViewports.size()) {
                     bufferCrop = normalizedCroppingViewports[eye];
+                } else if (m_params.m_dynamicResolution &&
+                           eye < renderInfoUsed.size() &&
+                           ConstructViewportForRender(eye, fullViewport) &&
+                           fullViewport.width > 0 &&
+                           fullViewport.height > 0) {
+                    // Only the part of the texture for the resolution scale
+                    // the eye was rendered at has been drawn into.
+                    const OSVR_ViewportDescription& used =
+                        renderInfoUsed[eye].viewport;
+                    bufferCrop.left = 0;
+                    bufferCrop.lower = 0;
+                    bufferCrop.width =
+                        std::min(1.0, used.width / fullViewport.width);
+                    bufferCrop.height =
+                        std::min(1.0, used.height / fullViewport.height);
                 } else {
                     bufferCrop.left = 0;
                     bufferCrop.lower = 0;
@@ -848,29 +1299,120 @@ namespace renderkit {
             return false;
         }
 
-        // Keep track of the timing information.
-        /// @todo
+        // Keep track of the timing information, leaving out any wait for
+        // vertical sync in the swaps.
+        std::chrono::duration<float, std::milli> presentDuration =
+            std::chrono::steady_clock::now() - presentStart - m_presentBlocked;
+        RecordPresentDuration(presentDuration.count());
 
         return true;
     }
 
+    void RenderManager::RecordPresentDuration(float ms) {
+        if (!m_params.m_adaptiveTimeWarpThreshold ||
+            m_params.m_adaptiveTimeWarpWindow == 0) {
+            return;
+        }
+
+        // Fill the window until it is full, then overwrite the oldest entry.
+        if (m_presentDurationsMS.size() < m_params.m_adaptiveTimeWarpWindow) {
+            m_presentDurationsMS.push_back(ms);
+        } else {
+            m_presentDurationsMS[m_nextPresentDuration] = ms;
+        }
+        m_nextPresentDuration =
+            (m_nextPresentDuration + 1) % m_params.m_adaptiveTimeWarpWindow;
+
+        // Don't trust the percentile until we have seen a reasonable number
+        // of frames; keep the threshold we started with until then.
+        size_t minSamples =
+            std::min<size_t>(m_params.m_adaptiveTimeWarpWindow, 10);
+        if (m_presentDurationsMS.size() < minSamples) {
+            return;
+        }
+
+        // Select the requested percentile without fully sorting.
+        m_presentDurationsSorted = m_presentDurationsMS;
+        float fraction = m_params.m_adaptiveTimeWarpPercentile / 100.0f;
+        fraction = std::max(0.0f, std::min(1.0f, fraction));
+        size_t which = static_cast<size_t>(
+            fraction * (m_presentDurationsSorted.size() - 1) + 0.5f);
+        std::nth_element(m_presentDurationsSorted.begin(),
+                         m_presentDurationsSorted.begin() + which,
+                         m_presentDurationsSorted.end());
+
+        float threshold = m_presentDurationsSorted[which] +
+                          m_params.m_adaptiveTimeWarpMarginMS;
+        threshold = std::max(threshold, m_params.m_adaptiveTimeWarpMinMS);
+        threshold = std::min(threshold, m_params.m_adaptiveTimeWarpMaxMS);
+        m_timeWarpThresholdMS = threshold;
+    }
+
+    void RenderManager::RecordFramePresented() {
+        if (!m_resolutionController) {
+            return;
+        }
+
+        // Without a configured target, frames have to keep up with the
+        // display.
+        float target = m_params.m_dynamicResolutionTargetMS;
+        if (target <= 0) {
+            RenderTimingInfo timing;
+            if (GetTimingInfo(0, timing)) {
+                target = timing.hardwareDisplayInterval.seconds * 1e3f +
+                         timing.hardwareDisplayInterval.microseconds / 1e3f;
+            }
+        }
+
+        // Time spent waiting for the time-warp threshold is not part of
+        // rendering the frame.  With asynchronous time warp, that wait is
+        // on the time-warp thread and not between the application's
+        // presents.
+        std::chrono::steady_clock::duration waited =
+            std::chrono::steady_clock::duration::zero();
+        if (!m_params.m_asynchronousTimeWarp) {
+            waited = std::chrono::duration_cast<
+                std::chrono::steady_clock::duration>(
+                std::chrono::duration<float, std::milli>(m_timeWarpWaitMS));
+        }
+        if (m_resolutionController->framePresented(
+                std::chrono::steady_clock::now(), waited, target)) {
+            m_resolutionScale = m_resolutionController->scale();
+        }
+    }
+
     bool RenderManager::UpdateDistortionMeshes(
         DistortionMeshType type //< Type of mesh to produce
         ,
         std::vector<DistortionParameters> const&
             distort //< Distortion parameters
         ) {
+        // Compute the meshes before locking m_mutex, since this can take
+        // a while and does not touch the graphics state.  Only the swap of
+        // the graphics buffers waits for any present in progress.
+        std::vector<std::vector<DistortionMeshVertex> > meshes;
+        for (size_t eye = 0; eye < distort.size(); eye++) {
+            meshes.push_back(ComputeDistortionMesh(eye, type, distort[eye]));
+        }
+
         // All public methods that use internal state should be guarded
         // by a mutex.
         std::lock_guard<std::mutex> lock(m_mutex);
 
-        return UpdateDistortionMeshesInternal(type, distort);
+        m_precomputedMeshes.distort = &distort;
+        m_precomputedMeshes.type = type;
+        m_precomputedMeshes.meshes.swap(meshes);
+        bool ret = UpdateDistortionMeshesInternal(type, distort);
+        m_precomputedMeshes.distort = nullptr;
+        m_precomputedMeshes.meshes.clear();
+        return ret;
     }
 
     void RenderManager::SetRoomRotationUsingHead() {
         // All public methods that use internal state should be guarded
         // by a mutex.
         std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
 
         osvrClientSetRoomRotationUsingHead(m_context->get());
     }
@@ -879,6 +1421,7 @@ namespace renderkit {
         // All public methods that use internal state should be guarded
         // by a mutex.
         std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
 
         osvrClientClearRoomToWorldTransform(m_context->get());
     }
@@ -919,83 +1462,99 @@ namespace renderkit {
         return eye / GetNumEyesPerDisplay();
     }
 
+    void RenderManager::ConstructUnitFrusta() {
+        size_t numEyes = GetNumEyes();
+        m_eyeTransforms.unitFrustum.resize(numEyes);
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            //----------------------------------------------------------------
+            // Configure a projection transform based on the characteristics
+            // of the display we are using.
+
+            // The tangent of the view angle in either axis is the
+            // in-plane distance (left, right, top, or bottom) divided
+            // by the distance to the near clipping plane.  We have
+            // the angle specified and we assume a unit distance
+            // to the window; ConstructProjection() scales this by the
+            // near plane.  Given this, we solve for the tangent of half
+            // the angle (each of left and right provide half, as do top
+            // and bottom).
+            double right =
+                tan(osvr::util::getRadians(
+                        m_params.m_displayConfiguration.getHorizontalFOV()) /
+                    2.0);
+            double left = -right;
+            double top =
+                tan(osvr::util::getRadians(
+                        m_params.m_displayConfiguration.getVerticalFOV()) /
+                    2.0);
+            double bottom = -top;
+
+            // Incorporate the center-of-projection information for this
+            // eye, shifting so that 0.5,0.5 is in the center of the screen.
+            // We need to do this before we scale the viewport to add the
+            // amount needed for overfill, so we don't end up shifting past
+            // the edge of the actual screen.
+            double width = right - left;
+            double height = top - bottom;
+            double xCOP =
+                m_params.m_displayConfiguration.getEyes()[eye].m_CenterProjX;
+            double yCOP =
+                m_params.m_displayConfiguration.getEyes()[eye].m_CenterProjY;
+            double xOffset = (0.5 - xCOP) * width;
+            double yOffset = (0.5 - yCOP) * height;
+            left += xOffset;
+            right += xOffset;
+            top += yOffset;
+            bottom += yOffset;
+
+            // Incorporate pitch_tilt (degrees, positive is downwards)
+            // We assume that this results in a shearing of the image that
+            // leaves the plane of the screen the same.
+            auto pitchTilt = m_params.m_displayConfiguration.getPitchTilt();
+            if (pitchTilt != 0 * util::radians) {
+                /// @todo
+            }
+
+            // Add in the extra space needed to handle the rendering
+            // overfill used to provide margin for distortion correction
+            // and Time Warp.  We do in a way that can handle off-center
+            // projection by adding a margin to each edge.
+            OverfillMargins margins = GetOverfillMargins(eye);
+            left -= width * margins.left;
+            right += width * margins.right;
+            top += height * margins.top;
+            bottom -= height * margins.bottom;
+
+            EyeTransforms::Frustum& frustum = m_eyeTransforms.unitFrustum[eye];
+            frustum.left = left;
+            frustum.right = right;
+            frustum.top = top;
+            frustum.bottom = bottom;
+        }
+        m_eyeTransformsValid = true;
+    }
+
     bool RenderManager::ConstructProjection(size_t whichEye,
                                             double nearClipDistanceMeters,
                                             double farClipDistanceMeters,
                                             OSVR_ProjectionMatrix& projection) {
-        // Make sure that we have as many eyes as were asked for
-        if (whichEye >= GetNumEyes()) {
-            return false;
-        }
-
-        //--------------------------------------------------------------------
-        // Configure a projection transform based on the characteristics of the
-        // display we are using.
-
-        // Scale the unit X and Y parameters based on the near
-        // plane to make the field of view match what we expect.
-        // The tangent of the view angle in either axis is the
-        // in-plane distance (left, right, top, or bottom) divided
-        // by the distance to the near clipping plane.  We have
-        // the angle specified and for now we assume a unit distance
-        // to the window (we will adjust that later).  Given
-        // this, we solve for the tangent of half the angle
-        // (each of left and right provide half, as do top and
-        // bottom).
-        double right =
-            tan(osvr::util::getRadians(
-                    m_params.m_displayConfiguration.getHorizontalFOV()) /
-                2.0);
-        double left = -right;
-        double top = tan(osvr::util::getRadians(
-                             m_params.m_displayConfiguration.getVerticalFOV()) /
-                         2.0);
-        double bottom = -top;
+        // Make sure that we have as many eyes as were asked for.  The
+        // unit frusta are built at construction, and only rebuilt by
+        // GetEyeTransforms(), with m_stateMutex locked, before it calls us.
+        if (whichEye >= GetNumEyes() ||
+            whichEye >= m_eyeTransforms.unitFrustum.size()) {
+            return false;
+        }
 
         // Scale the in-plane positions based on the near plane to put
         // the virtual viewing window on the near plane with the eye at the
         // origin.
-        left *= nearClipDistanceMeters;
-        right *= nearClipDistanceMeters;
-        top *= nearClipDistanceMeters;
-        bottom *= nearClipDistanceMeters;
-
-        // Incorporate the center-of-projection information for this
-        // eye, shifting so that 0.5,0.5 is in the center of the screen.
-        // We need to do this before we scale the viewport to add the amount
-        // needed for overfill, so we don't end up shifting past the edge of
-        // the actual screen.
-        double width = right - left;
-        double height = top - bottom;
-        double xCOP =
-            m_params.m_displayConfiguration.getEyes()[whichEye].m_CenterProjX;
-        double yCOP =
-            m_params.m_displayConfiguration.getEyes()[whichEye].m_CenterProjY;
-        double xOffset = (0.5 - xCOP) * width;
-        double yOffset = (0.5 - yCOP) * height;
-        left += xOffset;
-        right += xOffset;
-        top += yOffset;
-        bottom += yOffset;
-
-        // Incorporate pitch_tilt (degrees, positive is downwards)
-        // We assume that this results in a shearing of the image that leaves
-        // the plane of the screen the same.
-        auto pitchTilt = m_params.m_displayConfiguration.getPitchTilt();
-        if (pitchTilt != 0 * util::radians) {
-            /// @todo
-        }
-
-        // Add in the extra space needed to handle the rendering overfill used
-        // to provide margin for distortion correction and Time
-        // Warp.  We do in a way that can handle off-center projection by
-        // adding a margin (which is half of the total overfill) to each edge.
-        double xMargin = width / 2 * (m_params.m_renderOverfillFactor - 1);
-        double yMargin = height / 2 * (m_params.m_renderOverfillFactor - 1);
-        left -= xMargin;
-        right += xMargin;
-        top += yMargin;
-        bottom -= yMargin;
+        const EyeTransforms::Frustum& frustum =
+            m_eyeTransforms.unitFrustum[whichEye];
+        double left = frustum.left * nearClipDistanceMeters;
+        double right = frustum.right * nearClipDistanceMeters;
+        double top = frustum.top * nearClipDistanceMeters;
+        double bottom = frustum.bottom * nearClipDistanceMeters;
 
         // We handle rotation of the pixels on the way to the screen,
         // due to the scan-out circuitry, in the code that reprojects the
@@ -1061,15 +1620,416 @@ namespace renderkit {
         }
 
         // We always want to render to a full window, with non-rotated view,
-        // with overfill factor and the oversampling factor applied.  This
+        // with overfill margins and the oversampling factor applied.  This
         // is the size of the buffer constructed for use in the Render pass.
+        OverfillMargins margins = GetOverfillMargins(whichEye);
         viewport.width = xFactor * m_displayWidth *
-                         m_params.m_renderOverfillFactor *
+                         (1 + margins.left + margins.right) *
                          m_params.m_renderOversampleFactor;
         viewport.height = yFactor * m_displayHeight *
-                          m_params.m_renderOverfillFactor *
+                          (1 + margins.bottom + margins.top) *
                           m_params.m_renderOversampleFactor;
 
+        // When rendering at multiple resolutions, the regions of the eye
+        // are packed into a smaller texture.
+        if (m_multiResolution.enabled) {
+            viewport.width = m_multiResolution.packedSize[0];
+            viewport.height = m_multiResolution.packedSize[1];
+        }
+
+        return true;
+    }
+
+    bool RenderManager::ComputeMultiResolutionLayout(
+        ConstructorParameters::Multi_Resolution_Profile profile, double width,
+        double height, MultiResolutionLayout& layout) const {
+        layout.enabled = false;
+        layout.unpackedSize[0] = layout.packedSize[0] = width;
+        layout.unpackedSize[1] = layout.packedSize[1] = height;
+
+        // Fraction of each dimension rendered at full resolution, and the
+        // scale of the resolution of the borders around it.
+        double center, border;
+        switch (profile) {
+        case ConstructorParameters::MultiResolution_Conservative:
+            center = 0.7;
+            border = 0.75;
+            break;
+        case ConstructorParameters::MultiResolution_Balanced:
+            center = 0.6;
+            border = 0.5;
+            break;
+        case ConstructorParameters::MultiResolution_Aggressive:
+            center = 0.5;
+            border = 1.0 / 3.0;
+            break;
+        case ConstructorParameters::MultiResolution_Custom:
+            center = m_params.m_multiResolutionCenterFraction;
+            border = m_params.m_multiResolutionBorderScale;
+            break;
+        default:
+            return false;
+        }
+        if (center <= 0 || center >= 1 || border <= 0 || border >= 1) {
+            std::cerr << "RenderManager::ComputeMultiResolutionLayout: "
+                         "Center fraction and border scale must be between "
+                         "0 and 1, rendering at one resolution"
+                      << std::endl;
+            return false;
+        }
+
+        // The center is centered in the eye, with the same size border on
+        // each side so that the layout is the same when flipped.  The
+        // boundaries in the packed texture are placed on whole pixels.
+        double size[2] = {width, height};
+        MultiResolutionLayout ret;
+        for (int axis = 0; axis < 2; axis++) {
+            double lowEdge = (1 - center) / 2;
+            double borderPixels =
+                std::floor(size[axis] * lowEdge * border + 0.5);
+            double centerPixels = std::floor(size[axis] * center + 0.5);
+            if (borderPixels < 1 || centerPixels < 1) {
+                return false;
+            }
+            double total = 2 * borderPixels + centerPixels;
+            ret.unpacked[axis][0] = 0;
+            ret.unpacked[axis][1] = lowEdge;
+            ret.unpacked[axis][2] = 1 - lowEdge;
+            ret.unpacked[axis][3] = 1;
+            ret.packed[axis][0] = 0;
+            ret.packed[axis][1] = borderPixels / total;
+            ret.packed[axis][2] = (borderPixels + centerPixels) / total;
+            ret.packed[axis][3] = 1;
+            ret.unpackedSize[axis] = size[axis];
+            ret.packedSize[axis] = total;
+        }
+        ret.enabled = true;
+        layout = ret;
+        return true;
+    }
+
+    bool RenderManager::GetMultiResolutionRemap(
+        MultiResolutionRemap& remap) const {
+        if (!m_multiResolution.enabled) {
+            return false;
+        }
+        for (int axis = 0; axis < 2; axis++) {
+            const double* u = m_multiResolution.unpacked[axis];
+            const double* p = m_multiResolution.packed[axis];
+            remap.low[axis] = static_cast<float>(u[1]);
+            remap.high[axis] = static_cast<float>(u[2]);
+            remap.slopeLow[axis] = static_cast<float>(p[1] / u[1]);
+            remap.slopeCenter[axis] =
+                static_cast<float>((p[2] - p[1]) / (u[2] - u[1]));
+            remap.slopeHigh[axis] =
+                static_cast<float>((p[3] - p[2]) / (u[3] - u[2]));
+        }
+        return true;
+    }
+
+    size_t RenderManager::GetNumRenderRegions() const {
+        return m_multiResolution.enabled ? 9 : 1;
+    }
+
+    bool RenderManager::GetRenderRegion(const RenderInfo& eyeInfo,
+                                        size_t region,
+                                        RenderInfo& regionOut) const {
+        if (region >= GetNumRenderRegions()) {
+            return false;
+        }
+        regionOut = eyeInfo;
+        if (!m_multiResolution.enabled) {
+            return true;
+        }
+
+        // The region's part of the eye's viewport, which may be scaled
+        // down from the packed texture, with its edges on whole pixels so
+        // that neighboring regions meet.  Its part of the frustum is
+        // linear in the whole eye's texture coordinates.
+        // Where viewports are measured from the top of the texture, the
+        // rows are placed in it from the top; the layout is symmetric, so
+        // only the order changes.
+        size_t column = region % 3;
+        size_t row = region / 3;
+        size_t viewportRow = ViewportOriginIsTop() ? 2 - row : row;
+        const OSVR_ViewportDescription& v = eyeInfo.viewport;
+        const MultiResolutionLayout& l = m_multiResolution;
+        double left = std::floor(v.left + l.packed[0][column] * v.width + 0.5);
+        double right =
+            std::floor(v.left + l.packed[0][column + 1] * v.width + 0.5);
+        double lower =
+            std::floor(v.lower + l.packed[1][viewportRow] * v.height + 0.5);
+        double upper = std::floor(
+            v.lower + l.packed[1][viewportRow + 1] * v.height + 0.5);
+        regionOut.viewport.left = left;
+        regionOut.viewport.lower = lower;
+        regionOut.viewport.width = right - left;
+        regionOut.viewport.height = upper - lower;
+
+        const OSVR_ProjectionMatrix& p = eyeInfo.projection;
+        double width = p.right - p.left;
+        double height = p.top - p.bottom;
+        regionOut.projection.left = p.left + l.unpacked[0][column] * width;
+        regionOut.projection.right =
+            p.left + l.unpacked[0][column + 1] * width;
+        regionOut.projection.bottom = p.bottom + l.unpacked[1][row] * height;
+        regionOut.projection.top = p.bottom + l.unpacked[1][row + 1] * height;
+        return true;
+    }
+
+    std::vector<RenderManager::MultiResolutionPixelCounts>
+    RenderManager::GetMultiResolutionPixelCounts() {
+        const ConstructorParameters::Multi_Resolution_Profile profiles[] = {
+            ConstructorParameters::MultiResolution_Off,
+            ConstructorParameters::MultiResolution_Conservative,
+            ConstructorParameters::MultiResolution_Balanced,
+            ConstructorParameters::MultiResolution_Aggressive,
+            ConstructorParameters::MultiResolution_Custom};
+        std::vector<MultiResolutionPixelCounts> ret;
+        for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+            MultiResolutionLayout layout;
+            ComputeMultiResolutionLayout(
+                profiles[i], m_multiResolution.unpackedSize[0],
+                m_multiResolution.unpackedSize[1], layout);
+            MultiResolutionPixelCounts counts;
+            counts.profile = profiles[i];
+            counts.fullPixels = GetNumEyes() *
+                                static_cast<size_t>(layout.unpackedSize[0]) *
+                                static_cast<size_t>(layout.unpackedSize[1]);
+            counts.renderedPixels = GetNumEyes() *
+                                    static_cast<size_t>(layout.packedSize[0]) *
+                                    static_cast<size_t>(layout.packedSize[1]);
+            ret.push_back(counts);
+        }
+        return ret;
+    }
+
+    RenderManager::OverfillMargins
+    RenderManager::GetOverfillMargins(size_t eye) const {
+        if (eye < m_overfillMargins.size()) {
+            return m_overfillMargins[eye];
+        }
+        double margin = (m_params.m_renderOverfillFactor - 1) / 2;
+        OverfillMargins ret = {margin, margin, margin, margin};
+        return ret;
+    }
+
+    void RenderManager::ComputeTightOverfill() {
+        m_overfillMargins.clear();
+        if (!m_params.m_tightOverfill) {
+            return;
+        }
+        size_t numEyes = GetNumEyes();
+        if (m_params.m_distortionParameters.size() < numEyes) {
+            std::cerr << "RenderManager::ComputeTightOverfill: No distortion "
+                         "parameters, using the overfill factor"
+                      << std::endl;
+            return;
+        }
+
+        // With no overfill, the texture coordinates of the mesh are in
+        // the space of the screen, with (0,0) and (1,1) at its corners.
+        // The mesh samples between its vertices linearly, so the bounds
+        // of their coordinates are the bounds of what it samples.
+        OverfillMargins none = {0, 0, 0, 0};
+        m_overfillMargins.assign(numEyes, none);
+        std::vector<OverfillMargins> margins(numEyes);
+        float timeWarpMargin = m_params.m_enableTimeWarp
+                                   ? m_params.m_tightOverfillTimeWarpMargin
+                                   : 0.0f;
+        double size[2] = {0, 0};
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            std::vector<DistortionMeshVertex> mesh = ComputeDistortionMesh(
+                eye, SQUARE, m_params.m_distortionParameters[eye]);
+            if (mesh.empty()) {
+                std::cerr << "RenderManager::ComputeTightOverfill: Could not "
+                             "construct distortion mesh, using the overfill "
+                             "factor"
+                          << std::endl;
+                m_overfillMargins.clear();
+                return;
+            }
+            float low[2] = {mesh[0].m_texRed[0], mesh[0].m_texRed[1]};
+            float high[2] = {low[0], low[1]};
+            for (size_t v = 0; v < mesh.size(); v++) {
+                const Float2* coords[] = {&mesh[v].m_texRed,
+                                          &mesh[v].m_texGreen,
+                                          &mesh[v].m_texBlue};
+                for (size_t c = 0; c < 3; c++) {
+                    for (int axis = 0; axis < 2; axis++) {
+                        low[axis] = std::min(low[axis], (*coords[c])[axis]);
+                        high[axis] = std::max(high[axis], (*coords[c])[axis]);
+                    }
+                }
+            }
+            OverfillMargins& m = margins[eye];
+            m.left = timeWarpMargin - low[0];
+            m.right = high[0] - 1 + timeWarpMargin;
+            m.bottom = timeWarpMargin - low[1];
+            m.top = high[1] - 1 + timeWarpMargin;
+            double eyeSize[2] = {1 + m.left + m.right, 1 + m.bottom + m.top};
+            if (eyeSize[0] <= 0 || eyeSize[1] <= 0) {
+                std::cerr << "RenderManager::ComputeTightOverfill: Distortion "
+                             "mesh samples nothing, using the overfill factor"
+                          << std::endl;
+                m_overfillMargins.clear();
+                return;
+            }
+            size[0] = std::max(size[0], eyeSize[0]);
+            size[1] = std::max(size[1], eyeSize[1]);
+        }
+
+        // Grow the smaller eyes evenly to the size of the largest, so that
+        // they can share render textures.
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            OverfillMargins& m = margins[eye];
+            double xExtra = (size[0] - (1 + m.left + m.right)) / 2;
+            double yExtra = (size[1] - (1 + m.bottom + m.top)) / 2;
+            m.left += xExtra;
+            m.right += xExtra;
+            m.bottom += yExtra;
+            m.top += yExtra;
+        }
+        m_overfillMargins.swap(margins);
+        InvalidateEyeTransforms();
+    }
+
+    void RenderManager::ComputeHiddenArea(
+        const std::vector<DistortionMeshVertex>& mesh,
+        std::vector<OSVR_ViewportDescription>& rects) {
+        rects.clear();
+        if (mesh.size() < 3) {
+            return;
+        }
+
+        // Mark the cells of the grid that each triangle may sample from,
+        // using the bounds of its texture coordinates for all three
+        // colors.  These are grown by the time-warp margin and by a cell
+        // on each side, which covers the texels next to the ones sampled
+        // that bilinear filtering reads.
+        const int n = HIDDEN_AREA_GRID_SIZE;
+        float margin = m_params.m_enableTimeWarp
+                           ? m_params.m_hiddenAreaTimeWarpMargin
+                           : 0.0f;
+        auto cell = [n](float t) {
+            float c = std::floor(t * n);
+            return static_cast<int>(
+                std::max(-1.0f, std::min(static_cast<float>(n), c)));
+        };
+        std::vector<bool> sampled(n * n, false);
+        for (size_t tri = 0; tri + 2 < mesh.size(); tri += 3) {
+            float low[2] = {mesh[tri].m_texRed[0], mesh[tri].m_texRed[1]};
+            float high[2] = {low[0], low[1]};
+            for (size_t vert = tri; vert < tri + 3; vert++) {
+                const Float2* coords[] = {&mesh[vert].m_texRed,
+                                          &mesh[vert].m_texGreen,
+                                          &mesh[vert].m_texBlue};
+                for (size_t c = 0; c < 3; c++) {
+                    for (int axis = 0; axis < 2; axis++) {
+                        low[axis] = std::min(low[axis], (*coords[c])[axis]);
+                        high[axis] = std::max(high[axis], (*coords[c])[axis]);
+                    }
+                }
+            }
+            int first[2], last[2];
+            for (int axis = 0; axis < 2; axis++) {
+                first[axis] = std::max(cell(low[axis] - margin) - 1, 0);
+                last[axis] = std::min(cell(high[axis] + margin) + 1, n - 1);
+            }
+            for (int y = first[1]; y <= last[1]; y++) {
+                for (int x = first[0]; x <= last[0]; x++) {
+                    sampled[y * n + x] = true;
+                }
+            }
+        }
+
+        // When rendering at multiple resolutions, the eye's coordinates
+        // are packed in the texture.  This maps rectangles to rectangles.
+        const MultiResolutionLayout& l = m_multiResolution;
+        auto pack = [&l](int axis, double t) -> double {
+            if (!l.enabled) {
+                return t;
+            }
+            int k = 0;
+            while (k < 2 && t > l.unpacked[axis][k + 1]) {
+                k++;
+            }
+            const double* u = l.unpacked[axis];
+            const double* p = l.packed[axis];
+            return p[k] + (t - u[k]) * (p[k + 1] - p[k]) / (u[k + 1] - u[k]);
+        };
+
+        // Gather the cells that are never sampled into rectangles: each
+        // run of them along a row is extended up through the rows after
+        // it that have the same run.
+        struct Run {
+            int begin, end, firstRow;
+        };
+        std::vector<Run> open, next;
+        for (int y = 0; y <= n; y++) {
+            next.clear();
+            for (int x = 0; y < n && x < n;) {
+                if (sampled[y * n + x]) {
+                    x++;
+                    continue;
+                }
+                Run run = {x, x, y};
+                while (run.end < n && !sampled[y * n + run.end]) {
+                    run.end++;
+                }
+                x = run.end;
+                for (size_t i = 0; i < open.size(); i++) {
+                    if (open[i].begin == run.begin && open[i].end == run.end) {
+                        run.firstRow = open[i].firstRow;
+                        break;
+                    }
+                }
+                next.push_back(run);
+            }
+            for (size_t i = 0; i < open.size(); i++) {
+                bool continued = false;
+                for (size_t j = 0; j < next.size() && !continued; j++) {
+                    continued = next[j].begin == open[i].begin &&
+                                next[j].end == open[i].end;
+                }
+                if (!continued) {
+                    const Run& run = open[i];
+                    OSVR_ViewportDescription r;
+                    r.left = pack(0, static_cast<double>(run.begin) / n);
+                    r.lower = pack(1, static_cast<double>(run.firstRow) / n);
+                    r.width =
+                        pack(0, static_cast<double>(run.end) / n) - r.left;
+                    r.height = pack(1, static_cast<double>(y) / n) - r.lower;
+                    rects.push_back(r);
+                }
+            }
+            open.swap(next);
+        }
+    }
+
+    bool RenderManager::GetHiddenAreaMesh(size_t eye,
+                                          std::vector<Float2>& triangles) {
+        triangles.clear();
+        std::lock_guard<std::mutex> lock(m_hiddenAreaLock);
+        if (eye >= m_hiddenAreas.size()) {
+            return false;
+        }
+        const std::vector<OSVR_ViewportDescription>& rects =
+            m_hiddenAreas[eye];
+        for (size_t i = 0; i < rects.size(); i++) {
+            float left = static_cast<float>(rects[i].left);
+            float lower = static_cast<float>(rects[i].lower);
+            float right = static_cast<float>(rects[i].left + rects[i].width);
+            float upper = static_cast<float>(rects[i].lower + rects[i].height);
+            Float2 corners[] = {{{left, lower}},
+                                {{right, lower}},
+                                {{right, upper}},
+                                {{left, upper}}};
+            const size_t order[] = {0, 1, 2, 0, 2, 3};
+            for (size_t v = 0; v < 6; v++) {
+                triangles.push_back(corners[order[v]]);
+            }
+        }
         return true;
     }
 
@@ -1253,139 +2213,220 @@ namespace renderkit {
             return false;
         }
 
-        /// @todo Replace all of the quatlib math with Eigen math below,
-        /// or with direct calls to the core library.
+        FramePoses poses;
+        ConstructFramePoses(params, poses);
+        return ComposeModelView(poses, whichSpace, whichEye, eyeFromSpace);
+    }
+
+    const RenderManager::EyeTransforms&
+    RenderManager::GetEyeTransforms(const RenderParams& params) {
+        bool rebuild = !m_eyeTransformsValid;
+        if (rebuild) {
+            ConstructUnitFrusta();
+        }
+        EyeTransforms& t = m_eyeTransforms;
+        size_t numEyes = GetNumEyes();
+
+        // Recompute headFromEye only when the IPD changes.
+        if (rebuild || (t.headFromEye.size() != numEyes) ||
+            (params.IPDMeters != t.IPDMeters)) {
+            t.IPDMeters = params.IPDMeters;
+            t.headFromEye.resize(numEyes);
+
+            /// Include the impact of rotating the screen around the
+            // eye location for HMDs who have this feature.  This is
+            // computed in terms of the percent overlap of the screen.
+            // We rotate each eye away from the other by half of the
+            // amount they should not overlap.  NOTE: This assumes
+            // that both eyes are at the same location w.r.t. the
+            // overlap percent.
+            // @todo Verify this assumption.
+            double rotateEyesApart = 0;
+            double overlapFrac =
+                m_params.m_displayConfiguration.getOverlapPercent();
+            if (overlapFrac < 1.) {
+                const auto hfov =
+                    m_params.m_displayConfiguration.getHorizontalFOV();
+                const auto angularOverlap = hfov * overlapFrac;
+                rotateEyesApart =
+                    util::getDegrees((hfov - angularOverlap) / 2.);
+            }
+            rotateEyesApart = Q_DEG_TO_RAD(rotateEyesApart);
+
+            for (size_t eye = 0; eye < numEyes; eye++) {
+                // Right eyes should rotate the other way.
+                Pose rotatedEyeFromEye = posemath::fromAxisAngle<double>(
+                    Pose::Vector::UnitY(),
+                    (eye % 2 != 0) ? -rotateEyesApart : rotateEyesApart);
+
+                /// Include the impact of the eyeFromHead matrix.
+                // This is a translation along the X axis in head space by
+                // the IPD, or its negation, depending on the eye.
+                // We assume that even eyes are left eyes and odd eyes are
+                // right eyes.  We further assume that head space is
+                // between the two eyes.  If the display descriptor wants
+                // us to swap eyes, we do so by inverting the offset for
+                // each eye.
+                Pose headFromRotatedEye = posemath::identity<double>();
+                if (eye % 2 == 0) {
+                    // Left eye
+                    headFromRotatedEye.translation.x() -= params.IPDMeters / 2;
+                } else {
+                    // Right eye
+                    headFromRotatedEye.translation.x() += params.IPDMeters / 2;
+                }
+                posemath::toOSVR(t.headFromEye[eye],
+                                 posemath::compose(headFromRotatedEye,
+                                                   rotatedEyeFromEye));
+            }
+        }
+
+        // Recompute the projections only when the clip planes change.
+        if (rebuild || (t.projection.size() != numEyes) ||
+            (params.nearClipDistanceMeters != t.nearClipDistanceMeters) ||
+            (params.farClipDistanceMeters != t.farClipDistanceMeters)) {
+            t.nearClipDistanceMeters = params.nearClipDistanceMeters;
+            t.farClipDistanceMeters = params.farClipDistanceMeters;
+            t.projection.resize(numEyes);
+            t.projectionsOkay = true;
+            for (size_t eye = 0; eye < numEyes; eye++) {
+                if (!ConstructProjection(eye, params.nearClipDistanceMeters,
+                                         params.farClipDistanceMeters,
+                                         t.projection[eye])) {
+                    t.projectionsOkay = false;
+                }
+            }
+        }
+
+        return t;
+    }
 
+    void RenderManager::ConstructFramePoses(const RenderParams& params,
+                                            FramePoses& poses) {
         /// We need to determine the transformation that takes points
         /// in the space we're going to render in and moves them into
         /// the space described by the projection matrix.  That space
         /// is eye space, which has the eye at the origin, X to the
         /// right, Y up, and Z pointing into the camera (opposite to
-        /// the viewing direction).
-
-        /// Include the impact of rotating the screen around the
-        // eye location for HMDs who have this feature.  This is
-        // computed in terms of the percent overlap of the screen.
-        // We rotate each eye away from the other by half of the
-        // amount they should not overlap.  NOTE: This assumes
-        // that both eyes are at the same location w.r.t. the
-        // overlap percent.
-        // @todo Verify this assumption.
-        q_xyz_quat_type q_rotatedEyeFromEye;
-        makeIdentity(q_rotatedEyeFromEye);
-        double rotateEyesApart = 0;
-        double overlapFrac =
-            m_params.m_displayConfiguration.getOverlapPercent();
-        if (overlapFrac < 1.) {
-            const auto hfov =
-                m_params.m_displayConfiguration.getHorizontalFOV();
-            const auto angularOverlap = hfov * overlapFrac;
-            rotateEyesApart = util::getDegrees((hfov - angularOverlap) / 2.);
-        }
-        // Right eyes should rotate the other way.
-        if (whichEye % 2 != 0) {
-            rotateEyesApart *= -1;
-        }
-        rotateEyesApart = Q_DEG_TO_RAD(rotateEyesApart);
-        q_from_axis_angle(q_rotatedEyeFromEye.quat, 0, 1, 0, rotateEyesApart);
-
-        /// Include the impact of the eyeFromHead matrix.
-        // This is a translation along the X axis in head space by
-        // the IPD, or its negation, depending on the eye.
-        // We assume that even eyes are left eyes and odd eyes are
-        // right eyes.  We further assume that head space is between
-        // the two eyes.  If the display descriptor wants us to swap
-        // eyes, we do so by inverting the offset for each eye.
-        q_xyz_quat_type q_headFromRotatedEye;
-        makeIdentity(q_headFromRotatedEye);
-        if (whichEye % 2 == 0) {
-            // Left eye
-            q_headFromRotatedEye.xyz[Q_X] -= params.IPDMeters / 2;
-        } else {
-            // Right eye
-            q_headFromRotatedEye.xyz[Q_X] += params.IPDMeters / 2;
+        /// the viewing direction).  Everything but the pose of the space
+        /// itself is the same for all spaces, so we compute it once per
+        /// eye here and compose it with each space's pose as needed.
+
+        /// Use the state interface to read the most-recent
+        /// location of the head.  It will have been updated
+        /// by the most-recent call to update() on the context.
+        /// It is recorded even if it is replaced below, so that a
+        /// latched frame can be recomputed with other parameters.
+        OSVR_TimeValue timestamp;
+        if (osvrGetPoseState(m_roomFromHeadInterface, &timestamp,
+                             &m_roomFromHead) == OSVR_RETURN_FAILURE) {
+            // This it not an error -- they may have put in an invalid
+            // state name for the head; we just ignore that case.
         }
-        q_xyz_quat_type q_headFromEye;
-        q_xyz_quat_compose(&q_headFromEye, &q_headFromRotatedEye,
-                           &q_rotatedEyeFromEye);
+        poses.trackedRoomFromHead = m_roomFromHead;
 
         /// Include the impact of RenderParams.headFromRoom
         /// (which will override m_headFromRoom) or of m_headFromRoom.
-        q_xyz_quat_type q_roomFromHead;
+        Pose roomFromHead;
         if (params.roomFromHeadReplace != nullptr) {
             /// Use the params.m_headFromRoom as our transform
-            q_from_OSVR(q_roomFromHead, *params.roomFromHeadReplace);
+            roomFromHead =
+                posemath::fromOSVR<double>(*params.roomFromHeadReplace);
         } else {
-            /// Use the state interface to read the most-recent
-            /// location of the head.  It will have been updated
-            /// by the most-recent call to update() on the context.
-            OSVR_TimeValue timestamp;
-            if (osvrGetPoseState(m_roomFromHeadInterface, &timestamp,
-                                 &m_roomFromHead) == OSVR_RETURN_FAILURE) {
-                // This it not an error -- they may have put in an invalid
-                // state name for the head; we just ignore that case.
+            roomFromHead = posemath::fromOSVR<double>(m_roomFromHead);
+        }
+
+        /// Include the impact of roomFromWorld, if it is specified.
+        /// This is only applied for world space; the other OSVR spaces
+        /// use eyeFromRoom so we don't need to undo it again on the way
+        /// back from room space.
+        Pose worldFromRoom = posemath::identity<double>();
+        if (params.worldFromRoomAppend != nullptr) {
+            worldFromRoom =
+                posemath::fromOSVR<double>(*params.worldFromRoomAppend);
+        }
+
+        const EyeTransforms& eyes = GetEyeTransforms(params);
+        size_t numEyes = eyes.headFromEye.size();
+        poses.eyeFromWorld.resize(numEyes);
+        poses.eyeFromRoom.resize(numEyes);
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            Pose headFromEye =
+                posemath::fromOSVR<double>(eyes.headFromEye[eye]);
+            Pose roomFromEye = posemath::compose(roomFromHead, headFromEye);
+            Pose worldFromEye = posemath::compose(worldFromRoom, roomFromEye);
+
+            /// Invert the above matrices, to produce eyeFromRoom and
+            /// eyeFromWorld.
+            posemath::toOSVR(poses.eyeFromRoom[eye],
+                             posemath::invert(roomFromEye));
+            posemath::toOSVR(poses.eyeFromWorld[eye],
+                             posemath::invert(worldFromEye));
+        }
+
+        /// Read the pose of each callback space.  If we have a NULL
+        /// interface pointer, the space is world space.
+        poses.spaces.resize(m_callbacks.size());
+        for (size_t i = 0; i < m_callbacks.size(); i++) {
+            FramePoses::Space& space = poses.spaces[i];
+            space.inWorldSpace = (m_callbacks[i].m_interface == nullptr);
+            space.valid = true;
+            if (!space.inWorldSpace) {
+                OSVR_TimeValue timestamp;
+                space.valid =
+                    osvrGetPoseState(m_callbacks[i].m_interface, &timestamp,
+                                     &m_callbacks[i].m_state) !=
+                    OSVR_RETURN_FAILURE;
             }
-            q_from_OSVR(q_roomFromHead, m_roomFromHead);
+            space.roomFromSpace = m_callbacks[i].m_state;
+        }
+    }
+
+    bool RenderManager::ComposeModelView(const FramePoses& poses,
+                                         size_t whichSpace, size_t whichEye,
+                                         OSVR_PoseState& eyeFromSpace) const {
+        /// Set the identity transformation to start with, in case
+        /// we have to bail out with an error condition below.
+        osvrPose3SetIdentity(&eyeFromSpace);
+
+        // Make sure that we have as many eyes as were asked for.
+        if (whichEye >= poses.eyeFromWorld.size()) {
+            std::cerr << "RenderManager::ComposeModelView(): Eye index "
+                      << "out of bounds" << std::endl;
+            return false;
         }
-        q_xyz_quat_type q_roomFromEye;
-        q_xyz_quat_compose(&q_roomFromEye, &q_roomFromHead, &q_headFromEye);
 
         // See if we are making a transform for world space.
         // If don't have a callback defined for this space, we're in
         // world space.  This is used by GetRenderInfo() and
         // PresentRenderBuffers() to get its world-space matrix.
-        // If we have a NULL interface pointer, we are
-        // in world space.
-        bool inWorldSpace = (whichSpace >= m_callbacks.size()) ||
-                            (m_callbacks[whichSpace].m_interface == nullptr);
-
-        /// Include the impact of roomFromWorld, if it is specified.
-        /// If we are not going into world space, but rather into one
-        /// of the other OSVR spaces, then just leave this as the identity
-        /// transform so we don't need to undo it again on the way
-        /// back from room space.
-        q_xyz_quat_type q_worldFromRoom;
-        makeIdentity(q_worldFromRoom);
-        if (inWorldSpace && (params.worldFromRoomAppend != nullptr)) {
-            q_from_OSVR(q_worldFromRoom, *params.worldFromRoomAppend);
+        if ((whichSpace >= poses.spaces.size()) ||
+            poses.spaces[whichSpace].inWorldSpace) {
+            eyeFromSpace = poses.eyeFromWorld[whichEye];
+            return true;
         }
-        q_xyz_quat_type q_worldFromEye;
-        q_xyz_quat_compose(&q_worldFromEye, &q_worldFromRoom, &q_roomFromEye);
 
-        /// Invert the above matrices, to produce eyeFromWorld.
-        q_xyz_quat_type q_eyeFromWorld;
-        q_xyz_quat_invert(&q_eyeFromWorld, &q_worldFromEye);
+        // They asked for a space that does not exist.  Return false to
+        // let them know we didn't get the one they wanted.
+        const FramePoses::Space& space = poses.spaces[whichSpace];
+        if (!space.valid) {
+            return false;
+        }
 
         /// Include the impact of the space we're rendering to.
         /// This is spaceFromRoom; put on the right and multiply it on
-        /// the left by the above inverted matrix.  (If we are going
-        /// into one of these spaces, worldFromRoom will be the
-        /// identity so we don't need to invert and reapply it.)
-        q_xyz_quat_type q_worldFromSpace;
-        if (inWorldSpace) {
-            makeIdentity(q_worldFromSpace);
-        } else {
-            OSVR_TimeValue timestamp;
-            if (osvrGetPoseState(
-                    m_callbacks[whichSpace].m_interface, &timestamp,
-                    &m_callbacks[whichSpace].m_state) == OSVR_RETURN_FAILURE) {
-                // They asked for a space that does not exist.  Return false to
-                // let them know we didn't get the one they wanted.
-                return false;
-            }
-            q_from_OSVR(q_worldFromSpace, m_callbacks[whichSpace].m_state);
-        }
-        q_xyz_quat_type q_eyeFromSpace;
-        q_xyz_quat_compose(&q_eyeFromSpace, &q_eyeFromWorld, &q_worldFromSpace);
-
-        /// Store the result into the output pose
-        OSVR_from_q(eyeFromSpace, q_eyeFromSpace);
+        /// the left by eyeFromRoom.
+        posemath::toOSVR(
+            eyeFromSpace,
+            posemath::compose(
+                posemath::fromOSVR<double>(poses.eyeFromRoom[whichEye]),
+                posemath::fromOSVR<double>(space.roomFromSpace)));
         return true;
     }
 
     bool RenderManager::ComputeAsynchronousTimeWarps(
-        std::vector<RenderInfo> usedRenderInfo,
-        std::vector<RenderInfo> currentRenderInfo, float assumedDepth) {
+        const std::vector<RenderInfo>& usedRenderInfo,
+        const std::vector<RenderInfo>& currentRenderInfo, float assumedDepth) {
         // Empty out the ATW vector until we fill it again below.
         m_asynchronousTimeWarps.clear();
 
@@ -1461,56 +2502,14 @@ namespace renderkit {
             Eigen::Affine3f postProjectionTranslate(
                 Eigen::Translation3f(-xTrans, -yTrans, -zTrans));
 
-            /// Compute the forward last ModelView matrix.
-            OSVR_PoseState lastModelOSVR = usedRenderInfo[eye].pose;
-            Eigen::Quaternionf lastModelViewRotation(
-                static_cast<float>(osvrQuatGetW(&lastModelOSVR.rotation)),
-                static_cast<float>(osvrQuatGetX(&lastModelOSVR.rotation)),
-                static_cast<float>(osvrQuatGetY(&lastModelOSVR.rotation)),
-                static_cast<float>(osvrQuatGetZ(&lastModelOSVR.rotation)));
-            Eigen::Affine3f lastModelViewTranslation(Eigen::Translation3f(
-                static_cast<float>(osvrVec3GetX(&lastModelOSVR.translation)),
-                static_cast<float>(osvrVec3GetY(&lastModelOSVR.translation)),
-                static_cast<float>(osvrVec3GetZ(&lastModelOSVR.translation))));
-            // Pull the translation out from above and then plop in the rotation
-            // matrix parts by hand.
-            Eigen::Matrix3f lastRot3 = lastModelViewRotation.toRotationMatrix();
-            Eigen::Matrix4f lastModelView = lastModelViewTranslation.matrix();
-            for (size_t i = 0; i < 3; i++) {
-                for (size_t j = 0; j < 3; j++) {
-                    lastModelView(i, j) = lastRot3(i, j);
-                }
-            }
-            Eigen::Projective3f lastModelViewTransform(lastModelView);
-
-            /// Compute the inverse of the current ModelView matrix.
-            OSVR_PoseState currentModelOSVR = currentRenderInfo[eye].pose;
-            Eigen::Quaternionf currentModelViewRotation(
-                static_cast<float>(osvrQuatGetW(&currentModelOSVR.rotation)),
-                static_cast<float>(osvrQuatGetX(&currentModelOSVR.rotation)),
-                static_cast<float>(osvrQuatGetY(&currentModelOSVR.rotation)),
-                static_cast<float>(osvrQuatGetZ(&currentModelOSVR.rotation)));
-            Eigen::Affine3f currentModelViewTranslation(Eigen::Translation3f(
-                static_cast<float>(osvrVec3GetX(&currentModelOSVR.translation)),
-                static_cast<float>(osvrVec3GetY(&currentModelOSVR.translation)),
-                static_cast<float>(
-                    osvrVec3GetZ(&currentModelOSVR.translation))));
-            // Pull the translation out from above and then plop in the rotation
-            // matrix parts by hand.
-            // @todo turn this into a transform catenation in the proper order.
-            Eigen::Matrix3f curRot3 =
-                currentModelViewRotation.toRotationMatrix();
-            Eigen::Matrix4f currentModelView =
-                currentModelViewTranslation.matrix();
-            for (size_t i = 0; i < 3; i++) {
-                for (size_t j = 0; j < 3; j++) {
-                    currentModelView(i, j) = curRot3(i, j);
-                }
-            }
+            /// Compute the forward last ModelView matrix and the inverse of
+            /// the current one.  Inverting the pose rather than the 4x4
+            /// matrix is both cheaper and more accurate.
+            Eigen::Matrix4f lastModelView = posemath::toMatrix(
+                posemath::fromOSVR<float>(usedRenderInfo[eye].pose));
             Eigen::Matrix4f currentModelViewInverse =
-                currentModelView.inverse();
-            Eigen::Projective3f currentModelViewInverseTransform(
-                currentModelViewInverse);
+                posemath::toMatrix(posemath::invert(
+                    posemath::fromOSVR<float>(currentRenderInfo[eye].pose)));
 
             /// Translate the origin to the center of the projected rectangle
             Eigen::Affine3f preProjectionTranslate(
@@ -1598,6 +2597,107 @@ namespace renderkit {
         return true;
     }
 
+    static bool sameViewport(const OSVR_ViewportDescription& a,
+                             const OSVR_ViewportDescription& b) {
+        return a.left == b.left && a.lower == b.lower && a.width == b.width &&
+               a.height == b.height;
+    }
+
+    const RenderManager::PresentEyeTransforms*
+    RenderManager::GetPresentEyeTransforms(const PresentEyeParameters& params,
+                                           bool swapEyes) {
+        if (params.m_index >= GetNumEyes()) {
+            std::cerr << "RenderManager::GetPresentEyeTransforms: Eye "
+                      << params.m_index << " out of range" << std::endl;
+            return nullptr;
+        }
+        if (m_presentEyeTransforms.size() < GetNumEyes()) {
+            m_presentEyeTransforms.resize(GetNumEyes());
+        }
+
+        // Reuse what we computed last time if nothing it depends on has
+        // changed.
+        CachedPresentEyeTransforms& cached =
+            m_presentEyeTransforms[params.m_index];
+        if (cached.valid && cached.rotateDegrees == params.m_rotateDegrees &&
+            cached.flipInY == params.m_flipInY &&
+            cached.swapEyes == swapEyes &&
+            sameViewport(cached.normalizedCroppingViewport,
+                         params.m_normalizedCroppingViewport)) {
+            return &cached.transforms;
+        }
+        cached.valid = false;
+        PresentEyeTransforms& t = cached.transforms;
+
+        // Construct the viewport based on which eye this is, then adjust it
+        // based on how much the display window is rotated with respect to
+        // the rendering window.
+        if (!ConstructViewportForPresent(params.m_index, t.viewport,
+                                         swapEyes)) {
+            std::cerr << "RenderManager::GetPresentEyeTransforms: Could not "
+                         "construct viewport"
+                      << std::endl;
+            return nullptr;
+        }
+        t.viewport = RotateViewport(t.viewport);
+
+        // Set up a Projection matrix that undoes the scale factor applied
+        // due to our rendering overfill factor.  This will put only the part
+        // of the geometry that should be visible inside the viewing frustum.
+        // @todo think about how we get square pixels, to properly handle
+        // distortion correction.
+        OverfillMargins margins = GetOverfillMargins(params.m_index);
+        float xScale = static_cast<float>(1 + margins.left + margins.right);
+        float yScale = static_cast<float>(1 + margins.bottom + margins.top);
+        Eigen::Matrix4f overfill = Eigen::Matrix4f::Identity();
+        overfill(0, 0) = xScale;
+        overfill(1, 1) = yScale;
+        overfill(0, 3) = xScale - 1 - 2 * static_cast<float>(margins.left);
+        overfill(1, 3) = yScale - 1 - 2 * static_cast<float>(margins.bottom);
+
+        // Set up a ModelView matrix that handles rotating and flipping the
+        // geometry as needed to match the display scan-out circuitry and/or
+        // any changes needed by the inversion of window coordinates when
+        // switching between graphics systems.
+        if (!ComputeDisplayOrientationMatrix(
+                static_cast<float>(params.m_rotateDegrees), params.m_flipInY,
+                t.modelView)) {
+            std::cerr << "RenderManager::GetPresentEyeTransforms: "
+                         "ComputeDisplayOrientationMatrix failed"
+                      << std::endl;
+            return nullptr;
+        }
+
+        // Map the texture coordinates to the part of the render buffer that
+        // holds this eye.
+        if (!ComputeRenderBufferCropMatrix(params.m_normalizedCroppingViewport,
+                                           t.crop)) {
+            std::cerr << "RenderManager::GetPresentEyeTransforms: "
+                         "ComputeRenderBufferCropMatrix failed"
+                      << std::endl;
+            return nullptr;
+        }
+
+        // Scale and shift the geometry so that the margins of the render
+        // buffer fall off the edges of the display.  The margins are
+        // around the unrotated eye, so this is done before the ModelView
+        // matrix rotates it.
+        Eigen::Map<Eigen::Matrix4f> modelView(t.modelView.data);
+        Eigen::Map<Eigen::Matrix4f> projection(t.projection.data);
+        projection = modelView * overfill * modelView.inverse();
+
+        cached.rotateDegrees = params.m_rotateDegrees;
+        cached.flipInY = params.m_flipInY;
+        cached.swapEyes = swapEyes;
+        cached.normalizedCroppingViewport = params.m_normalizedCroppingViewport;
+        cached.valid = true;
+        return &t;
+    }
+
+    void RenderManager::InvalidatePresentEyeTransforms() {
+        m_presentEyeTransforms.clear();
+    }
+
     static double pointDistance(double x1, double y1, double x2, double y2) {
         return std::sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
     }
@@ -1760,14 +2860,18 @@ namespace renderkit {
         using Eigen::Vector2f;
         // Convert from coordinates in the overfilled texture to coordinates
         // that will cover the range (0,0) to (1,1) on the screen.  This is
-        // done by scaling around (0.5,0.5) to push the edges of the screen
-        // out to the (0,0) and (1,1) boundaries.
+        // done by scaling and shifting to push the edges of the screen
+        // out past the margins to the (0,0) and (1,1) boundaries.
         Eigen::Map<Vector2f> retMap(ret.data());
         Eigen::Map<const Vector2f> inMap(inCoords.data());
 
-        Vector2f xyN = (inMap - Vector2f::Constant(0.5f)) *
-                           m_params.m_renderOverfillFactor +
-                       Vector2f::Constant(0.5f);
+        OverfillMargins margins = GetOverfillMargins(eye);
+        Vector2f overfillSize(
+            static_cast<float>(1 + margins.left + margins.right),
+            static_cast<float>(1 + margins.bottom + margins.top));
+        Vector2f overfillOffset(static_cast<float>(margins.left),
+                                static_cast<float>(margins.bottom));
+        Vector2f xyN = inMap.cwiseProduct(overfillSize) - overfillOffset;
         /// these are for mono point that hasn't been ported to eigen yet.
         float x = inCoords[0];
         float y = inCoords[1];
@@ -1895,12 +2999,61 @@ namespace renderkit {
         }
 
         // Convert from unit (normalized) space back into overfill space.
-        ret[0] = (ret[0] - 0.5f) / m_params.m_renderOverfillFactor + 0.5f;
-        ret[1] = (ret[1] - 0.5f) / m_params.m_renderOverfillFactor + 0.5f;
+        ret[0] = (ret[0] + overfillOffset.x()) / overfillSize.x();
+        ret[1] = (ret[1] + overfillOffset.y()) / overfillSize.y();
 
         return ret;
     }
 
+    std::vector<RenderManager::DistortionMeshVertex>
+    RenderManager::GetDistortionMesh(
+        size_t eye, DistortionMeshType type,
+        std::vector<DistortionParameters> const& distort) {
+        std::vector<DistortionMeshVertex> mesh;
+        if ((m_precomputedMeshes.distort == &distort) &&
+            (m_precomputedMeshes.type == type) &&
+            (eye < m_precomputedMeshes.meshes.size())) {
+            mesh = std::move(m_precomputedMeshes.meshes[eye]);
+        } else if (eye < distort.size()) {
+            mesh = ComputeDistortionMesh(eye, type, distort[eye]);
+        }
+
+        // Every renderer gets its meshes from here, so this is where we
+        // find the parts of the eye that the new mesh never samples.
+        std::vector<OSVR_ViewportDescription> hiddenArea;
+        ComputeHiddenArea(mesh, hiddenArea);
+        std::lock_guard<std::mutex> lock(m_hiddenAreaLock);
+        if (m_hiddenAreas.size() < distort.size()) {
+            m_hiddenAreas.resize(distort.size());
+        }
+        if (eye < m_hiddenAreas.size()) {
+            m_hiddenAreas[eye].swap(hiddenArea);
+        }
+        return mesh;
+    }
+
+    /// Is this a polynomial that maps each radius to itself?
+    static bool polynomialIsIdentity(const std::vector<float>& poly) {
+        if (poly.size() < 2 || poly[0] != 0 || poly[1] != 1) {
+            return false;
+        }
+        for (size_t i = 2; i < poly.size(); i++) {
+            if (poly[i] != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool
+    RenderManager::DistortionIsIdentity(const DistortionParameters& distort) {
+        return distort.m_type ==
+                   DistortionParameters::rgb_symmetric_polynomials &&
+               polynomialIsIdentity(distort.m_distortionPolynomialRed) &&
+               polynomialIsIdentity(distort.m_distortionPolynomialGreen) &&
+               polynomialIsIdentity(distort.m_distortionPolynomialBlue);
+    }
+
     std::vector<RenderManager::DistortionMeshVertex>
     RenderManager::ComputeDistortionMesh(
         size_t eye //< Which eye?
@@ -1909,6 +3062,10 @@ namespace renderkit {
         ) {
         std::vector<RenderManager::DistortionMeshVertex> ret;
 
+        // The interpolators are shared with DistortionCorrectTextureCoordinate()
+        // and this may be called without m_mutex.
+        std::lock_guard<std::mutex> lock(m_interpolatorMutex);
+
         // Clear any created interpolators, freeing up their memory
         // first.  These may have been left behind by a failed
         // mesh-creation from before.
@@ -2217,6 +3374,176 @@ namespace renderkit {
         return std::string(tempBuffer.data(), len);
     }
 
+    /// Read the pipeline configuration settings that are not (yet) exposed
+    /// by osvr::client::RenderManagerConfig, leaving the defaults in place
+    /// for anything that is not specified.
+    static void
+    getExtendedRenderManagerConfig(const std::string& configString,
+                                   RenderManager::ConstructorParameters& p) {
+        Json::Value root;
+        Json::Reader reader;
+        if (!reader.parse(configString, root, false)) {
+            std::cerr << "getExtendedRenderManagerConfig: Could not parse "
+                         "configuration: "
+                      << reader.getFormattedErrorMessages() << std::endl;
+            return;
+        }
+        Json::Value const& config = root["renderManagerConfig"];
+
+        Json::Value const& adaptive = config["timeWarp"]["adaptiveThreshold"];
+        if (adaptive.isObject()) {
+            p.m_adaptiveTimeWarpThreshold =
+                adaptive.get("enabled", p.m_adaptiveTimeWarpThreshold).asBool();
+            p.m_adaptiveTimeWarpMinMS =
+                adaptive.get("minMs", p.m_adaptiveTimeWarpMinMS).asFloat();
+            p.m_adaptiveTimeWarpMaxMS =
+                adaptive.get("maxMs", p.m_adaptiveTimeWarpMaxMS).asFloat();
+            p.m_adaptiveTimeWarpPercentile =
+                adaptive.get("percentile", p.m_adaptiveTimeWarpPercentile)
+                    .asFloat();
+            p.m_adaptiveTimeWarpMarginMS =
+                adaptive.get("marginMs", p.m_adaptiveTimeWarpMarginMS)
+                    .asFloat();
+            p.m_adaptiveTimeWarpWindow =
+                adaptive.get("windowFrames", p.m_adaptiveTimeWarpWindow)
+                    .asUInt();
+        }
+
+        Json::Value const& dynamic = config["dynamicResolution"];
+        if (dynamic.isObject()) {
+            p.m_dynamicResolution =
+                dynamic.get("enabled", p.m_dynamicResolution).asBool();
+            p.m_dynamicResolutionMinScale =
+                dynamic.get("minScale", p.m_dynamicResolutionMinScale)
+                    .asFloat();
+            p.m_dynamicResolutionMaxScale =
+                dynamic.get("maxScale", p.m_dynamicResolutionMaxScale)
+                    .asFloat();
+            p.m_dynamicResolutionTargetMS =
+                dynamic.get("targetMs", p.m_dynamicResolutionTargetMS)
+                    .asFloat();
+            p.m_dynamicResolutionHeadroom =
+                dynamic.get("headroom", p.m_dynamicResolutionHeadroom)
+                    .asFloat();
+            p.m_dynamicResolutionStep =
+                dynamic.get("step", p.m_dynamicResolutionStep).asFloat();
+            p.m_dynamicResolutionHoldFrames =
+                dynamic.get("holdFrames", p.m_dynamicResolutionHoldFrames)
+                    .asUInt();
+        }
+
+        Json::Value const& multiRes = config["multiResolution"];
+        if (multiRes.isObject()) {
+            typedef RenderManager::ConstructorParameters Params;
+            std::string profile = multiRes.get("profile", "off").asString();
+            if (profile == "conservative") {
+                p.m_multiResolutionProfile =
+                    Params::MultiResolution_Conservative;
+            } else if (profile == "balanced") {
+                p.m_multiResolutionProfile = Params::MultiResolution_Balanced;
+            } else if (profile == "aggressive") {
+                p.m_multiResolutionProfile =
+                    Params::MultiResolution_Aggressive;
+            } else if (profile == "custom") {
+                p.m_multiResolutionProfile = Params::MultiResolution_Custom;
+            } else if (profile != "off") {
+                std::cerr << "getExtendedRenderManagerConfig: Unrecognized "
+                             "multiResolution profile "
+                          << profile << ", ignoring" << std::endl;
+            }
+            p.m_multiResolutionCenterFraction =
+                multiRes
+                    .get("centerFraction", p.m_multiResolutionCenterFraction)
+                    .asFloat();
+            p.m_multiResolutionBorderScale =
+                multiRes.get("borderScale", p.m_multiResolutionBorderScale)
+                    .asFloat();
+        }
+
+        Json::Value const& hiddenArea = config["hiddenAreaMask"];
+        if (hiddenArea.isObject()) {
+            p.m_hiddenAreaDepthMask =
+                hiddenArea.get("depthMask", p.m_hiddenAreaDepthMask).asBool();
+            p.m_hiddenAreaDepthClearValue =
+                hiddenArea
+                    .get("depthClearValue", p.m_hiddenAreaDepthClearValue)
+                    .asFloat();
+            p.m_hiddenAreaTimeWarpMargin =
+                hiddenArea
+                    .get("timeWarpMargin", p.m_hiddenAreaTimeWarpMargin)
+                    .asFloat();
+        }
+
+        Json::Value const& tightOverfill = config["tightOverfill"];
+        if (tightOverfill.isObject()) {
+            p.m_tightOverfill =
+                tightOverfill.get("enabled", p.m_tightOverfill).asBool();
+            p.m_tightOverfillTimeWarpMargin =
+                tightOverfill
+                    .get("timeWarpMargin", p.m_tightOverfillTimeWarpMargin)
+                    .asFloat();
+        }
+
+        Json::Value const& openGL = config["openGL"];
+        if (openGL.isObject()) {
+            p.m_synchronousGLErrorChecks =
+                openGL.get("synchronousErrorChecks",
+                           p.m_synchronousGLErrorChecks).asBool();
+            p.m_programBinaryCacheDirectory =
+                openGL.get("programBinaryCacheDirectory",
+                           p.m_programBinaryCacheDirectory).asString();
+            p.m_renderTargetTextureArray =
+                openGL.get("renderTargetTextureArray",
+                           p.m_renderTargetTextureArray).asBool();
+            p.m_parallelEyeRendering =
+                openGL.get("parallelEyeRendering", p.m_parallelEyeRendering)
+                    .asBool();
+
+            std::string colorFormat =
+                openGL.get("renderTargetColorFormat", "").asString();
+            if (colorFormat.empty()) {
+                // Keep the default.
+            } else if (colorFormat == "RGBA8") {
+                p.m_renderTargetColorFormat =
+                    RenderManager::ConstructorParameters::Color_RGBA8;
+            } else if (colorFormat == "RGB10_A2") {
+                p.m_renderTargetColorFormat =
+                    RenderManager::ConstructorParameters::Color_RGB10_A2;
+            } else if (colorFormat == "R11G11B10F") {
+                p.m_renderTargetColorFormat =
+                    RenderManager::ConstructorParameters::Color_R11G11B10F;
+            } else if (colorFormat == "RGBA16F") {
+                p.m_renderTargetColorFormat =
+                    RenderManager::ConstructorParameters::Color_RGBA16F;
+            } else {
+                std::cerr << "getExtendedRenderManagerConfig: Unrecognized "
+                             "renderTargetColorFormat ("
+                          << colorFormat << "), using the default"
+                          << std::endl;
+            }
+
+            std::string depthFormat =
+                openGL.get("renderTargetDepthFormat", "").asString();
+            if (depthFormat.empty()) {
+                // Keep the default.
+            } else if (depthFormat == "DEPTH16") {
+                p.m_renderTargetDepthFormat =
+                    RenderManager::ConstructorParameters::Depth_16;
+            } else if (depthFormat == "DEPTH24") {
+                p.m_renderTargetDepthFormat =
+                    RenderManager::ConstructorParameters::Depth_24;
+            } else if (depthFormat == "DEPTH32F") {
+                p.m_renderTargetDepthFormat =
+                    RenderManager::ConstructorParameters::Depth_32F;
+            } else {
+                std::cerr << "getExtendedRenderManagerConfig: Unrecognized "
+                             "renderTargetDepthFormat ("
+                          << depthFormat << "), using the default"
+                          << std::endl;
+            }
+        }
+    }
+
     void
     RenderManager::ConstructorParameters::addCandidatePNPID(const char* pnpid) {
         auto id = std::string{pnpid};
@@ -2363,6 +3690,7 @@ namespace renderkit {
             osvr::client::RenderManagerConfigPtr cfg(
                 new osvr::client::RenderManagerConfig(configString));
             pipelineConfig = cfg;
+            getExtendedRenderManagerConfig(configString, p);
 
             // this is what the code should be doing:
             // pipelineConfig =
@@ -2745,7 +4073,17 @@ namespace renderkit {
 #endif
             } else {
 #ifdef RM_USE_OPENGL
+#ifndef RM_USE_OPENGLES20
+                // Asynchronous time warp is done using a second, shared
+                // context on its own thread.
+                if (p.m_asynchronousTimeWarp && p.m_enableTimeWarp) {
+                    ret.reset(new RenderManagerOpenGLATW(context, p));
+                } else {
+                    ret.reset(new RenderManagerOpenGL(context, p));
+                }
+#else
                 ret.reset(new RenderManagerOpenGL(context, p));
+#endif
 #else
                 std::cerr << "createRenderManager: OpenGL render library not "
                              "compiled in"
@@ -32,6 +32,15 @@
 // Standard includes
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <mutex>
+
+namespace {
+// Present states are handed out again after they are finished rather than
+// being allocated every frame, and keep the storage of their vectors.
+std::mutex presentStatePoolLock;
+std::vector<std::unique_ptr<RenderManagerPresentState> > presentStatePool;
+} // namespace
 
 OSVR_ReturnCode osvrDestroyRenderManager(OSVR_RenderManager renderManager) {
     auto rm = reinterpret_cast<osvr::renderkit::RenderManager*>(renderManager);
@@ -46,8 +55,35 @@ osvrRenderManagerGetNumRenderInfo(OSVR_RenderManager renderManager,
     osvr::renderkit::RenderManager::RenderParams _renderParams;
     ConvertRenderParams(renderParams, _renderParams);
     auto rm = reinterpret_cast<osvr::renderkit::RenderManager*>(renderManager);
-    auto ri = rm->GetRenderInfo(_renderParams);
-    *numRenderInfoOut = ri.size();
+    *numRenderInfoOut = rm->LatchRenderInfo(_renderParams);
+    return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode
+osvrRenderManagerGetNumRenderRegions(OSVR_RenderManager renderManager,
+                                     OSVR_RenderInfoCount* numRegionsOut) {
+    auto rm = reinterpret_cast<osvr::renderkit::RenderManager*>(renderManager);
+    *numRegionsOut = rm->GetNumRenderRegions();
+    return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrRenderManagerGetHiddenAreaMesh(
+    OSVR_RenderManager renderManager, OSVR_RenderInfoCount renderInfoIndex,
+    size_t vertexCapacity, float* verticesOut, size_t* numVerticesOut) {
+    auto rm = reinterpret_cast<osvr::renderkit::RenderManager*>(renderManager);
+    std::vector<osvr::renderkit::Float2> triangles;
+    if (!rm->GetHiddenAreaMesh(renderInfoIndex, triangles)) {
+        *numVerticesOut = 0;
+        return OSVR_RETURN_FAILURE;
+    }
+    *numVerticesOut = triangles.size();
+    if (triangles.size() > vertexCapacity) {
+        return OSVR_RETURN_FAILURE;
+    }
+    for (size_t i = 0; i < triangles.size(); i++) {
+        verticesOut[2 * i] = triangles[i][0];
+        verticesOut[2 * i + 1] = triangles[i][1];
+    }
     return OSVR_RETURN_SUCCESS;
 }
 
@@ -69,7 +105,17 @@ osvrRenderManagerGetDefaultRenderParams(OSVR_RenderParams* renderParamsOut) {
 
 OSVR_ReturnCode osvrRenderManagerStartPresentRenderBuffers(
     OSVR_RenderManagerPresentState* presentStateOut) {
-    RenderManagerPresentState* presentState = new RenderManagerPresentState();
+    RenderManagerPresentState* presentState = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(presentStatePoolLock);
+        if (!presentStatePool.empty()) {
+            presentState = presentStatePool.back().release();
+            presentStatePool.pop_back();
+        }
+    }
+    if (presentState == nullptr) {
+        presentState = new RenderManagerPresentState();
+    }
     (*presentStateOut) =
         reinterpret_cast<OSVR_RenderManagerPresentState*>(presentState);
     return OSVR_RETURN_SUCCESS;
@@ -89,6 +135,15 @@ OSVR_ReturnCode osvrRenderManagerFinishPresentRenderBuffers(
                              _renderParams, state->normalizedCroppingViewports,
                              shouldFlipY == OSVR_TRUE);
 
+    // The state is finished with; give it back for the next frame.
+    state->renderBuffers.clear();
+    state->normalizedCroppingViewports.clear();
+    state->renderInfoUsed.clear();
+    {
+        std::lock_guard<std::mutex> lock(presentStatePoolLock);
+        presentStatePool.emplace_back(state);
+    }
+
     return OSVR_RETURN_SUCCESS;
 }
 
@@ -37,6 +37,7 @@
 #include <osvr/Util/ClientReportTypesC.h>
 #include <osvr/Util/ClientOpaqueTypesC.h>
 #include <osvr/Util/BoolC.h>
+#include <osvr/Util/TimeValueC.h>
 
 /* Library/third-party includes */
 /* none */
@@ -55,6 +56,13 @@ typedef void* OSVR_RenderManagerPresentState;
 typedef void* OSVR_RenderManagerRegisterBufferState;
 typedef size_t OSVR_RenderInfoCount;
 
+//=========================================================================
+/// Describes the frame that a set of render info was latched for.
+typedef struct OSVR_RenderFrameInfo {
+    uint64_t frameId; //< Number of frames presented before this one
+    OSVR_TimeValue predictedDisplayTime; //< (0,0) if not available
+} OSVR_RenderFrameInfo;
+
 // @todo could we use this for the C++ API as well?
 typedef struct OSVR_RenderParams {
     // not sure why the original struct had pointers here
@@ -95,16 +103,39 @@ typedef enum {
 OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
 osvrDestroyRenderManager(OSVR_RenderManager renderManager);
 
+/// Reports the number of surfaces to render.  This and the
+/// osvrRenderManagerGetRenderInfo* functions update the client context on
+/// every call; use osvrRenderManagerGetFrameRenderInfo* to get all of the
+/// surfaces with one update per frame.
 OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode osvrRenderManagerGetNumRenderInfo(
     OSVR_RenderManager renderManager, OSVR_RenderParams renderParams,
     OSVR_RenderInfoCount* numRenderInfoOut);
 
+/// Reports the number of regions each surface is rendered in, which is
+/// more than one when rendering at multiple resolutions.  Each region is
+/// rendered separately, using the viewport and projection from the
+/// osvrRenderManagerGetRenderRegion* functions.
+OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode osvrRenderManagerGetNumRenderRegions(
+    OSVR_RenderManager renderManager, OSVR_RenderInfoCount* numRegionsOut);
+
+/// Gets a mesh covering the parts of a surface that are never seen once
+/// distortion is corrected, as triangles with an x and a y for each vertex,
+/// normalized to the surface's viewport with (0,0) at the lower left.
+/// numVerticesOut is set to the number of vertices; if that is more than
+/// vertexCapacity, none are copied and failure is returned.
+OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode osvrRenderManagerGetHiddenAreaMesh(
+    OSVR_RenderManager renderManager, OSVR_RenderInfoCount renderInfoIndex,
+    size_t vertexCapacity, float* verticesOut, size_t* numVerticesOut);
+
 OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
 osvrRenderManagerGetDoingOkay(OSVR_RenderManager renderManager);
 
 OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
 osvrRenderManagerGetDefaultRenderParams(OSVR_RenderParams* renderParamsOut);
 
+/// Present states are recycled: the one returned here is valid until it
+/// is passed to osvrRenderManagerFinishPresentRenderBuffers(), after which
+/// it may be handed out again.
 OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
 osvrRenderManagerStartPresentRenderBuffers(
     OSVR_RenderManagerPresentState* presentStateOut);
@@ -277,7 +277,9 @@ namespace renderkit {
         if (m_params.m_verticalSync) {
             vblanks = 1;
         }
+        auto presentStart = std::chrono::steady_clock::now();
         m_displays[display].m_swapChain->Present(vblanks, 0);
+        AddPresentBlockedTime(std::chrono::steady_clock::now() - presentStart);
         return true;
     }
 
@@ -28,6 +28,7 @@ Sensics, Inc.
 #include "RenderManagerD3DBase.h"
 #include "RenderManagerOpenGL.h"
 #include "GraphicsLibraryD3D11.h"
+#include "RenderManagerATWScheduler.h"
 
 #include <vector>
 #include <string>
@@ -41,12 +42,13 @@ namespace osvr {
 
         class RenderManagerD3D11ATW : public RenderManagerD3D11Base {
         private:
-            // Indices into the keys for the Render Thread
+            // Key that the render thread's mutexes are acquired with when
+            // the buffers are registered.
             const UINT rtAcqKey = 0;
-            const UINT rtRelKey = 1;
-            // Indices into the keys for the ATW thread
-            const UINT acqKey = 1;
-            const UINT relKey = 0;
+            // Key that a buffer's mutex is released with whenever the thread
+            // holding it is done with it, and acquired with by whichever
+            // thread (render or ATW) next needs it.
+            const UINT handoffKey = 1;
 
             typedef struct {
                 osvr::renderkit::RenderBuffer rtBuffer;
@@ -61,17 +63,24 @@ namespace osvr {
             std::map<osvr::renderkit::RenderBufferD3D11*, RenderBufferATWInfo> mBufferMap;
             GraphicsLibraryD3D11* mRTGraphicsLibrary;
 
-            struct {
-                std::vector<osvr::renderkit::RenderBuffer> renderBuffers;
-                std::vector<osvr::renderkit::RenderInfo> renderInfo;
-                std::vector<OSVR_ViewportDescription> normalizedCroppingViewports;
-                RenderParams renderParams;
-                bool flipInY;
-            } mNextFrameInfo;
+            // Decides when to present and which frame to present; the
+            // frames it is handed refer to the render thread's buffers.
+            std::unique_ptr<ATWScheduler> mScheduler;
+
+            // Render thread's buffers from the most-recent present, which
+            // the render thread does not hold.  Only touched by the render
+            // thread.
+            std::vector<osvr::renderkit::RenderBuffer> mSubmittedBuffers;
+
+            // Scratch vectors kept so that presenting does not allocate.
+            // mPreviousBuffers is only touched by the render thread; the
+            // others only by the ATW thread.
+            std::vector<osvr::renderkit::RenderBuffer> mPreviousBuffers;
+            std::vector<osvr::renderkit::RenderBuffer> mATWRenderBuffers;
+            std::vector<IDXGIKeyedMutex*> mAcquired;
 
             bool mQuit = false;
             bool mStarted = false;
-            bool mFirstFramePresented = false;
 
         public:
             /**
@@ -85,6 +94,21 @@ namespace osvr {
                 : RenderManagerD3D11Base(context, p) {
                 mRTGraphicsLibrary = p.m_graphicsLibrary.D3D11;
                 mRenderManager.reset(D3DToHarness);
+
+                // The harnessed RenderManager handles the timing and
+                // tracks the threshold in effect, which may be adapted to
+                // its present cost.
+                ATWScheduler::Hooks hooks;
+                hooks.getTimingInfo = [this](RenderTimingInfo& info) {
+                    return mRenderManager->GetTimingInfo(0, info);
+                };
+                hooks.getThresholdMS = [this]() {
+                    return mRenderManager->GetTimeWarpThresholdMS();
+                };
+                hooks.present = [this](const ATWScheduler::Frame& frame) {
+                    return presentFrame(frame);
+                };
+                mScheduler.reset(new ATWScheduler(hooks));
             }
 
             virtual ~RenderManagerD3D11ATW() {
@@ -129,6 +153,13 @@ namespace osvr {
                 return ret;
             }
 
+            // The harnessed RenderManager applies the time warp, so its
+            // threshold is the one in effect.
+            float OSVR_RENDERMANAGER_EXPORT
+            GetTimeWarpThresholdMS() const override {
+                return mRenderManager->GetTimeWarpThresholdMS();
+            }
+
         protected:
 
           bool OSVR_RENDERMANAGER_EXPORT
@@ -139,73 +170,84 @@ namespace osvr {
                   std::vector<OSVR_ViewportDescription>(),
                 bool flipInY = false) override {
 
-                  std::lock_guard<std::mutex> lock(mLock);
                   HRESULT hr;
 
-                  // For all the buffers that have been given to the ATW thread,
-                  // release them there and acquire them back for the render thread.
-                  // This starts us with the render thread owning all of the buffers.
-                  // Then clear the buffer list that is owned by the ATW thread.
-                  for (size_t i = 0; i < mNextFrameInfo.renderBuffers.size(); i++) {
-                    auto key = mNextFrameInfo.renderBuffers[i].D3D11;
-                    auto bufferInfoItr = mBufferMap.find(key);
-                    if (bufferInfoItr == mBufferMap.end()) {
-                      std::cerr << "No Buffer info for key " << (size_t)key << std::endl;
-                      m_doingOkay = false;
-                      mQuit = true;
-                    }
-                    auto bufferInfo = bufferInfoItr->second;
-                    //std::cerr << "releasing atwMutex " << (size_t)key << std::endl;
-                    hr = bufferInfoItr->second.atwMutex->ReleaseSync(relKey);
-                    if (FAILED(hr)) {
-                      std::cerr << "Could not ReleaseSync in the render manager thread." << std::endl;
-                      m_doingOkay = false;
-                      mQuit = true;
-                    }
-                    //std::cerr << "acquiring rtMutex " << (size_t)key << std::endl;
-                    hr = bufferInfoItr->second.rtMutex->AcquireSync(rtAcqKey, INFINITE);
-                    if (FAILED(hr)) {
-                      std::cerr << "Could not lock the render thread's mutex" << std::endl;
-                      m_doingOkay = false;
-                      mQuit = true;
-                    }
-                  }
-                  mNextFrameInfo.renderBuffers.clear();
-
-                  // For all of the buffers we're getting ready to hand to the ATW thread,
-                  // we release our lock and lock them for that thread and then push them
-                  // onto the vector for use by that thread.
+                  // Buffers go back and forth between the threads using their
+                  // keyed mutexes: the ATW thread acquires the buffers of the
+                  // frame it is presenting only for the duration of each
+                  // present, so we never wait for more than one present here
+                  // and neither thread holds a lock while the other presents.
+                  // Buffers that were also in the previous frame are still
+                  // released to the ATW thread, so we leave them alone.
+                  auto inFrame = [](const std::vector<RenderBuffer>& buffers,
+                                    const RenderBuffer& buffer) {
+                      for (size_t i = 0; i < buffers.size(); i++) {
+                          if (buffers[i].D3D11 == buffer.D3D11) { return true; }
+                      }
+                      return false;
+                  };
+
+                  // For all of the buffers we're getting ready to hand to the ATW
+                  // thread, we release our lock on them.  The ATW thread acquires
+                  // them each time it presents them.
+                  // The scheduler's recycled frame keeps the storage of an
+                  // earlier one, so filling it in does not allocate.
+                  ATWScheduler::Frame& frame = mScheduler->nextFrame();
+                  frame.renderBuffers.clear();
                   for (size_t i = 0; i < renderBuffers.size(); i++) {
-                      // We need to unlock the render thread's mutex (remember they're locked initially)
                       auto key = renderBuffers[i].D3D11;
-                      //std::cerr << "releasing rtMutex " << (size_t)key << std::endl;
                       auto bufferInfoItr = mBufferMap.find(key);
                       if (bufferInfoItr == mBufferMap.end()) {
                           std::cerr << "Could not find buffer info for RenderBuffer " << (size_t)key << std::endl;
                           m_doingOkay = false;
                           return false;
                       }
-                      hr = bufferInfoItr->second.rtMutex->ReleaseSync(rtRelKey);
-                      if (FAILED(hr)) {
-                          std::cerr << "Could not ReleaseSync on a client render target's IDXGIKeyedMutex during present." << std::endl;
+                      if (!inFrame(mSubmittedBuffers, renderBuffers[i])) {
+                          hr = bufferInfoItr->second.rtMutex->ReleaseSync(handoffKey);
+                          if (FAILED(hr)) {
+                              std::cerr << "Could not ReleaseSync on a client render target's IDXGIKeyedMutex during present." << std::endl;
+                              m_doingOkay = false;
+                              return false;
+                          }
+                      }
+                      frame.renderBuffers.push_back(bufferInfoItr->second.rtBuffer);
+                  }
+
+                  // Hand the frame to the scheduler.  This does not wait for
+                  // the ATW thread; it will pick up the new frame the next
+                  // time it presents.
+                  frame.renderInfo = renderInfoUsed;
+                  frame.flipInY = flipInY;
+                  frame.renderParams = renderParams;
+                  frame.normalizedCroppingViewports = normalizedCroppingViewports;
+                  mPreviousBuffers.swap(mSubmittedBuffers);
+                  mSubmittedBuffers = frame.renderBuffers;
+                  mScheduler->submit();
+
+                  // Take back the buffers from the previous frame that we're
+                  // not handing over again, so that the render thread owns them
+                  // while the application renders into them.  The previous
+                  // frame has been superseded, so the ATW thread will not
+                  // acquire them again; we only wait for a present that is
+                  // using them to finish.
+                  for (size_t i = 0; i < mPreviousBuffers.size(); i++) {
+                      if (inFrame(mSubmittedBuffers, mPreviousBuffers[i])) {
+                          continue;
+                      }
+                      auto key = mPreviousBuffers[i].D3D11;
+                      auto bufferInfoItr = mBufferMap.find(key);
+                      if (bufferInfoItr == mBufferMap.end()) {
+                          std::cerr << "No Buffer info for key " << (size_t)key << std::endl;
                           m_doingOkay = false;
                           return false;
                       }
-                      // and lock the ATW thread's mutex
-                      //std::cerr << "locking atwMutex " << (size_t)key << std::endl;
-                      hr = bufferInfoItr->second.atwMutex->AcquireSync(rtRelKey, INFINITE);
+                      hr = bufferInfoItr->second.rtMutex->AcquireSync(handoffKey, INFINITE);
                       if (FAILED(hr)) {
-                          std::cerr << "Could not AcquireSync on the atw IDXGIKeyedMutex during present.";
+                          std::cerr << "Could not lock the render thread's mutex" << std::endl;
                           m_doingOkay = false;
                           return false;
                       }
-                      mNextFrameInfo.renderBuffers.push_back(bufferInfoItr->second.rtBuffer);
                   }
-                  mFirstFramePresented = true;
-                  mNextFrameInfo.renderInfo = renderInfoUsed;
-                  mNextFrameInfo.flipInY = flipInY;
-                  mNextFrameInfo.renderParams = renderParams;
-                  mNextFrameInfo.normalizedCroppingViewports = normalizedCroppingViewports;
                   return true;
             }
 
@@ -243,84 +285,92 @@ namespace osvr {
             }
 
             void threadFunc() {
-                bool quit = getQuit();
-                size_t iteration = 0;
-                while (!quit) {
-
-                    // Wait until it is time to present the render buffers.
-                    // If we've got a specified maximum time before vsync,
-                    // we use that.  Otherwise, we set the threshold to 1ms
-                    // to give us some time to swap things out before vsync.
-                    bool timeToPresent = false;
-
-                    // Convert from milliseconds to seconds
-                    float thresholdF = m_params.m_maxMSBeforeVsyncTimeWarp / 1e3f;
-                    if (thresholdF == 0) { thresholdF = 1e-3f; }
-                    OSVR_TimeValue threshold;
-                    threshold.seconds = static_cast<OSVR_TimeValue_Seconds>(thresholdF);
-                    thresholdF -= threshold.seconds;
-                    threshold.microseconds =
-                      static_cast<OSVR_TimeValue_Microseconds>(thresholdF * 1e6);
-
-                    // We use the timing info from the first display to
-                    // determine when it is time to present.
-                    // @todo Need one thread per display if we have displays
-                    // that are not gen-locked.
-                    // @todo Consider making a function that both the RenderManagerBase.cpp
-                    // and this code calls to check if we're within range.
-                    osvr::renderkit::RenderTimingInfo timing;
-                    if (!mRenderManager->GetTimingInfo(0, timing)) {
-                        std::cerr << "RenderManagerThread::threadFunc() = couldn't get timing info" << std::endl;
+                while (!getQuit()) {
+                    if (mScheduler->tick() == ATWScheduler::FAILED) {
+                        std::lock_guard<std::mutex> lock(mLock);
+                        m_doingOkay = false;
+                        mQuit = true;
                     }
-                    OSVR_TimeValue nextRetrace = timing.hardwareDisplayInterval;
-                    osvrTimeValueDifference(&nextRetrace,
-                      &timing.timeSincelastVerticalRetrace);
-                    if (osvrTimeValueGreater(&threshold, &nextRetrace)) {
-                      timeToPresent = true;
+                }
+            }
+
+            // Called by the scheduler on the ATW thread.
+            ATWScheduler::PresentResult
+            presentFrame(const ATWScheduler::Frame& frame) {
+                HRESULT hr;
+
+                // Acquire the ATW thread's view of each of the buffers for
+                // the duration of this present.  The render thread only takes
+                // a buffer back after it has submitted a newer frame that does
+                // not contain it, so if one is not available we were handed a
+                // superseded frame: give back what we have and present nothing,
+                // and tell the scheduler so that it presents the newer frame
+                // instead.
+                std::vector<osvr::renderkit::RenderBuffer>& atwRenderBuffers =
+                    mATWRenderBuffers;
+                std::vector<IDXGIKeyedMutex*>& acquired = mAcquired;
+                atwRenderBuffers.clear();
+                acquired.clear();
+                bool superseded = false;
+                bool ret = true;
+                for (size_t i = 0; i < frame.renderBuffers.size(); i++) {
+                    auto key = frame.renderBuffers[i].D3D11;
+                    auto bufferInfoItr = mBufferMap.find(key);
+                    if (bufferInfoItr == mBufferMap.end()) {
+                        std::cerr << "No buffer info for key " << (size_t)key << std::endl;
+                        ret = false;
+                        superseded = true;
+                        break;
+                    }
+                    // A buffer may appear more than once in a frame.
+                    IDXGIKeyedMutex* atwMutex = bufferInfoItr->second.atwMutex;
+                    bool alreadyAcquired = false;
+                    for (size_t j = 0; j < acquired.size(); j++) {
+                        if (acquired[j] == atwMutex) { alreadyAcquired = true; }
+                    }
+                    if (!alreadyAcquired) {
+                        hr = atwMutex->AcquireSync(handoffKey, 0);
+                        if (hr != S_OK) {
+                            superseded = true;
+                            break;
+                        }
+                        acquired.push_back(atwMutex);
                     }
+                    atwRenderBuffers.push_back(bufferInfoItr->second.atwBuffer);
+                }
+
+                if (!superseded) {
+                    // Update the context so we get our callbacks called and
+                    // update tracker state, which will be read during the
+                    // time-warp calculation in our harnessed RenderManager.
+                    mRenderManager->m_context->update();
+
+                    // Send the rendered results to the screen, using the
+                    // RenderInfo that was handed to us by the client the last
+                    // time they gave us some images.
+                    if (!mRenderManager->PresentRenderBuffers(
+                        atwRenderBuffers,
+                        frame.renderInfo,
+                        frame.renderParams,
+                        frame.normalizedCroppingViewports,
+                        frame.flipInY)) {
+                        std::cerr << "PresentRenderBuffers() returned false, maybe because it was asked to quit" << std::endl;
+                        ret = false;
+                    }
+                }
 
-                    if (timeToPresent) {
-                        std::lock_guard<std::mutex> lock(mLock);
-                        if (mFirstFramePresented) {
-                            // Update the context so we get our callbacks called and
-                            // update tracker state, which will be read during the
-                            // time-warp calculation in our harnessed RenderManager.
-                            mRenderManager->m_context->update();
-
-                            {
-                                // make a new RenderBuffers array with the atw thread's buffers
-                                std::vector<osvr::renderkit::RenderBuffer> atwRenderBuffers;
-                                for (size_t i = 0; i < mNextFrameInfo.renderBuffers.size(); i++) {
-                                    auto key = mNextFrameInfo.renderBuffers[i].D3D11;
-                                    auto bufferInfoItr = mBufferMap.find(key);
-                                    if (bufferInfoItr == mBufferMap.end()) {
-                                        std::cerr << "No buffer info for key " << (size_t)key << std::endl;
-                                        m_doingOkay = false;
-                                        mQuit = true;
-                                    }
-                                    atwRenderBuffers.push_back(bufferInfoItr->second.atwBuffer);
-                                }
-
-                                // Send the rendered results to the screen, using the
-                                // RenderInfo that was handed to us by the client the last
-                                // time they gave us some images.
-                                if (!mRenderManager->PresentRenderBuffers(
-                                    atwRenderBuffers,
-                                    mNextFrameInfo.renderInfo,
-                                    mNextFrameInfo.renderParams,
-                                    mNextFrameInfo.normalizedCroppingViewports,
-                                    mNextFrameInfo.flipInY)) {
-                                    std::cerr << "PresentRenderBuffers() returned false, maybe because it was asked to quit" << std::endl;
-                                    m_doingOkay = false;
-                                    mQuit = true;
-                                }
-                            }
-
-                            iteration++;
-                        }
+                for (size_t i = 0; i < acquired.size(); i++) {
+                    hr = acquired[i]->ReleaseSync(handoffKey);
+                    if (FAILED(hr)) {
+                        std::cerr << "Could not ReleaseSync in the ATW thread." << std::endl;
+                        ret = false;
                     }
-                    quit = mQuit;
                 }
+                if (!ret) {
+                    return ATWScheduler::PRESENT_FAILED;
+                }
+                return superseded ? ATWScheduler::PRESENT_SUPERSEDED
+                                  : ATWScheduler::PRESENT_DONE;
             }
 
             // We harness a D3D11 DirectMode renderer to do our
@@ -120,6 +120,25 @@ OSVR_ReturnCode osvrRenderManagerGetRenderInfoD3D11(
                                               renderParams, renderInfoOut);
 }
 
+OSVR_ReturnCode osvrRenderManagerGetFrameRenderInfoD3D11(
+    OSVR_RenderManagerD3D11 renderManager, OSVR_RenderParams renderParams,
+    OSVR_RenderInfoCount renderInfoCapacity,
+    OSVR_RenderInfoD3D11* renderInfoOut, OSVR_RenderInfoCount* numRenderInfoOut,
+    OSVR_RenderFrameInfo* frameInfoOut) {
+    return osvrRenderManagerGetFrameRenderInfoImpl(
+        renderManager, renderParams, renderInfoCapacity, renderInfoOut,
+        numRenderInfoOut, frameInfoOut);
+}
+
+OSVR_ReturnCode
+osvrRenderManagerGetRenderRegionD3D11(
+    OSVR_RenderManagerD3D11 renderManager,
+    const OSVR_RenderInfoD3D11* eyeInfo, OSVR_RenderInfoCount regionIndex,
+    OSVR_RenderInfoD3D11* regionOut) {
+    return osvrRenderManagerGetRenderRegionImpl(renderManager, eyeInfo,
+                                                regionIndex, regionOut);
+}
+
 OSVR_ReturnCode
 osvrRenderManagerOpenDisplayD3D11(OSVR_RenderManagerD3D11 renderManager,
                                   OSVR_OpenResultsD3D11* openResultsOut) {
@@ -74,6 +74,27 @@ OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode osvrRenderManagerGetRenderInfoD3D11(
     OSVR_RenderManagerD3D11 renderManager, OSVR_RenderInfoCount renderInfoIndex,
     OSVR_RenderParams renderParams, OSVR_RenderInfoD3D11* renderInfoOut);
 
+/// Gets the render info for all surfaces, along with the frame it was
+/// latched for, in one call.  The client context is updated at most once
+/// per frame: later calls in the same frame get the poses read by the
+/// first, with their own render parameters applied.
+/// numRenderInfoOut is set to the number of surfaces; if that is more than
+/// renderInfoCapacity, none are copied and failure is returned.
+OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
+osvrRenderManagerGetFrameRenderInfoD3D11(
+    OSVR_RenderManagerD3D11 renderManager, OSVR_RenderParams renderParams,
+    OSVR_RenderInfoCount renderInfoCapacity,
+    OSVR_RenderInfoD3D11* renderInfoOut, OSVR_RenderInfoCount* numRenderInfoOut,
+    OSVR_RenderFrameInfo* frameInfoOut);
+
+/// Gets the render info for one region of a surface, which is eyeInfo with
+/// its viewport and projection replaced by those of the region.
+OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
+osvrRenderManagerGetRenderRegionD3D11(
+    OSVR_RenderManagerD3D11 renderManager,
+    const OSVR_RenderInfoD3D11* eyeInfo, OSVR_RenderInfoCount regionIndex,
+    OSVR_RenderInfoD3D11* regionOut);
+
 OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
 osvrRenderManagerOpenDisplayD3D11(OSVR_RenderManagerD3D11 renderManager,
                                   OSVR_OpenResultsD3D11* openResultsOut);
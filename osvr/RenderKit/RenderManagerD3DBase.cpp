@@ -27,6 +27,7 @@ Sensics, Inc.
 #include "GraphicsLibraryD3D11.h"
 #include <boost/assert.hpp>
 #include <iostream>
+#include <sstream>
 #include <DirectXMath.h>
 #include <d3dcompiler.h>
 #pragma comment(lib, "d3dcompiler.lib")
@@ -40,6 +41,7 @@ static const char* distortionVertexShader =
     "  matrix projectionMatrix;"
     "  matrix modelViewMatrix;"
     "  matrix textureMatrix;"
+    "  float4 textureScaleOffset;"
     "}"
     ""
     "struct VS_Input"
@@ -71,10 +73,36 @@ static const char* distortionVertexShader =
     "  return ret;"
     "}";
 
+// When the eyes are rendered at multiple resolutions, MULTI_RES and the
+// MULTI_RES_ values describing the packing are defined when compiling, and
+// coordinates in the whole eye are mapped into the packed texture.
 static const char* distortionPixelShader =
+    "cbuffer cbPerObject"
+    "{"
+    "  matrix projectionMatrix;"
+    "  matrix modelViewMatrix;"
+    "  matrix textureMatrix;"
+    "  float4 textureScaleOffset;"
+    "}"
+    ""
     "Texture2D shaderTexture;"
     "SamplerState sampleState;"
     ""
+    "\n#ifdef MULTI_RES\n"
+    "float2 multiRes(float2 c)"
+    "{"
+    "  float2 t = (c - textureScaleOffset.zw) / textureScaleOffset.xy;"
+    "  float2 p = min(t, MULTI_RES_LOW) * MULTI_RES_SLOPE_LOW +"
+    "    clamp(t - MULTI_RES_LOW, 0, MULTI_RES_HIGH - MULTI_RES_LOW) *"
+    "      MULTI_RES_SLOPE_CENTER +"
+    "    max(t - MULTI_RES_HIGH, 0) * MULTI_RES_SLOPE_HIGH;"
+    "  return p * textureScaleOffset.xy + textureScaleOffset.zw;"
+    "}"
+    "\n#define REMAP(c) multiRes(c)\n"
+    "#else\n"
+    "#define REMAP(c) (c)\n"
+    "#endif\n"
+    ""
     "struct PS_Input"
     "{"
     "  float4 position : SV_POSITION;"
@@ -87,9 +115,9 @@ static const char* distortionPixelShader =
     "{"
     "  /* @todo Look up the distortion correction */"
     "  float4 outColor;"
-    "  outColor.r = shaderTexture.Sample(sampleState, input.texR).r;"
-    "  outColor.g = shaderTexture.Sample(sampleState, input.texG).g;"
-    "  outColor.b = shaderTexture.Sample(sampleState, input.texB).b;"
+    "  outColor.r = shaderTexture.Sample(sampleState, REMAP(input.texR)).r;"
+    "  outColor.g = shaderTexture.Sample(sampleState, REMAP(input.texG)).g;"
+    "  outColor.b = shaderTexture.Sample(sampleState, REMAP(input.texB)).b;"
     "  outColor.a = 1.0f;"
     "  return outColor;"
     "}";
@@ -149,6 +177,14 @@ namespace renderkit {
         m_buffers.D3D11 = new RenderBufferD3D11;
         m_depthStencilStateForRender = nullptr;
 
+        if (m_params.m_hiddenAreaDepthMask) {
+            std::cerr << "RenderManagerD3D11Base::RenderManagerD3D11Base: "
+                         "The hidden-area depth mask is only applied by the "
+                         "OpenGL renderers; draw the mesh from "
+                         "GetHiddenAreaMesh() instead"
+                      << std::endl;
+        }
+
         //======================================================
         // Create the D3D11 context that is used to draw things into the window
         // unless these have already been filled in
@@ -452,10 +488,36 @@ namespace renderkit {
         }
         compiledShader->Release();
 
-        // Setup pixel shader
+        // Setup pixel shader, with the multi-resolution packing compiled
+        // in if we're using it; it is fixed at construction.
+        std::vector<std::string> macroValues;
+        std::vector<D3D_SHADER_MACRO> macros;
+        MultiResolutionRemap remap;
+        if (GetMultiResolutionRemap(remap)) {
+            const char* names[] = {"MULTI_RES_LOW", "MULTI_RES_HIGH",
+                                   "MULTI_RES_SLOPE_LOW",
+                                   "MULTI_RES_SLOPE_CENTER",
+                                   "MULTI_RES_SLOPE_HIGH"};
+            const float* values[] = {remap.low, remap.high, remap.slopeLow,
+                                     remap.slopeCenter, remap.slopeHigh};
+            for (size_t i = 0; i < 5; i++) {
+                std::ostringstream s;
+                s.precision(9);
+                s << "float2(" << values[i][0] << ", " << values[i][1] << ")";
+                macroValues.push_back(s.str());
+            }
+            D3D_SHADER_MACRO multiRes = {"MULTI_RES", "1"};
+            macros.push_back(multiRes);
+            for (size_t i = 0; i < 5; i++) {
+                D3D_SHADER_MACRO m = {names[i], macroValues[i].c_str()};
+                macros.push_back(m);
+            }
+        }
+        D3D_SHADER_MACRO endOfMacros = {nullptr, nullptr};
+        macros.push_back(endOfMacros);
         hr = D3DCompile(
             distortionPixelShader, strlen(distortionPixelShader) + 1,
-            "triangle_ps", nullptr, nullptr, "triangle_ps", "ps_4_0",
+            "triangle_ps", macros.data(), nullptr, "triangle_ps", "ps_4_0",
             D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &compiledShader, &compilerMsgs);
         if (FAILED(hr)) {
             std::cerr << "RenderManagerD3D11Base::OpenDisplay: Pixel shader "
@@ -596,8 +658,8 @@ namespace renderkit {
     }
 
     bool RenderManagerD3D11Base::ComputeAsynchronousTimeWarps(
-        std::vector<RenderInfo> usedRenderInfo,
-        std::vector<RenderInfo> currentRenderInfo, float assumedDepth) {
+        const std::vector<RenderInfo>& usedRenderInfo,
+        const std::vector<RenderInfo>& currentRenderInfo, float assumedDepth) {
         /// @todo Make this and the base-class method share code rather than
         /// repeat
 
@@ -777,9 +839,14 @@ namespace renderkit {
         m_buffers.D3D11->depthStencilBuffer =
             m_renderBuffers[eye].D3D11->depthStencilBuffer;
 
-        // Set the viewport for rendering to this eye.
+        // Set the viewport for rendering to this eye, which is smaller
+        // than the texture when the resolution is scaled down.
         OSVR_ViewportDescription v;
-        ConstructViewportForRender(eye, v);
+        if (eye < m_renderInfoForRender.size()) {
+            v = m_renderInfoForRender[eye].viewport;
+        } else {
+            ConstructViewportForRender(eye, v);
+        }
         CD3D11_VIEWPORT viewport(
             static_cast<float>(v.left), static_cast<float>(v.lower),
             static_cast<float>(v.width), static_cast<float>(v.height));
@@ -845,7 +912,7 @@ namespace renderkit {
             // Construct a distortion mesh for this eye using the RenderManager
             // standard, which is an OpenGL-compatible mesh.
             std::vector<RenderManager::DistortionMeshVertex> mesh =
-                ComputeDistortionMesh(eye, type, distort[eye]);
+                GetDistortionMesh(eye, type, distort);
             m_numTriangles[eye] = mesh.size() / 3;
             if (m_numTriangles[eye] == 0) {
                 std::cerr << "RenderManagerD3D11Base::OpenDisplay: Could not "
@@ -1005,22 +1072,21 @@ namespace renderkit {
             }
         }
 
-        // Construct the viewport based on which eye this is.
-        // Set the D3D11 viewport based on the one we computed.
-        // As we have eyes at different Y positions, we need to
-        // figure out how to subtract the total screen size to find
-        // the correct starting location.
-        OSVR_ViewportDescription viewportDesc;
-        if (!ConstructViewportForPresent(params.m_index, viewportDesc,
-                                         swapEyes)) {
+        // Get the viewport, the projection that undoes the overfill, the
+        // display rotation/flip and the crop to this eye's part of the
+        // render buffer.  These only change with the configuration and
+        // the cropping viewport, so they are usually already computed.
+        const PresentEyeTransforms* transforms =
+            GetPresentEyeTransforms(params, swapEyes);
+        if (transforms == nullptr) {
             std::cerr << "RenderManagerD3D11::PresentEye(): Could not "
-                         "construct viewport"
+                         "construct present transforms"
                       << std::endl;
             return false;
         }
-        // Adjust the viewport based on how much the display window is
-        // rotated with respect to the rendering window.
-        viewportDesc = RotateViewport(viewportDesc);
+
+        // Set the D3D11 viewport based on the one we computed.
+        const OSVR_ViewportDescription& viewportDesc = transforms->viewport;
         CD3D11_VIEWPORT viewport(static_cast<float>(viewportDesc.left),
                                  static_cast<float>(viewportDesc.lower),
                                  static_cast<float>(viewportDesc.width),
@@ -1037,34 +1103,8 @@ namespace renderkit {
 
         //====================================================================
         // Set up matrices to be used for overfill, flipping, and ATW.
-
-        // Set up a Projection matrix that undoes the scale factor applied
-        // due to our rendering overfill factor.  This will put only the part
-        // of the geometry that should be visible inside the viewing frustum.
-        // @todo think about how we get square pixels, to properly handle
-        // distortion correction.
-        float myScale = m_params.m_renderOverfillFactor;
-        float scaleProj[16] = {myScale, 0, 0, 0, 0, myScale, 0, 0,
-                               0,       0, 1, 0, 0, 0,       0, 1};
-        DirectX::XMMATRIX projection(scaleProj);
-
-        // Set up a ModelView matrix that handles rotating and flipping the
-        // geometry as needed to match the display scan-out circuitry and/or
-        // any changes needed by the inversion of window coordinates when
-        // switching between graphics systems (OpenGL and Direct3D, for
-        // example).
-        // @todo think about how we get square pixels, to properly handle
-        // distortion correction.
-        matrix16 modelViewMat;
-        if (!ComputeDisplayOrientationMatrix(
-                static_cast<float>(params.m_rotateDegrees), params.m_flipInY,
-                modelViewMat)) {
-            std::cerr << "RenderManagerD3D11Base::PresentEye(): "
-                         "ComputeDisplayOrientationMatrix failed"
-                      << std::endl;
-            return false;
-        }
-        DirectX::XMMATRIX modelView(modelViewMat.data);
+        DirectX::XMMATRIX projection(transforms->projection.data);
+        DirectX::XMMATRIX modelView(transforms->modelView.data);
 
         // Set up the texture matrix to handle asynchronous time warp.
         // We are able to use the matrix directly because it is using
@@ -1076,32 +1116,31 @@ namespace renderkit {
             memcpy(textureMat, params.m_ATW->data, 16 * sizeof(float));
         }
 
-        // We now crop to a subregion of the texture.  This is used to handle
-        // the
-        // case where more than one eye is drawn into the same render texture
-        // (for example, as happens in the Unreal game engine).  We base this on
-        // the normalized cropping viewport, which will go from 0 to 1 in both
-        // X and Y for the full display, but which will be cut in half in in one
-        // dimension for the case where two eyes are packed into the same
-        // buffer.
-        // We scale and translate the texture coordinates by multiplying the
-        // texture matrix to map the original range (0..1) to the proper
-        // location.
-        // We read in, multiply by the transpose of the crop matrix (going from
-        // OpenGL form to Direct3D requires a transpose), and write out
-        // textureMat.
-        matrix16 crop;
-        ComputeRenderBufferCropMatrix(params.m_normalizedCroppingViewport,
-                                      crop);
+        // We now crop to a subregion of the texture, to handle the case
+        // where more than one eye is drawn into the same render texture.
+        // We read in, multiply by the transpose of the cached crop matrix
+        // (going from OpenGL form to Direct3D requires a transpose), and
+        // write out textureMat.
         Eigen::Map<Eigen::Matrix4f> textureEi(textureMat);
-        textureEi = textureEi * Eigen::Matrix4f::Map(crop.data).transpose();
+        textureEi =
+            textureEi * Eigen::Matrix4f::Map(transforms->crop.data).transpose();
 
         DirectX::XMMATRIX texture(textureMat);
-        cbPerObject wvp = {projection, modelView, texture};
+
+        // The pixel shader undoes the crop when it maps coordinates into
+        // a multi-resolution packed texture.
+        const OSVR_ViewportDescription& crop =
+            params.m_normalizedCroppingViewport;
+        DirectX::XMFLOAT4 textureScaleOffset(
+            static_cast<float>(crop.width), static_cast<float>(crop.height),
+            static_cast<float>(crop.left), static_cast<float>(crop.lower));
+        cbPerObject wvp = {projection, modelView, texture, textureScaleOffset};
         m_D3D11Context->UpdateSubresource(m_cbPerObjectBuffer.Get(), 0, nullptr,
                                           &wvp, 0, 0);
         m_D3D11Context->VSSetConstantBuffers(
             0, 1, m_cbPerObjectBuffer.GetAddressOf());
+        m_D3D11Context->PSSetConstantBuffers(
+            0, 1, m_cbPerObjectBuffer.GetAddressOf());
 
         //====================================================================
         // Set vertex buffer
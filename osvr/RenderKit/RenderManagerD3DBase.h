@@ -153,14 +153,15 @@ namespace renderkit {
             DirectX::XMMATRIX projection;
             DirectX::XMMATRIX modelView;
             DirectX::XMMATRIX texture;
+            DirectX::XMFLOAT4 textureScaleOffset; //< Crop scale, offset
         };
 
         /// We can't use an OpenGL-compliant texture warp matrix, so need to
         /// override it here.
-        bool
-        ComputeAsynchronousTimeWarps(std::vector<RenderInfo> usedRenderInfo,
-                                     std::vector<RenderInfo> currentRenderInfo,
-                                     float assumedDepth = 2.0f) override;
+        bool ComputeAsynchronousTimeWarps(
+            const std::vector<RenderInfo>& usedRenderInfo,
+            const std::vector<RenderInfo>& currentRenderInfo,
+            float assumedDepth = 2.0f) override;
 
         //===================================================================
         // Overloaded render functions from the base class.  Not all of the
@@ -185,6 +186,9 @@ namespace renderkit {
         bool PresentFrameInitialize() override;
         bool PresentEye(PresentEyeParameters params) override;
 
+        /// D3D viewports are measured from the top of the texture.
+        bool ViewportOriginIsTop() const override { return true; }
+
         friend class RenderManagerD3D11OpenGL;
         friend class RenderManagerD3D11ATW;
     };
@@ -144,7 +144,21 @@ namespace renderkit {
         //======================================================
         // Construct the present buffers we're going to use when in Render()
         // mode, to
-        // wrap the PresenMode interface.
+        // wrap the PresenMode interface.  Each buffer is shared with
+        // Direct3D as a 2D texture, so they cannot be layers of an array.
+        if (m_params.m_renderTargetTextureArray) {
+            std::cerr << "RenderManagerD3D11OpenGL::OpenDisplay: Texture "
+                         "arrays are not supported, using a texture per eye"
+                      << std::endl;
+            m_params.m_renderTargetTextureArray = false;
+        }
+        if (m_params.m_parallelEyeRendering) {
+            std::cerr << "RenderManagerD3D11OpenGL::OpenDisplay: Parallel "
+                         "eye rendering is not supported, rendering the eyes "
+                         "in turn"
+                      << std::endl;
+            m_params.m_parallelEyeRendering = false;
+        }
         if (!constructRenderBuffers()) {
             removeOpenGLContexts();
             std::cerr << "RenderManagerOpenGL::OpenDisplay: Could not "
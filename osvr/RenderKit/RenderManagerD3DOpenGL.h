@@ -57,6 +57,13 @@ namespace renderkit {
             return m_D3D11Renderer->GetTimingInfo(whichEye, info);
         }
 
+        // The harnessed renderer also does the presenting, so its
+        // time-warp threshold is the one in effect.
+        float OSVR_RENDERMANAGER_EXPORT
+        GetTimeWarpThresholdMS() const override {
+            return m_D3D11Renderer->GetTimeWarpThresholdMS();
+        }
+
       protected:
         /// Construct a D3D DirectMode renderer to do DirectMode
         // rendering, then harness it so that we can provide an OpenGL
@@ -0,0 +1,93 @@
+/** @file
+@brief Source file implementing the controller that picks the resolution
+scale for dynamic resolution from frame timing
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "RenderManagerDynamicResolution.h"
+
+// Standard includes
+#include <algorithm>
+
+namespace osvr {
+namespace renderkit {
+
+    const float DynamicResolutionController::SMALLEST_SCALE = 0.1f;
+    const float DynamicResolutionController::SMOOTHING = 0.2f;
+
+    DynamicResolutionController::DynamicResolutionController(
+        const Settings& settings)
+        : m_settings(settings) {
+        float& maxScale = m_settings.maxScale;
+        float& minScale = m_settings.minScale;
+        maxScale = std::min(std::max(maxScale, SMALLEST_SCALE), 1.0f);
+        minScale = std::min(std::max(minScale, SMALLEST_SCALE), maxScale);
+        m_scale = maxScale;
+    }
+
+    bool DynamicResolutionController::framePresented(
+        Clock::time_point presented, Clock::duration waited,
+        float targetMS) {
+        if (!m_havePresented) {
+            m_havePresented = true;
+            m_lastPresented = presented;
+            return false;
+        }
+        std::chrono::duration<float, std::milli> frame =
+            presented - m_lastPresented - waited;
+        m_lastPresented = presented;
+        float frameMS = std::max(frame.count(), 0.0f);
+
+        if (m_smoothedFrameMS <= 0) {
+            m_smoothedFrameMS = frameMS;
+        } else {
+            m_smoothedFrameMS += SMOOTHING * (frameMS - m_smoothedFrameMS);
+        }
+
+        // Give the frame time a chance to settle after each change.
+        if (++m_framesSinceChange < m_settings.holdFrames) {
+            return false;
+        }
+        if (targetMS <= 0) {
+            return false;
+        }
+
+        // Shrink when over budget, grow only when well under it.
+        float newScale = m_scale;
+        if (m_smoothedFrameMS > targetMS) {
+            newScale -= m_settings.step;
+        } else if (m_smoothedFrameMS < targetMS * (1 - m_settings.headroom)) {
+            newScale += m_settings.step;
+        }
+        newScale = std::max(newScale, m_settings.minScale);
+        newScale = std::min(newScale, m_settings.maxScale);
+        if (newScale == m_scale) {
+            return false;
+        }
+        m_scale = newScale;
+        m_framesSinceChange = 0;
+        return true;
+    }
+
+} // namespace renderkit
+} // namespace osvr
@@ -0,0 +1,99 @@
+/** @file
+@brief Header file describing the controller that picks the resolution
+scale for dynamic resolution from frame timing
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Standard includes
+#include <chrono>
+
+namespace osvr {
+namespace renderkit {
+
+    /// @brief Picks the fraction of each dimension of the eye textures to
+    /// render into, so that frames take no longer than a target time.
+    ///
+    /// It is told when each frame finishes presenting, so the time it
+    /// measures is the whole interval from one present to the next: the
+    /// application's rendering, Render()'s finalization and the present
+    /// itself.  Time that the renderer spent waiting rather than working
+    /// (for the time-warp threshold) is left out.  The times are smoothed
+    /// so that a single slow frame does not change the scale.
+    ///  The scale is stepped down while the smoothed time is over the
+    /// target and stepped up only once it is more than a headroom fraction
+    /// under it, so that it does not oscillate around the target.  After
+    /// each change it is held for a number of frames to let the frame time
+    /// settle, and it is kept within configured bounds.
+    ///  The clock is not read here; the caller passes the times in, so
+    /// that it can be driven by a simulated clock.  It is not thread-safe.
+    class DynamicResolutionController {
+      public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Settings {
+            float minScale = 0.5f;  //< Smallest scale to use
+            float maxScale = 1.0f;  //< Largest scale to use, at most 1
+            float headroom = 0.15f; //< Fraction under target before growing
+            float step = 0.05f;     //< Change in scale per adjustment
+            unsigned holdFrames = 15; //< Frames to wait after each change
+        };
+
+        /// The bounds are clamped to [SMALLEST_SCALE, 1], with minScale no
+        /// more than maxScale.  The scale starts at maxScale.
+        explicit DynamicResolutionController(const Settings& settings);
+
+        /// Record that a frame finished presenting at presented, having
+        /// spent waited of the time since the previous one waiting, and
+        /// adjust the scale to keep frames within targetMS.  The first
+        /// call only starts the timing.  A target that is not positive
+        /// leaves the scale as it is.
+        /// @return True if the scale changed.
+        bool framePresented(Clock::time_point presented,
+                            Clock::duration waited, float targetMS);
+
+        /// The scale to render at.
+        float scale() const { return m_scale; }
+
+        /// The smoothed frame time, or 0 before there is one.
+        float smoothedFrameMS() const { return m_smoothedFrameMS; }
+
+        const Settings& settings() const { return m_settings; }
+
+        /// Smallest bound allowed on the scale.
+        static const float SMALLEST_SCALE;
+
+        /// Weight of each new frame time in the smoothed one.
+        static const float SMOOTHING;
+
+      private:
+        Settings m_settings;
+        float m_scale;
+        float m_smoothedFrameMS = 0;
+        unsigned m_framesSinceChange = 0;
+        bool m_havePresented = false;
+        Clock::time_point m_lastPresented;
+    };
+
+} // namespace renderkit
+} // namespace osvr
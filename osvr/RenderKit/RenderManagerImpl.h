@@ -125,12 +125,14 @@ OSVR_ReturnCode osvrRenderManagerGetRenderInfoImpl(
     osvr::renderkit::RenderManager::RenderParams _renderParams;
     ConvertRenderParams(renderParams, _renderParams);
     auto rm = reinterpret_cast<osvr::renderkit::RenderManager*>(renderManager);
-    auto ri = rm->GetRenderInfo(_renderParams);
-    if (renderInfoIndex > ri.size() || renderInfoIndex < 0) {
+    rm->LatchRenderInfo(_renderParams);
+    auto snapshot = rm->GetRenderInfoSnapshot();
+    const auto& ri = *snapshot;
+    if (renderInfoIndex >= ri.size()) {
         std::cerr << "[OSVR] renderInfoIndex is out of range" << std::endl;
         return OSVR_RETURN_FAILURE;
     }
-    auto curRenderInfo = ri[renderInfoIndex];
+    const auto& curRenderInfo = ri[renderInfoIndex];
 
     auto& _renderInfoOut = *renderInfoOut;
     ConvertGraphicsLibrary(curRenderInfo.library, _renderInfoOut.library);
@@ -140,6 +142,59 @@ OSVR_ReturnCode osvrRenderManagerGetRenderInfoImpl(
     return OSVR_RETURN_SUCCESS;
 }
 
+template <class OSVR_RenderManagerType, class OSVR_RenderInfoType>
+OSVR_ReturnCode osvrRenderManagerGetFrameRenderInfoImpl(
+    OSVR_RenderManagerType renderManager, OSVR_RenderParams renderParams,
+    OSVR_RenderInfoCount renderInfoCapacity, OSVR_RenderInfoType* renderInfoOut,
+    OSVR_RenderInfoCount* numRenderInfoOut,
+    OSVR_RenderFrameInfo* frameInfoOut) {
+    osvr::renderkit::RenderManager::RenderParams _renderParams;
+    ConvertRenderParams(renderParams, _renderParams);
+    auto rm = reinterpret_cast<osvr::renderkit::RenderManager*>(renderManager);
+    auto frame = rm->LatchFrameRenderInfo(_renderParams);
+    const auto& ri = frame->renderInfo;
+
+    *numRenderInfoOut = ri.size();
+    if (frameInfoOut) {
+        frameInfoOut->frameId = frame->frameId;
+        frameInfoOut->predictedDisplayTime = frame->predictedDisplayTime;
+    }
+    if (ri.empty()) {
+        return OSVR_RETURN_FAILURE;
+    }
+    if (ri.size() > renderInfoCapacity) {
+        std::cerr << "[OSVR] renderInfoCapacity is too small" << std::endl;
+        return OSVR_RETURN_FAILURE;
+    }
+    for (size_t i = 0; i < ri.size(); i++) {
+        ConvertGraphicsLibrary(ri[i].library, renderInfoOut[i].library);
+        ConvertRenderInfo(ri[i], renderInfoOut[i]);
+    }
+    return OSVR_RETURN_SUCCESS;
+}
+
+template <class OSVR_RenderManagerType, class OSVR_RenderInfoType>
+OSVR_ReturnCode osvrRenderManagerGetRenderRegionImpl(
+    OSVR_RenderManagerType renderManager, const OSVR_RenderInfoType* eyeInfo,
+    OSVR_RenderInfoCount regionIndex, OSVR_RenderInfoType* regionOut) {
+    auto rm = reinterpret_cast<osvr::renderkit::RenderManager*>(renderManager);
+    // Only the viewport and projection differ between an eye and its
+    // regions, so the graphics library is not converted.
+    osvr::renderkit::RenderInfo _eyeInfo;
+    _eyeInfo.pose = eyeInfo->pose;
+    ConvertViewport(eyeInfo->viewport, _eyeInfo.viewport);
+    ConvertProjection(eyeInfo->projection, _eyeInfo.projection);
+    osvr::renderkit::RenderInfo region;
+    if (!rm->GetRenderRegion(_eyeInfo, regionIndex, region)) {
+        std::cerr << "[OSVR] regionIndex is out of range" << std::endl;
+        return OSVR_RETURN_FAILURE;
+    }
+    *regionOut = *eyeInfo;
+    ConvertViewport(region.viewport, regionOut->viewport);
+    ConvertProjection(region.projection, regionOut->projection);
+    return OSVR_RETURN_SUCCESS;
+}
+
 template <class OSVR_RenderManagerType, class OSVR_OpenResultsType>
 OSVR_ReturnCode
 osvrRenderManagerOpenDisplayImpl(OSVR_RenderManagerType renderManager,
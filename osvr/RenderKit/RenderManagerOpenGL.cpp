@@ -36,48 +36,109 @@ Sensics, Inc.
 #include "RenderManagerOpenGL.h"
 #include "GraphicsLibraryOpenGL.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <utility>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
 //==========================================================================
 // Vertex and fragment shaders to perform our combination of asynchronous
 // time warp and distortion correction.
+// The matrices for all eyes are sent in one uniform buffer where uniform
+// blocks are available, with the range for each eye bound before its draw.
+//  Variants are compiled by prepending defines to the sources: CHROMATIC
+// looks up red, green and blue separately (otherwise the red coordinates
+// are used for all three, with one texture fetch), TIME_WARP applies
+// a full texture matrix (otherwise the crop is a scale and offset),
+// TEXTURE_ARRAY samples one layer of an array texture holding all eyes, and
+// MULTI_RES maps coordinates in the whole eye into the packed texture that
+// it was rendered into at multiple resolutions.
+#ifdef RM_USE_OPENGLES20
+#define DISTORTION_MATRIX_UNIFORMS                                             \
+    "uniform mat4 positionMatrix;\n"                                           \
+    "uniform mat4 textureMatrix;\n"                                            \
+    "uniform vec4 textureScaleOffset;\n"
+#else
+#define DISTORTION_MATRIX_UNIFORMS                                             \
+    "layout(std140) uniform PresentEye {\n"                                    \
+    "   mat4 positionMatrix;\n"                                                \
+    "   mat4 textureMatrix;\n"                                                 \
+    "   vec4 textureScaleOffset;\n"                                            \
+    "   float textureLayer;\n"                                                 \
+    "};\n"
+#endif
+
+static const GLchar* distortionShaderVersion = "#version 330 core\n";
+
 static const GLchar* distortionVertexShader =
-    "#version 330 core\n"
     "layout(location = 0) in vec4 position;\n"
     "layout(location = 1) in vec2 textureCoordinateR;\n"
+    "out vec2 warpedCoordinateR;\n"
+    "#ifdef CHROMATIC\n"
     "layout(location = 2) in vec2 textureCoordinateG;\n"
     "layout(location = 3) in vec2 textureCoordinateB;\n"
-    "out vec2 warpedCoordinateR;\n"
     "out vec2 warpedCoordinateG;\n"
     "out vec2 warpedCoordinateB;\n"
-    "uniform mat4 projectionMatrix;\n"
-    "uniform mat4 modelViewMatrix;\n"
-    "uniform mat4 textureMatrix;\n"
+    "#endif\n"
+    DISTORTION_MATRIX_UNIFORMS
+    "#ifdef TIME_WARP\n"
+    "#define WARP(c) vec2(textureMatrix * vec4(c, 0, 1))\n"
+    "#else\n"
+    "#define WARP(c) (c * textureScaleOffset.xy + textureScaleOffset.zw)\n"
+    "#endif\n"
     "void main()\n"
     "{\n"
-    "   gl_Position = projectionMatrix * modelViewMatrix * position;\n"
-    "   warpedCoordinateR = vec2(textureMatrix * "
-    "      vec4(textureCoordinateR,0,1));\n"
-    "   warpedCoordinateG = vec2(textureMatrix * "
-    "      vec4(textureCoordinateG,0,1));\n"
-    "   warpedCoordinateB = vec2(textureMatrix * "
-    "      vec4(textureCoordinateB,0,1));\n"
+    "   gl_Position = positionMatrix * position;\n"
+    "   warpedCoordinateR = WARP(textureCoordinateR);\n"
+    "#ifdef CHROMATIC\n"
+    "   warpedCoordinateG = WARP(textureCoordinateG);\n"
+    "   warpedCoordinateB = WARP(textureCoordinateB);\n"
+    "#endif\n"
     "}\n";
 
 static const GLchar* distortionFragmentShader =
-    "#version 330 core\n"
+    "#if defined(TEXTURE_ARRAY) || defined(MULTI_RES)\n"
+    DISTORTION_MATRIX_UNIFORMS
+    "#endif\n"
+    "#ifdef MULTI_RES\n"
+    "vec2 multiRes(vec2 c)\n"
+    "{\n"
+    "   vec2 t = (c - textureScaleOffset.zw) / textureScaleOffset.xy;\n"
+    "   vec2 p = min(t, MULTI_RES_LOW) * MULTI_RES_SLOPE_LOW +\n"
+    "       clamp(t - MULTI_RES_LOW, vec2(0),\n"
+    "             MULTI_RES_HIGH - MULTI_RES_LOW) * MULTI_RES_SLOPE_CENTER +\n"
+    "       max(t - MULTI_RES_HIGH, vec2(0)) * MULTI_RES_SLOPE_HIGH;\n"
+    "   return p * textureScaleOffset.xy + textureScaleOffset.zw;\n"
+    "}\n"
+    "#define REMAP(c) multiRes(c)\n"
+    "#else\n"
+    "#define REMAP(c) (c)\n"
+    "#endif\n"
+    "#ifdef TEXTURE_ARRAY\n"
+    "uniform sampler2DArray tex;\n"
+    "#define SAMPLE(c) texture(tex, vec3(REMAP(c), textureLayer))\n"
+    "#else\n"
     "uniform sampler2D tex;\n"
+    "#define SAMPLE(c) texture2D(tex, REMAP(c))\n"
+    "#endif\n"
     "in vec2 warpedCoordinateR;\n"
+    "#ifdef CHROMATIC\n"
     "in vec2 warpedCoordinateG;\n"
     "in vec2 warpedCoordinateB;\n"
+    "#endif\n"
     "layout (location = 0) out vec4 outColor;\n"
     "void main()\n"
     "{\n"
-    "    outColor.r = texture2D(tex, warpedCoordinateR).r;\n"
-    "    outColor.g = texture2D(tex, warpedCoordinateG).g;\n"
-    "    outColor.b = texture2D(tex, warpedCoordinateB).b;\n"
+    "#ifdef CHROMATIC\n"
+    "    outColor.r = SAMPLE(warpedCoordinateR).r;\n"
+    "    outColor.g = SAMPLE(warpedCoordinateG).g;\n"
+    "    outColor.b = SAMPLE(warpedCoordinateB).b;\n"
     "    outColor.a = 1;\n"
+    "#else\n"
+    "    outColor = vec4(SAMPLE(warpedCoordinateR).rgb, 1);\n"
+    "#endif\n"
     "}\n";
 
 static bool checkShaderError(GLuint shaderId) {
@@ -124,11 +185,247 @@ static bool checkProgramError(GLuint programId) {
     return true;
 }
 
+#ifndef RM_USE_OPENGLES20
+//==========================================================================
+// On-disk cache of linked program binaries.  Each file holds a magic
+// number, the binary format, the full key it was stored under and then the
+// binary.  The key names the driver and hashes the shader sources, so a
+// driver update or a shader change looks for a different file; the key
+// stored in the file guards against hash collisions.  Anything we cannot
+// use is ignored and the program is built from source instead.
+
+static const char programCacheMagic[8] = {'O', 'S', 'V', 'R',
+                                          'P', 'B', '1', '\0'};
+
+/// Can this context save and load program binaries?
+static bool programBinariesSupported() {
+    if (!GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    return numFormats > 0;
+}
+
+/// 64-bit FNV-1a hash of a set of strings.
+static uint64_t hashStrings(const GLchar* const* strings, size_t count) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < count; i++) {
+        for (const GLchar* c = strings[i]; *c != '\0'; c++) {
+            hash ^= static_cast<unsigned char>(*c);
+            hash *= 1099511628211ULL;
+        }
+        // Separate the strings so that moving text between them changes
+        // the hash.
+        hash ^= 0xff;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static std::string glString(GLenum name) {
+    const GLubyte* s = glGetString(name);
+    return s ? reinterpret_cast<const char*>(s) : "";
+}
+
+/// Key for a program built from the given sources on the current driver.
+static std::string programCacheKey(const GLchar* const* sources,
+                                   size_t count) {
+    std::ostringstream key;
+    key << glString(GL_VENDOR) << "\n"
+        << glString(GL_RENDERER) << "\n"
+        << glString(GL_VERSION) << "\n"
+        << std::hex << hashStrings(sources, count);
+    return key.str();
+}
+
+static std::string programCachePath(const std::string& directory,
+                                    const std::string& key) {
+    const GLchar* keyString = key.c_str();
+    std::ostringstream path;
+    path << directory << "/osvr_rendermanager_" << std::hex
+         << hashStrings(&keyString, 1) << ".glbin";
+    return path.str();
+}
+
+/// Try to make a program from a cached binary.
+/// @return The linked program, or 0 if there was no usable binary.
+static GLuint loadCachedProgram(const std::string& directory,
+                                const std::string& key) {
+    std::ifstream in(programCachePath(directory, key).c_str(),
+                     std::ios::in | std::ios::binary);
+    if (!in) {
+        return 0;
+    }
+    char magic[sizeof(programCacheMagic)];
+    uint32_t format = 0, keyLength = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&format), sizeof(format));
+    in.read(reinterpret_cast<char*>(&keyLength), sizeof(keyLength));
+    if (!in || memcmp(magic, programCacheMagic, sizeof(magic)) != 0 ||
+        keyLength != key.size()) {
+        return 0;
+    }
+    std::string storedKey(keyLength, '\0');
+    in.read(&storedKey[0], keyLength);
+    if (!in || storedKey != key) {
+        return 0;
+    }
+    std::vector<char> binary((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+    if (binary.empty()) {
+        return 0;
+    }
+
+    // The driver may refuse a binary even on a matching key, for example
+    // after a change in hardware configuration; that shows up as a link
+    // failure, which we don't report because we'll just compile instead.
+    GLuint programId = glCreateProgram();
+    glProgramBinary(programId, format, binary.data(),
+                    static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE) {
+        glDeleteProgram(programId);
+        return 0;
+    }
+    return programId;
+}
+
+/// Save a linked program's binary to the cache.  Failures only mean that
+/// the next run compiles again, so they are reported but not returned.
+static void storeCachedProgram(const std::string& directory,
+                               const std::string& key, GLuint programId) {
+    GLint length = 0;
+    glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(programId, length, nullptr, &format, binary.data());
+
+    std::string path = programCachePath(directory, key);
+    std::ofstream out(path.c_str(),
+                      std::ios::out | std::ios::binary | std::ios::trunc);
+    uint32_t format32 = format;
+    uint32_t keyLength = static_cast<uint32_t>(key.size());
+    out.write(programCacheMagic, sizeof(programCacheMagic));
+    out.write(reinterpret_cast<const char*>(&format32), sizeof(format32));
+    out.write(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
+    out.write(key.data(), key.size());
+    out.write(binary.data(), binary.size());
+    if (!out) {
+        std::cerr << "RenderManagerOpenGL: Could not write program binary "
+                     "cache file "
+                  << path << std::endl;
+    }
+}
+
+/// Called by the driver, possibly from another thread, with messages
+/// from the OpenGL debug output.
+static void GLAPIENTRY glDebugMessageHandler(GLenum source, GLenum type,
+                                             GLuint id, GLenum severity,
+                                             GLsizei /* length */,
+                                             const GLchar* message,
+                                             const void* userParam) {
+    auto rm = static_cast<osvr::renderkit::RenderManagerOpenGL*>(
+        const_cast<void*>(userParam));
+    rm->reportGLDebugMessage(source, type, id, severity, message);
+}
+#endif
+
 namespace osvr {
 namespace renderkit {
 
-    /// @todo Make this compile to no-op when debugging is off.
-    bool RenderManagerOpenGL::checkForGLError(const std::string& message) {
+    bool RenderManagerOpenGL::installGLDebugCallback() {
+#ifdef RM_USE_OPENGLES20
+        return false;
+#else
+        if (m_params.m_synchronousGLErrorChecks) {
+            return false;
+        }
+        if (GLEW_KHR_debug || GLEW_VERSION_4_3) {
+            // Drivers need not report anything outside of a debug context,
+            // which addOpenGLContext() asked for; make sure we got one.
+            GLint contextFlags = 0;
+            glGetIntegerv(GL_CONTEXT_FLAGS, &contextFlags);
+            if ((contextFlags & GL_CONTEXT_FLAG_DEBUG_BIT) == 0) {
+                return false;
+            }
+            glDebugMessageCallback(glDebugMessageHandler, this);
+            // Notifications are informational (buffer placement and the
+            // like), and some drivers send them every frame.
+            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
+                                  GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr,
+                                  GL_FALSE);
+            glEnable(GL_DEBUG_OUTPUT);
+        } else if (GLEW_ARB_debug_output) {
+            // There is no way to ask whether this is a debug context, so we
+            // rely on having asked for one.
+            glDebugMessageCallbackARB(glDebugMessageHandler, this);
+            // There is no notification severity either; drivers send the
+            // same informational messages as low-severity "other" ones.
+            glDebugMessageControlARB(GL_DONT_CARE, GL_DEBUG_TYPE_OTHER_ARB,
+                                     GL_DEBUG_SEVERITY_LOW_ARB, 0, nullptr,
+                                     GL_FALSE);
+        } else {
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    void RenderManagerOpenGL::removeGLDebugCallback() {
+#ifndef RM_USE_OPENGLES20
+        if (GLEW_KHR_debug || GLEW_VERSION_4_3) {
+            glDebugMessageCallback(nullptr, nullptr);
+        } else if (GLEW_ARB_debug_output) {
+            glDebugMessageCallbackARB(nullptr, nullptr);
+        }
+#endif
+    }
+
+    void RenderManagerOpenGL::reportGLDebugMessage(GLenum source, GLenum type,
+                                                   GLuint id, GLenum severity,
+                                                   const GLchar* message) {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(m_glDebugLog.lock);
+        if (now - m_glDebugLog.windowStart >= std::chrono::seconds(1)) {
+            if (m_glDebugLog.suppressed > 0) {
+                std::cerr << "RenderManagerOpenGL::reportGLDebugMessage: "
+                          << m_glDebugLog.suppressed
+                          << " more OpenGL debug messages suppressed"
+                          << std::endl;
+            }
+            m_glDebugLog.windowStart = now;
+            m_glDebugLog.reported = 0;
+            m_glDebugLog.suppressed = 0;
+        }
+        if (m_glDebugLog.reported >= GL_DEBUG_LOG_MAX_PER_SECOND) {
+            m_glDebugLog.suppressed++;
+            return;
+        }
+        m_glDebugLog.reported++;
+        std::cerr << "RenderManagerOpenGL::reportGLDebugMessage: OpenGL "
+                     "message "
+                  << id << " (source " << source << ", type " << type
+                  << ", severity " << severity << "): " << message
+                  << std::endl;
+    }
+
+    bool RenderManagerOpenGL::checkForGLError(const char* message) {
+        if (m_glErrorsAsynchronous) {
+            return false;
+        }
+        GLenum err = glGetError();
+        if (err != GL_NO_ERROR) {
+            std::cout << message << ": OpenGL error " << err << std::endl;
+        }
+        return (err != GL_NO_ERROR);
+    }
+
+    bool RenderManagerOpenGL::checkForSetupGLError(const char* message) {
         GLenum err = glGetError();
         if (err != GL_NO_ERROR) {
             std::cout << message << ": OpenGL error " << err << std::endl;
@@ -146,7 +443,6 @@ namespace renderkit {
         m_doingOkay = true;
         m_displayOpen = false;
         m_GLContext = nullptr;
-        m_programId = 0;
 
         // Construct the appropriate GraphicsLibrary pointer.
         m_library.OpenGL = new GraphicsLibraryOpenGL;
@@ -159,15 +455,42 @@ namespace renderkit {
         if (m_displayOpen) {
 
             glDeleteFramebuffers(1, &m_frameBuffer);
+            if (!m_eyeFramebuffers.empty()) {
+                glDeleteFramebuffers(
+                    static_cast<GLsizei>(m_eyeFramebuffers.size()),
+                    m_eyeFramebuffers.data());
+                m_eyeFramebuffers.clear();
+            }
             size_t numEyes = GetNumEyes();
             // @todo Handle the case of multiple displays per eye
             for (size_t i = 0; i < numEyes; i++) {
-                glDeleteTextures(1, &m_colorBuffers[i].OpenGL->colorBufferName);
+                if (m_colorBufferArray == 0) {
+                    glDeleteTextures(
+                        1, &m_colorBuffers[i].OpenGL->colorBufferName);
+                }
                 delete m_colorBuffers[i].OpenGL;
-                glDeleteRenderbuffers(1, &m_depthBuffers[i]);
-                glDeleteVertexArrays(1, &m_distortVAO[i]);
-                glDeleteBuffers(1, &m_distortBuffer[i]);
-                delete[] m_triangleBuffer[i];
+            }
+            deleteDistortionMeshes();
+
+            glDeleteRenderbuffers(1, &m_sharedDepthBuffer.name);
+            m_sharedDepthBuffer.name = 0;
+            if (!m_eyeDepthBuffers.empty()) {
+                glDeleteRenderbuffers(
+                    static_cast<GLsizei>(m_eyeDepthBuffers.size()),
+                    m_eyeDepthBuffers.data());
+                m_eyeDepthBuffers.clear();
+            }
+            if (m_colorBufferArray != 0) {
+                glDeleteTextures(1, &m_colorBufferArray);
+                m_colorBufferArray = 0;
+            }
+            if (m_depthBufferArray != 0) {
+                glDeleteTextures(1, &m_depthBufferArray);
+                m_depthBufferArray = 0;
+            }
+            if (m_stereoFramebuffer != 0) {
+                glDeleteFramebuffers(1, &m_stereoFramebuffer);
+                m_stereoFramebuffer = 0;
             }
 
             /// @todo Clean up anything else we need to
@@ -190,51 +513,400 @@ namespace renderkit {
         glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
 
         //======================================================
-        // Create the render textures (and Z buffer textures) we're going
-        // to use to render into before presenting them as buffers to be
-        // displayed.  We make one per eye.  We'll set up to render into
-        // each of these before calling the render callbacks.
+        // Create the render textures we're going to use to render into
+        // before presenting them as buffers to be displayed.  We make one
+        // per eye, or one layer per eye of a texture array if asked to.
+        // We'll set up to render into each of these before calling the
+        // render callbacks.  The eyes share a depth buffer.
+        chooseRenderTargetFormats();
         size_t numEyes = GetNumEyes();
+        std::vector<GLsizei> widths(numEyes), heights(numEyes);
+        bool sameSize = true;
         for (size_t i = 0; i < numEyes; i++) {
+            // Determine the appropriate size for the frame buffer to be used
+            // for this eye.
+            OSVR_ViewportDescription v;
+            ConstructViewportForRender(i, v);
+            widths[i] = static_cast<GLsizei>(v.width);
+            heights[i] = static_cast<GLsizei>(v.height);
+            if (widths[i] != widths[0] || heights[i] != heights[0]) {
+                sameSize = false;
+            }
+        }
+
+        // The layers of an array texture all have the same size.
+        bool useArray = false;
+        if (m_params.m_renderTargetTextureArray) {
+#ifdef RM_USE_OPENGLES20
+            std::cerr << "RenderManagerOpenGL::constructRenderBuffers: "
+                         "Texture arrays are not available in OpenGL ES "
+                         "2.0, using a texture per eye"
+                      << std::endl;
+#else
+            if (sameSize && numEyes > 0) {
+                useArray = true;
+            } else {
+                std::cerr << "RenderManagerOpenGL::constructRenderBuffers: "
+                             "Eyes differ in size, using a texture per eye "
+                             "rather than a texture array"
+                          << std::endl;
+            }
+#endif
+        }
 
+        size_t depthBytesPerEye = 0;
+        GLsizei depthWidth = 0, depthHeight = 0;
+        m_depthBuffers.clear();
+#ifndef RM_USE_OPENGLES20
+        if (useArray) {
+            glGenTextures(1, &m_colorBufferArray);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_colorBufferArray);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0,
+                         m_renderTargetFormats.colorInternalFormat, widths[0],
+                         heights[0], static_cast<GLsizei>(numEyes), 0,
+                         m_renderTargetFormats.colorFormat,
+                         m_renderTargetFormats.colorType, 0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        }
+#endif
+        for (size_t i = 0; i < numEyes; i++) {
             // The color buffer for this eye
-            GLuint colorBufferName = 0;
-            glGenTextures(1, &colorBufferName);
             RenderBuffer rb;
             rb.OpenGL = new RenderBufferOpenGL;
-            rb.OpenGL->colorBufferName = colorBufferName;
+            if (useArray) {
+                rb.OpenGL->colorBufferName = m_colorBufferArray;
+            } else {
+                GLuint colorBufferName = 0;
+                glGenTextures(1, &colorBufferName);
+                rb.OpenGL->colorBufferName = colorBufferName;
+
+                // "Bind" the newly created texture : all future texture
+                // functions will modify this texture
+                glBindTexture(GL_TEXTURE_2D, colorBufferName);
+
+                // Give an empty image to OpenGL ( the last "0" means
+                // "empty" )
+                glTexImage2D(GL_TEXTURE_2D, 0,
+                             m_renderTargetFormats.colorInternalFormat,
+                             widths[i], heights[i], 0,
+                             m_renderTargetFormats.colorFormat,
+                             m_renderTargetFormats.colorType, 0);
+            }
             m_colorBuffers.push_back(rb);
 
-            // "Bind" the newly created texture : all future texture functions
-            // will modify this texture
-            // glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, colorBufferName);
+            // Keep track of how big the depth buffer needs to be.
+            if (widths[i] > depthWidth) {
+                depthWidth = widths[i];
+            }
+            if (heights[i] > depthHeight) {
+                depthHeight = heights[i];
+            }
+            depthBytesPerEye += static_cast<size_t>(widths[i]) * heights[i] *
+                                m_renderTargetFormats.depthBytesPerPixel;
+        }
 
-            // Determine the appropriate size for the frame buffer to be used
-            // for
-            // this eye.
-            OSVR_ViewportDescription v;
-            ConstructViewportForRender(i, v);
-            int width = static_cast<int>(v.width);
-            int height = static_cast<int>(v.height);
+#ifndef RM_USE_OPENGLES20
+        // With a texture array, the depth buffer is a matching array, so
+        // that all eyes can be attached at once for single-pass stereo.
+        // Each eye gets a framebuffer with its layers attached, which is
+        // checked for completeness once here rather than every time the
+        // eye is rendered.  A layered framebuffer with all of the layers
+        // attached is used for stereo render callbacks.
+        if (useArray) {
+            glGenTextures(1, &m_depthBufferArray);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthBufferArray);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0,
+                         m_renderTargetFormats.depthInternalFormat, widths[0],
+                         heights[0], static_cast<GLsizei>(numEyes), 0,
+                         GL_DEPTH_COMPONENT, GL_FLOAT, 0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+            m_eyeFramebuffers.assign(numEyes, 0);
+            glGenFramebuffers(static_cast<GLsizei>(numEyes),
+                              m_eyeFramebuffers.data());
+            for (size_t i = 0; i < numEyes; i++) {
+                glBindFramebuffer(GL_FRAMEBUFFER, m_eyeFramebuffers[i]);
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          m_colorBufferArray, 0,
+                                          static_cast<GLint>(i));
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                          m_depthBufferArray, 0,
+                                          static_cast<GLint>(i));
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+                    GL_FRAMEBUFFER_COMPLETE) {
+                    std::cerr << "RenderManagerOpenGL::constructRenderBuffers: "
+                                 "Incomplete framebuffer for eye "
+                              << i << std::endl;
+                    return false;
+                }
+            }
+
+            glGenFramebuffers(1, &m_stereoFramebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_stereoFramebuffer);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                 m_colorBufferArray, 0);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                 m_depthBufferArray, 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+                GL_FRAMEBUFFER_COMPLETE) {
+                std::cerr << "RenderManagerOpenGL::constructRenderBuffers: "
+                             "Incomplete layered framebuffer, stereo "
+                             "callbacks will be called for each eye"
+                          << std::endl;
+                glDeleteFramebuffers(1, &m_stereoFramebuffer);
+                m_stereoFramebuffer = 0;
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+
+            // Register the render buffers we're going to use to present
+            return RegisterRenderBuffersInternal(m_colorBuffers);
+        }
+#endif
+
+        // Eyes that are rendered at the same time each need their own depth
+        // buffer.
+        if (m_params.m_parallelEyeRendering) {
+            m_eyeDepthBuffers.assign(numEyes, 0);
+            glGenRenderbuffers(static_cast<GLsizei>(numEyes),
+                               m_eyeDepthBuffers.data());
+            for (size_t i = 0; i < numEyes; i++) {
+                glBindRenderbuffer(GL_RENDERBUFFER, m_eyeDepthBuffers[i]);
+                glRenderbufferStorage(GL_RENDERBUFFER,
+                                      m_renderTargetFormats.depthInternalFormat,
+                                      widths[i], heights[i]);
+            }
+            m_depthBuffers = m_eyeDepthBuffers;
 
-            // Give an empty image to OpenGL ( the last "0" means "empty" )
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-                         GL_UNSIGNED_BYTE, 0);
+            // Register the render buffers we're going to use to present
+            return RegisterRenderBuffersInternal(m_colorBuffers);
+        }
 
-            // The depth buffer
-            GLuint depthrenderbuffer;
-            glGenRenderbuffers(1, &depthrenderbuffer);
-            glBindRenderbuffer(GL_RENDERBUFFER, depthrenderbuffer);
-            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width,
-                                  height);
-            m_depthBuffers.push_back(depthrenderbuffer);
+        // The depth buffer, shared by all eyes
+        GLuint depthrenderbuffer =
+            acquireSharedDepthBuffer(depthWidth, depthHeight);
+        m_depthBuffers.assign(numEyes, depthrenderbuffer);
+        size_t sharedBytes =
+            static_cast<size_t>(m_sharedDepthBuffer.width) *
+            m_sharedDepthBuffer.height *
+            m_renderTargetFormats.depthBytesPerPixel;
+        m_depthBytesSaved =
+            depthBytesPerEye > sharedBytes ? depthBytesPerEye - sharedBytes : 0;
+        if (m_depthBytesSaved > 0) {
+            std::cout << "RenderManagerOpenGL: " << numEyes
+                      << " eyes share one " << m_sharedDepthBuffer.width
+                      << "x" << m_sharedDepthBuffer.height
+                      << " depth buffer, saving about " << m_depthBytesSaved
+                      << " bytes" << std::endl;
         }
 
         // Register the render buffers we're going to use to present
         return RegisterRenderBuffersInternal(m_colorBuffers);
     }
 
+    GLuint RenderManagerOpenGL::acquireSharedDepthBuffer(GLsizei width,
+                                                         GLsizei height) {
+        if (m_sharedDepthBuffer.name != 0 &&
+            m_sharedDepthBuffer.width >= width &&
+            m_sharedDepthBuffer.height >= height) {
+            return m_sharedDepthBuffer.name;
+        }
+
+        // Grow to cover both the old and the new size, so that alternating
+        // requests don't keep reallocating.
+        if (m_sharedDepthBuffer.name == 0) {
+            glGenRenderbuffers(1, &m_sharedDepthBuffer.name);
+        }
+        if (width > m_sharedDepthBuffer.width) {
+            m_sharedDepthBuffer.width = width;
+        }
+        if (height > m_sharedDepthBuffer.height) {
+            m_sharedDepthBuffer.height = height;
+        }
+        m_sharedDepthBuffer.format = m_renderTargetFormats.depthInternalFormat;
+        glBindRenderbuffer(GL_RENDERBUFFER, m_sharedDepthBuffer.name);
+        glRenderbufferStorage(GL_RENDERBUFFER,
+                              m_renderTargetFormats.depthInternalFormat,
+                              m_sharedDepthBuffer.width,
+                              m_sharedDepthBuffer.height);
+        return m_sharedDepthBuffer.name;
+    }
+
+    void RenderManagerOpenGL::deleteDistortionMeshes() {
+        for (size_t i = 0; i < m_distortVAO.size(); i++) {
+            glDeleteVertexArrays(1, &m_distortVAO[i]);
+        }
+        m_distortVAO.clear();
+        for (size_t i = 0; i < m_distortBuffer.size(); i++) {
+            glDeleteBuffers(1, &m_distortBuffer[i]);
+        }
+        m_distortBuffer.clear();
+        for (size_t i = 0; i < m_triangleBuffer.size(); i++) {
+            delete[] m_triangleBuffer[i];
+        }
+        m_triangleBuffer.clear();
+        m_numTriangles.clear();
+    }
+
+    void RenderManagerOpenGL::chooseRenderTargetFormats() {
+        typedef ConstructorParameters CP;
+        CP::Render_Target_Color_Format color =
+            m_params.m_renderTargetColorFormat;
+        CP::Render_Target_Depth_Format depth =
+            m_params.m_renderTargetDepthFormat;
+
+        m_renderTargetFormats.colorInternalFormat = GL_RGB;
+        m_renderTargetFormats.colorFormat = GL_RGB;
+        m_renderTargetFormats.colorType = GL_UNSIGNED_BYTE;
+        m_renderTargetFormats.depthInternalFormat = GL_DEPTH_COMPONENT;
+        m_renderTargetFormats.depthBytesPerPixel = 4;
+
+#ifdef RM_USE_OPENGLES20
+        // OpenGL ES 2.0 has none of the sized formats.
+        if (color != CP::Color_Default || depth != CP::Depth_Default) {
+            std::cerr << "RenderManagerOpenGL::chooseRenderTargetFormats: "
+                         "Render-target formats cannot be selected under "
+                         "OpenGL ES 2.0, using the defaults"
+                      << std::endl;
+        }
+#else
+        GLint colorInternalFormat = GL_RGB;
+        GLenum colorFormat = GL_RGB;
+        GLenum colorType = GL_UNSIGNED_BYTE;
+        switch (color) {
+        case CP::Color_RGBA8:
+            colorInternalFormat = GL_RGBA8;
+            colorFormat = GL_RGBA;
+            break;
+        case CP::Color_RGB10_A2:
+            colorInternalFormat = GL_RGB10_A2;
+            colorFormat = GL_RGBA;
+            colorType = GL_UNSIGNED_INT_2_10_10_10_REV;
+            break;
+        case CP::Color_R11G11B10F:
+            colorInternalFormat = GL_R11F_G11F_B10F;
+            colorType = GL_UNSIGNED_INT_10F_11F_11F_REV;
+            break;
+        case CP::Color_RGBA16F:
+            colorInternalFormat = GL_RGBA16F;
+            colorFormat = GL_RGBA;
+            colorType = GL_HALF_FLOAT;
+            break;
+        default:
+            break;
+        }
+
+        GLenum depthInternalFormat = GL_DEPTH_COMPONENT;
+        size_t depthBytesPerPixel = 4;
+        switch (depth) {
+        case CP::Depth_16:
+            depthInternalFormat = GL_DEPTH_COMPONENT16;
+            depthBytesPerPixel = 2;
+            break;
+        case CP::Depth_24:
+            depthInternalFormat = GL_DEPTH_COMPONENT24;
+            break;
+        case CP::Depth_32F:
+            depthInternalFormat = GL_DEPTH_COMPONENT32F;
+            break;
+        default:
+            break;
+        }
+
+        // All of these formats are required to be renderable in OpenGL 3.0
+        // and later, but drivers may still refuse them, so ask when the
+        // driver lets us and check by attaching a small buffer of each to
+        // the framebuffer, which is bound by our caller.
+        if (color != CP::Color_Default) {
+            GLint supported = GL_FULL_SUPPORT;
+            if (GLEW_ARB_internalformat_query2) {
+                glGetInternalformativ(GL_TEXTURE_2D, colorInternalFormat,
+                                      GL_FRAMEBUFFER_RENDERABLE, 1,
+                                      &supported);
+            }
+            GLuint texture = 0;
+            if (supported != GL_NONE) {
+                glGenTextures(1, &texture);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glTexImage2D(GL_TEXTURE_2D, 0, colorInternalFormat, 16, 16, 0,
+                             colorFormat, colorType, 0);
+                glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                     texture, 0);
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+                    GL_FRAMEBUFFER_COMPLETE) {
+                    supported = GL_NONE;
+                }
+                glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0,
+                                     0);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glDeleteTextures(1, &texture);
+            }
+            if (supported != GL_NONE) {
+                m_renderTargetFormats.colorInternalFormat =
+                    colorInternalFormat;
+                m_renderTargetFormats.colorFormat = colorFormat;
+                m_renderTargetFormats.colorType = colorType;
+            } else {
+                std::cerr << "RenderManagerOpenGL::chooseRenderTargetFormats: "
+                             "Cannot render to the requested color format, "
+                             "using the default"
+                          << std::endl;
+            }
+        }
+
+        if (depth != CP::Depth_Default) {
+            GLint supported = GL_FULL_SUPPORT;
+            if (GLEW_ARB_internalformat_query2) {
+                glGetInternalformativ(GL_RENDERBUFFER, depthInternalFormat,
+                                      GL_FRAMEBUFFER_RENDERABLE, 1,
+                                      &supported);
+            }
+            if (supported != GL_NONE) {
+                // A depth attachment on its own is complete once color
+                // output is disabled, so nothing else needs attaching.
+                GLuint renderbuffer = 0;
+                glGenRenderbuffers(1, &renderbuffer);
+                glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+                glRenderbufferStorage(GL_RENDERBUFFER, depthInternalFormat,
+                                      16, 16);
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                          GL_RENDERBUFFER, renderbuffer);
+                glDrawBuffer(GL_NONE);
+                glReadBuffer(GL_NONE);
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+                    GL_FRAMEBUFFER_COMPLETE) {
+                    supported = GL_NONE;
+                }
+                glDrawBuffer(GL_COLOR_ATTACHMENT0);
+                glReadBuffer(GL_COLOR_ATTACHMENT0);
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                          GL_RENDERBUFFER, 0);
+                glBindRenderbuffer(GL_RENDERBUFFER, 0);
+                glDeleteRenderbuffers(1, &renderbuffer);
+            }
+            if (supported != GL_NONE) {
+                m_renderTargetFormats.depthInternalFormat =
+                    depthInternalFormat;
+                m_renderTargetFormats.depthBytesPerPixel = depthBytesPerPixel;
+            } else {
+                std::cerr << "RenderManagerOpenGL::chooseRenderTargetFormats: "
+                             "Cannot render to the requested depth format, "
+                             "using the default"
+                          << std::endl;
+            }
+        }
+#endif
+
+        // The shared depth buffer must be reallocated if its format changed.
+        if (m_sharedDepthBuffer.name != 0 &&
+            m_sharedDepthBuffer.format !=
+                m_renderTargetFormats.depthInternalFormat) {
+            glDeleteRenderbuffers(1, &m_sharedDepthBuffer.name);
+            m_sharedDepthBuffer.name = 0;
+            m_sharedDepthBuffer.width = 0;
+            m_sharedDepthBuffer.height = 0;
+        }
+    }
+
     bool RenderManagerOpenGL::addOpenGLContext(GLContextParams p) {
         // Initialize the SDL video subsystem.
         if (!m_sdl_initialized) {
@@ -275,6 +947,13 @@ namespace renderkit {
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
             SDL_GL_CONTEXT_PROFILE_CORE);
 #endif
+#ifndef RM_USE_OPENGLES20
+        // Drivers only have to call a debug callback for a debug context.
+        // The contexts that are later made to share with this one get the
+        // same flags.
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
+                            p.debug ? SDL_GL_CONTEXT_DEBUG_FLAG : 0);
+#endif
 
         // For now, append the display ID to the title.
         /// @todo Make a different title for each window in the config file
@@ -325,11 +1004,26 @@ namespace renderkit {
     }
 
     bool RenderManagerOpenGL::removeOpenGLContexts() {
-        if (m_programId != 0) {
-            glDeleteProgram(m_programId);
-            m_programId = 0;
+        stopEyeWorkers();
+        for (size_t i = 0; i < PRESENT_PROGRAM_VARIANTS; i++) {
+            if (m_presentPrograms[i].id != 0) {
+                glDeleteProgram(m_presentPrograms[i].id);
+                m_presentPrograms[i].id = 0;
+            }
+        }
+#ifndef RM_USE_OPENGLES20
+        if (m_presentUBO != 0) {
+            glDeleteBuffers(1, &m_presentUBO);
+            m_presentUBO = 0;
         }
+        if (m_presentSampler != 0) {
+            glDeleteSamplers(1, &m_presentSampler);
+            m_presentSampler = 0;
+        }
+#endif
         if (m_GLContext) {
+            // The debug callback is handed a pointer to us.
+            removeGLDebugCallback();
             SDL_GL_DeleteContext(m_GLContext);
             m_GLContext = 0;
         }
@@ -387,6 +1081,7 @@ namespace renderkit {
         p.bitsPerPixel = m_params.m_bitsPerColor;
         p.numBuffers = m_params.m_numBuffers;
         p.visible = true;
+        p.debug = !m_params.m_synchronousGLErrorChecks;
         for (size_t display = 0; display < GetNumDisplays(); display++) {
             if (!addOpenGLContext(p)) {
                 std::cerr << "RenderManagerOpenGL::OpenDisplay: Cannot get GL "
@@ -440,59 +1135,54 @@ namespace renderkit {
             ret.status = FAILURE;
             return ret;
         }
+        checkForSetupGLError(
+            "RenderManagerOpenGL::OpenDisplay constructing render buffers");
 
         //======================================================
-        // Construct the shaders and program we'll use to present things
-        // handling ATW/distortion.
-        GLuint vertexShaderId;   //< Vertex shader for ATW/distortion
-        GLuint fragmentShaderId; //< Fragment shader for ATW/distortion
-
-        vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShaderId, 1, &distortionVertexShader, nullptr);
-        glCompileShader(vertexShaderId);
-        if (!checkShaderError(vertexShaderId)) {
+        // Start the threads that render the eyes, if we're asked to.
+        if (!startEyeWorkers()) {
             removeOpenGLContexts();
             std::cerr << "RenderManagerOpenGL::OpenDisplay: Could not "
-                         "construct vertex shader "
+                         "start eye rendering threads"
                       << std::endl;
             ret.status = FAILURE;
             return ret;
         }
 
-        fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShaderId, 1, &distortionFragmentShader, nullptr);
-        glCompileShader(fragmentShaderId);
-        if (!checkShaderError(fragmentShaderId)) {
-            removeOpenGLContexts();
-            std::cerr << "RenderManagerOpenGL::OpenDisplay: Could not "
-                         "construct fragment shader "
-                      << std::endl;
-            ret.status = FAILURE;
-            return ret;
-        }
-
-        m_programId = glCreateProgram();
-        glAttachShader(m_programId, vertexShaderId);
-        glAttachShader(m_programId, fragmentShaderId);
-        glLinkProgram(m_programId);
-        if (!checkProgramError(m_programId)) {
-            removeOpenGLContexts();
-            std::cerr << "RenderManagerOpenGL::OpenDisplay: Could not link "
-                         "shader program "
-                      << std::endl;
-            ret.status = FAILURE;
-            return ret;
+        //======================================================
+        // The shader programs we'll use to present things handling
+        // ATW/distortion are built when the distortion meshes are, since
+        // which variant we need depends on the meshes.
+#ifndef RM_USE_OPENGLES20
+        //======================================================
+        // Construct the uniform buffer that holds the matrices for all of
+        // the eyes, with each eye's matrices starting on an offset that we
+        // are allowed to bind, and the sampler we use to read the eye
+        // textures.  Both are shared with any other contexts that share
+        // with this one.
+        GLint uniformAlignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        if (uniformAlignment < 1) {
+            uniformAlignment = 1;
         }
-
-        m_projectionUniformId =
-            glGetUniformLocation(m_programId, "projectionMatrix");
-        m_modelViewUniformId =
-            glGetUniformLocation(m_programId, "modelViewMatrix");
-        m_textureUniformId = glGetUniformLocation(m_programId, "textureMatrix");
-
-        // Now that they are linked, we don't need to keep them around.
-        glDeleteShader(vertexShaderId);
-        glDeleteShader(fragmentShaderId);
+        m_presentUniformStride =
+            (sizeof(PresentEyeUniforms) + uniformAlignment - 1) /
+            uniformAlignment * uniformAlignment;
+        glGenBuffers(1, &m_presentUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_presentUBO);
+        glBufferData(GL_UNIFORM_BUFFER, GetNumEyes() * m_presentUniformStride,
+                     nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        // Bilinear filtering and clamp to the edge of the texture.
+        glGenSamplers(1, &m_presentSampler);
+        glSamplerParameteri(m_presentSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glSamplerParameteri(m_presentSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glSamplerParameteri(m_presentSampler, GL_TEXTURE_WRAP_S,
+                            GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(m_presentSampler, GL_TEXTURE_WRAP_T,
+                            GL_CLAMP_TO_EDGE);
+#endif
 
         if (!UpdateDistortionMeshesInternal(SQUARE,
                                             m_params.m_distortionParameters)) {
@@ -510,7 +1200,12 @@ namespace renderkit {
         ret.library = m_library;
         ret.buffers = m_buffers;
 
-        checkForGLError("RenderManagerOpenGL::OpenDisplay");
+        checkForSetupGLError("RenderManagerOpenGL::OpenDisplay");
+
+        //======================================================
+        // From here on, have errors reported to us by the driver rather
+        // than asking for them, if we can.
+        m_glErrorsAsynchronous = installGLDebugCallback();
 
         //======================================================
         // Done, we now have an open window to use.
@@ -533,30 +1228,54 @@ namespace renderkit {
             return false;
         }
 
+        // With a texture array, each eye has its own framebuffer that was
+        // checked when it was built, so there is nothing to attach.  The
+        // same goes for eyes rendered by a worker thread, which uses the
+        // framebuffer it built in its own context.
+        GLuint framebuffer = m_frameBuffer;
+        bool attach = true;
+        if (eye < m_eyeFramebuffers.size()) {
+            framebuffer = m_eyeFramebuffers[eye];
+            attach = false;
+        }
+#ifndef RM_USE_OPENGLES20
+        if (eye < m_eyeWorkers.size()) {
+            framebuffer = m_eyeWorkers[eye]->framebuffer;
+            attach = false;
+        }
+#endif
+
         // Render to our framebuffer
-        glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
         if (checkForGLError(
                 "RenderManagerOpenGL::RenderEyeInitialize glBindFrameBuffer")) {
             return false;
         }
 
-        // Set color and depth buffers for the frame buffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                             m_colorBuffers[eye].OpenGL->colorBufferName, 0);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                                  GL_RENDERBUFFER, m_depthBuffers[eye]);
-        if (checkForGLError(
-                "RenderManagerOpenGL::RenderEyeInitialize Setting textures")) {
-            return false;
-        }
+        if (attach) {
+            // Set color and depth buffers for the frame buffer
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_2D,
+                                   m_colorBuffers[eye].OpenGL->colorBufferName,
+                                   0);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                      GL_RENDERBUFFER, m_depthBuffers[eye]);
+            // We're about to wait for the framebuffer check anyway, so
+            // also ask about errors from attaching to it.
+            if (checkForSetupGLError(
+                    "RenderManagerOpenGL::RenderEyeInitialize "
+                    "Setting textures")) {
+                return false;
+            }
 
-        // Always check that our framebuffer is ok
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
-            GL_FRAMEBUFFER_COMPLETE) {
-            std::cerr << "RenderManagerOpenGL::RenderEyeInitialize: Incomplete "
-                         "Framebuffer"
-                      << std::endl;
-            return false;
+            // Always check that our framebuffer is ok
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+                GL_FRAMEBUFFER_COMPLETE) {
+                std::cerr << "RenderManagerOpenGL::RenderEyeInitialize: "
+                             "Incomplete Framebuffer"
+                          << std::endl;
+                return false;
+            }
         }
 
         // Call the display set-up callback for each eye, because they each
@@ -572,6 +1291,291 @@ namespace renderkit {
         return true;
     }
 
+    bool RenderManagerOpenGL::RenderEyeHiddenArea(size_t eye) {
+        if (!m_params.m_hiddenAreaDepthMask ||
+            eye >= m_renderInfoForRender.size()) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(m_hiddenAreaLock);
+        if (eye >= m_hiddenAreas.size() || m_hiddenAreas[eye].empty()) {
+            return true;
+        }
+
+        // Save the state we change, which the application may be using.
+        GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+        GLint scissorBox[4];
+        glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+        GLboolean depthMask;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+        GLfloat depthClear;
+        glGetFloatv(GL_DEPTH_CLEAR_VALUE, &depthClear);
+
+        glEnable(GL_SCISSOR_TEST);
+        glDepthMask(GL_TRUE);
+#ifdef RM_USE_OPENGLES20
+        glClearDepthf(m_params.m_hiddenAreaDepthClearValue);
+#else
+        glClearDepth(m_params.m_hiddenAreaDepthClearValue);
+#endif
+
+        // The rectangles are rounded inward to whole pixels, so that no
+        // pixel that is sampled is cleared.
+        const OSVR_ViewportDescription& v =
+            m_renderInfoForRender[eye].viewport;
+        const std::vector<OSVR_ViewportDescription>& rects =
+            m_hiddenAreas[eye];
+        for (size_t i = 0; i < rects.size(); i++) {
+            const OSVR_ViewportDescription& r = rects[i];
+            GLint left =
+                static_cast<GLint>(std::ceil(v.left + r.left * v.width));
+            GLint right = static_cast<GLint>(
+                std::floor(v.left + (r.left + r.width) * v.width));
+            GLint lower =
+                static_cast<GLint>(std::ceil(v.lower + r.lower * v.height));
+            GLint upper = static_cast<GLint>(
+                std::floor(v.lower + (r.lower + r.height) * v.height));
+            if (right > left && upper > lower) {
+                glScissor(left, lower, right - left, upper - lower);
+                glClear(GL_DEPTH_BUFFER_BIT);
+            }
+        }
+
+#ifdef RM_USE_OPENGLES20
+        glClearDepthf(depthClear);
+#else
+        glClearDepth(depthClear);
+#endif
+        glDepthMask(depthMask);
+        glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+        if (!scissorTest) {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        return !checkForGLError("RenderManagerOpenGL::RenderEyeHiddenArea");
+    }
+
+    bool RenderManagerOpenGL::RenderDisplayEyes(size_t display,
+                                                const RenderParams& params,
+                                                bool stereoPerEye) {
+#ifndef RM_USE_OPENGLES20
+        if (!m_eyeWorkers.empty()) {
+            size_t first = display * GetNumEyesPerDisplay();
+            size_t last = first + GetNumEyesPerDisplay();
+
+            // Hand each eye to its worker and wait for them all to finish.
+            std::unique_lock<std::mutex> lock(m_eyeWorkerLock);
+            m_eyeWorkerParams = &params;
+            m_eyeWorkerStereoPerEye = stereoPerEye;
+            for (size_t eye = first; eye < last; eye++) {
+                m_eyeWorkers[eye]->pending = true;
+            }
+            m_eyeWorkerCondition.notify_all();
+            m_eyeWorkerCondition.wait(lock, [&]() {
+                for (size_t eye = first; eye < last; eye++) {
+                    if (m_eyeWorkers[eye]->pending) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+            m_eyeWorkerParams = nullptr;
+
+            // The workers' commands may still be running on the card, so
+            // have this context's later commands wait for them there,
+            // without blocking this thread.
+            bool ok = true;
+            for (size_t eye = first; eye < last; eye++) {
+                EyeWorker& worker = *m_eyeWorkers[eye];
+                if (worker.fence != nullptr) {
+                    glWaitSync(worker.fence, 0, GL_TIMEOUT_IGNORED);
+                    glDeleteSync(worker.fence);
+                    worker.fence = nullptr;
+                }
+                if (!worker.ok) {
+                    ok = false;
+                }
+            }
+            return ok;
+        }
+#endif
+        return RenderManager::RenderDisplayEyes(display, params, stereoPerEye);
+    }
+
+    bool RenderManagerOpenGL::startEyeWorkers() {
+        if (!m_params.m_parallelEyeRendering) {
+            return true;
+        }
+#ifdef RM_USE_OPENGLES20
+        std::cerr << "RenderManagerOpenGL::startEyeWorkers: Parallel eye "
+                     "rendering is not available in OpenGL ES 2.0, "
+                     "rendering the eyes in turn"
+                  << std::endl;
+        return true;
+#else
+        if (!GLEW_ARB_sync) {
+            std::cerr << "RenderManagerOpenGL::startEyeWorkers: Parallel eye "
+                         "rendering needs sync objects, rendering the eyes "
+                         "in turn"
+                      << std::endl;
+            return true;
+        }
+
+        size_t numEyes = GetNumEyes();
+        m_eyeWorkersQuit = false;
+        SDL_Window* currentWindow = SDL_GL_GetCurrentWindow();
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            // Each worker's context is made on the window of the display
+            // its eye is on, which need not be compatible with the first
+            // display's.  Creating a context makes it current, so we put
+            // ours back before the worker makes its own current on its
+            // thread.
+            std::unique_ptr<EyeWorker> worker(new EyeWorker);
+            worker->window = m_displays[GetDisplayUsedByEye(eye)].m_window;
+            SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+            worker->context = SDL_GL_CreateContext(worker->window);
+            SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+            SDL_GL_MakeCurrent(currentWindow, m_GLContext);
+            if (worker->context == nullptr) {
+                std::cerr << "RenderManagerOpenGL::startEyeWorkers: Could "
+                             "not get OpenGL context for eye "
+                          << eye << ": " << SDL_GetError() << std::endl;
+                stopEyeWorkers();
+                return false;
+            }
+            EyeWorker* w = worker.get();
+            m_eyeWorkers.push_back(std::move(worker));
+            w->thread =
+                std::thread(&RenderManagerOpenGL::eyeWorkerFunc, this, eye, w);
+        }
+
+        // Wait for the workers to build their framebuffers.
+        bool ok = true;
+        {
+            std::unique_lock<std::mutex> lock(m_eyeWorkerLock);
+            m_eyeWorkerCondition.wait(lock, [&]() {
+                for (size_t eye = 0; eye < m_eyeWorkers.size(); eye++) {
+                    if (!m_eyeWorkers[eye]->started) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+            for (size_t eye = 0; eye < m_eyeWorkers.size(); eye++) {
+                if (!m_eyeWorkers[eye]->ok) {
+                    ok = false;
+                }
+            }
+        }
+        if (!ok) {
+            std::cerr << "RenderManagerOpenGL::startEyeWorkers: Could not "
+                         "construct eye framebuffers"
+                      << std::endl;
+            stopEyeWorkers();
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    void RenderManagerOpenGL::stopEyeWorkers() {
+#ifndef RM_USE_OPENGLES20
+        if (m_eyeWorkers.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_eyeWorkerLock);
+            m_eyeWorkersQuit = true;
+        }
+        m_eyeWorkerCondition.notify_all();
+        for (size_t eye = 0; eye < m_eyeWorkers.size(); eye++) {
+            EyeWorker& worker = *m_eyeWorkers[eye];
+            if (worker.thread.joinable()) {
+                worker.thread.join();
+            }
+            if (worker.fence != nullptr) {
+                glDeleteSync(worker.fence);
+            }
+            if (worker.context != nullptr) {
+                SDL_GL_DeleteContext(worker.context);
+            }
+        }
+        m_eyeWorkers.clear();
+#endif
+    }
+
+#ifndef RM_USE_OPENGLES20
+    void RenderManagerOpenGL::eyeWorkerFunc(size_t eye, EyeWorker* worker) {
+        SDL_GL_MakeCurrent(worker->window, worker->context);
+
+        // Build the framebuffer for this eye, attaching the same buffers
+        // the application's context would.
+        glGenFramebuffers(1, &worker->framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, worker->framebuffer);
+        if (m_colorBufferArray != 0) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                      m_colorBufferArray, 0,
+                                      static_cast<GLint>(eye));
+        } else {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_2D,
+                                   m_colorBuffers[eye].OpenGL->colorBufferName,
+                                   0);
+        }
+        if (m_depthBufferArray != 0) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                      m_depthBufferArray, 0,
+                                      static_cast<GLint>(eye));
+        } else {
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                      GL_RENDERBUFFER, m_depthBuffers[eye]);
+        }
+        bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+                  GL_FRAMEBUFFER_COMPLETE;
+
+        std::unique_lock<std::mutex> lock(m_eyeWorkerLock);
+        worker->started = true;
+        worker->ok = ok;
+        m_eyeWorkerCondition.notify_all();
+        while (true) {
+            m_eyeWorkerCondition.wait(
+                lock, [&]() { return m_eyeWorkersQuit || worker->pending; });
+            if (m_eyeWorkersQuit) {
+                break;
+            }
+            const RenderParams& params = *m_eyeWorkerParams;
+            bool stereoPerEye = m_eyeWorkerStereoPerEye;
+            lock.unlock();
+
+            // Render the eye, then flush so that the fence that marks the
+            // end of its commands is on its way to the card before the
+            // application's context waits on it.
+            bool rendered = ok && RenderEye(eye, params, stereoPerEye);
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+
+            lock.lock();
+            worker->fence = fence;
+            worker->ok = rendered;
+            worker->pending = false;
+            m_eyeWorkerCondition.notify_all();
+        }
+        lock.unlock();
+
+        glDeleteFramebuffers(1, &worker->framebuffer);
+        worker->framebuffer = 0;
+        SDL_GL_MakeCurrent(worker->window, nullptr);
+    }
+#endif
+
+    bool RenderManagerOpenGL::RenderStereoInitialize() {
+        // Render to all of the eyes' layers at once.  The per-eye passes
+        // have already cleared them.
+        glBindFramebuffer(GL_FRAMEBUFFER, m_stereoFramebuffer);
+        if (checkForGLError("RenderManagerOpenGL::RenderStereoInitialize")) {
+            return false;
+        }
+        return true;
+    }
+
     bool RenderManagerOpenGL::RenderSpace(
         size_t whichSpace //< Index into m_callbacks vector
         , size_t whichEye //< Which eye are we rendering for?
@@ -600,16 +1604,7 @@ namespace renderkit {
             distort //< Distortion parameters
         ) {
         // Clear the triangle and quad buffers if we have created them before.
-        m_numTriangles.clear();
-        m_triangleBuffer.clear();
-        for (size_t i = 0; i < m_distortVAO.size(); i++) {
-            glDeleteVertexArrays(1, &m_distortVAO[i]);
-        }
-        m_distortVAO.clear();
-        for (size_t i = 0; i < m_distortBuffer.size(); i++) {
-            glDeleteBuffers(1, &m_distortBuffer[i]);
-        }
-        m_distortBuffer.clear();
+        deleteDistortionMeshes();
 
         // Construct the data buffer that will hold the vertices and texture
         // coordinates
@@ -626,13 +1621,17 @@ namespace renderkit {
             removeOpenGLContexts();
             return false;
         }
+        m_distortionIsIdentity.clear();
+        bool chromatic = false;
         for (size_t eye = 0; eye < numEyes; eye++) {
 
             m_numTriangles.push_back(0);
             m_triangleBuffer.push_back(nullptr);
+            m_distortionIsIdentity.push_back(
+                DistortionIsIdentity(distort[eye]));
 
             std::vector<RenderManager::DistortionMeshVertex> mesh =
-                ComputeDistortionMesh(eye, type, distort[eye]);
+                GetDistortionMesh(eye, type, distort);
             m_numTriangles[eye] = mesh.size() / 3;
             if (m_numTriangles[eye] == 0) {
                 std::cerr << "RenderManagerOpenGL::UpdateDistortionMesh: Could "
@@ -641,6 +1640,12 @@ namespace renderkit {
                 removeOpenGLContexts();
                 return false;
             }
+            // If red, green and blue are distorted differently anywhere, we
+            // need the shader that looks them up separately.
+            for (size_t v = 0; v < mesh.size() && !chromatic; v++) {
+                chromatic = !(mesh[v].m_texRed == mesh[v].m_texGreen) ||
+                            !(mesh[v].m_texRed == mesh[v].m_texBlue);
+            }
             // 4 floats for position, 2 for each texture coordinate (R,G,B)
             m_triangleBuffer[eye] =
                 new GLfloat[m_numTriangles[eye] * 3 * (4 + 2 + 2 + 2)];
@@ -681,15 +1686,199 @@ namespace renderkit {
             glBufferData(GL_ARRAY_BUFFER, m_numTriangles[eye] * 3 *
                                               (4 + 2 + 2 + 2) * sizeof(GLfloat),
                          m_triangleBuffer[eye], GL_STATIC_DRAW);
+
+            // Record where each attribute lives in the vertex array object,
+            // so that presenting only has to bind it.
+            char* base = nullptr;
+            size_t vertBase = 0;
+            size_t redBase =
+                vertBase + m_numTriangles[eye] * 3 * 4 * sizeof(GLfloat);
+            size_t greenBase =
+                redBase + m_numTriangles[eye] * 3 * 2 * sizeof(GLfloat);
+            size_t blueBase =
+                greenBase + m_numTriangles[eye] * 3 * 2 * sizeof(GLfloat);
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, base + vertBase);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, base + redBase);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0,
+                                  base + greenBase);
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, base + blueBase);
+            glEnableVertexAttribArray(3);
+            glBindVertexArray(0);
+
             m_distortBuffer.push_back(distortBuffer);
             m_distortVAO.push_back(distortVAO);
         }
 
+        if (!selectPresentProgram(chromatic)) {
+            std::cerr << "RenderManagerOpenGL::UpdateDistortionMesh: Could "
+                         "not construct shader program"
+                      << std::endl;
+            removeOpenGLContexts();
+            return false;
+        }
+        return true;
+    }
+
+    bool RenderManagerOpenGL::selectPresentProgram(bool chromatic) {
+        MultiResolutionRemap remap;
+        unsigned variant =
+            (chromatic ? PRESENT_PROGRAM_CHROMATIC : 0) |
+            (m_params.m_enableTimeWarp ? PRESENT_PROGRAM_TIME_WARP : 0) |
+            (GetMultiResolutionRemap(remap) ? PRESENT_PROGRAM_MULTI_RES : 0);
+        if (!buildPresentProgram(variant)) {
+            return false;
+        }
+        // Our own buffers are presented from the texture array, while any
+        // the application hands us are plain textures, so both are needed.
+        if (m_params.m_renderTargetTextureArray &&
+            !buildPresentProgram(variant | PRESENT_PROGRAM_TEXTURE_ARRAY)) {
+            return false;
+        }
+        m_presentProgram = variant;
+        return true;
+    }
+
+    bool RenderManagerOpenGL::buildPresentProgram(unsigned variant) {
+        if (m_presentPrograms[variant].id != 0) {
+            return true;
+        }
+
+        // Construct the shaders and program for this variant, selecting it
+        // with defines placed after the version line.
+        std::string defines;
+        if (variant & PRESENT_PROGRAM_CHROMATIC) {
+            defines += "#define CHROMATIC\n";
+        }
+        if (variant & PRESENT_PROGRAM_TIME_WARP) {
+            defines += "#define TIME_WARP\n";
+        }
+        if (variant & PRESENT_PROGRAM_TEXTURE_ARRAY) {
+            defines += "#define TEXTURE_ARRAY\n";
+        }
+        MultiResolutionRemap remap;
+        if ((variant & PRESENT_PROGRAM_MULTI_RES) &&
+            GetMultiResolutionRemap(remap)) {
+            // The layout is fixed at construction, so it is compiled in.
+            std::ostringstream s;
+            s.precision(9);
+            s << "#define MULTI_RES\n";
+            const char* names[] = {"LOW", "HIGH", "SLOPE_LOW",
+                                   "SLOPE_CENTER", "SLOPE_HIGH"};
+            const float* values[] = {remap.low, remap.high, remap.slopeLow,
+                                     remap.slopeCenter, remap.slopeHigh};
+            for (size_t i = 0; i < 5; i++) {
+                s << "#define MULTI_RES_" << names[i] << " vec2("
+                  << values[i][0] << ", " << values[i][1] << ")\n";
+            }
+            defines += s.str();
+        }
+        const GLchar* vertexSources[] = {distortionShaderVersion,
+                                         defines.c_str(),
+                                         distortionVertexShader};
+        const GLchar* fragmentSources[] = {distortionShaderVersion,
+                                           defines.c_str(),
+                                           distortionFragmentShader};
+
+#ifndef RM_USE_OPENGLES20
+        // Use the binary from an earlier run if we have one for these
+        // sources on this driver.
+        std::string cacheKey;
+        bool useCache = !m_params.m_programBinaryCacheDirectory.empty() &&
+                        programBinariesSupported();
+        if (useCache) {
+            const GLchar* allSources[] = {
+                distortionShaderVersion, defines.c_str(),
+                distortionVertexShader, distortionFragmentShader};
+            cacheKey = programCacheKey(allSources, 4);
+            GLuint cached = loadCachedProgram(
+                m_params.m_programBinaryCacheDirectory, cacheKey);
+            if (cached != 0) {
+                return finishPresentProgram(variant, cached);
+            }
+        }
+#endif
+
+        GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertexShaderId, 3, vertexSources, nullptr);
+        glCompileShader(vertexShaderId);
+        if (!checkShaderError(vertexShaderId)) {
+            std::cerr << "RenderManagerOpenGL::buildPresentProgram: Could "
+                         "not construct vertex shader "
+                      << std::endl;
+            glDeleteShader(vertexShaderId);
+            return false;
+        }
+
+        GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragmentShaderId, 3, fragmentSources, nullptr);
+        glCompileShader(fragmentShaderId);
+        if (!checkShaderError(fragmentShaderId)) {
+            std::cerr << "RenderManagerOpenGL::buildPresentProgram: Could "
+                         "not construct fragment shader "
+                      << std::endl;
+            glDeleteShader(vertexShaderId);
+            glDeleteShader(fragmentShaderId);
+            return false;
+        }
+
+        GLuint programId = glCreateProgram();
+        glAttachShader(programId, vertexShaderId);
+        glAttachShader(programId, fragmentShaderId);
+#ifndef RM_USE_OPENGLES20
+        if (useCache) {
+            glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                GL_TRUE);
+        }
+#endif
+        glLinkProgram(programId);
+
+        // Now that they are linked, we don't need to keep them around.
+        glDeleteShader(vertexShaderId);
+        glDeleteShader(fragmentShaderId);
+        if (!checkProgramError(programId)) {
+            std::cerr << "RenderManagerOpenGL::buildPresentProgram: Could "
+                         "not link shader program "
+                      << std::endl;
+            glDeleteProgram(programId);
+            return false;
+        }
+#ifndef RM_USE_OPENGLES20
+        if (useCache) {
+            storeCachedProgram(m_params.m_programBinaryCacheDirectory,
+                               cacheKey, programId);
+        }
+#endif
+        return finishPresentProgram(variant, programId);
+    }
+
+    bool RenderManagerOpenGL::finishPresentProgram(unsigned variant,
+                                                   GLuint programId) {
+        // Uniform block bindings and locations are looked up for each
+        // program, however it was made.
+        PresentProgram& program = m_presentPrograms[variant];
+#ifdef RM_USE_OPENGLES20
+        program.positionMatrixId =
+            glGetUniformLocation(programId, "positionMatrix");
+        program.textureMatrixId =
+            glGetUniformLocation(programId, "textureMatrix");
+        program.textureScaleOffsetId =
+            glGetUniformLocation(programId, "textureScaleOffset");
+#else
+        glUniformBlockBinding(programId,
+                              glGetUniformBlockIndex(programId, "PresentEye"),
+                              PRESENT_UNIFORM_BINDING);
+#endif
+        program.id = programId;
         return true;
     }
 
     bool RenderManagerOpenGL::RenderFrameInitialize() {
-        return PresentFrameInitialize();
+        // Nothing to set up: the state we change when presenting is saved
+        // and restored around the present itself.
+        return true;
     }
 
     bool RenderManagerOpenGL::RenderFrameFinalize() {
@@ -703,6 +1892,27 @@ namespace renderkit {
         return true;
     }
 
+    bool RenderManagerOpenGL::PresentFrameInitialize() {
+        // Store the application's values for the state that we change
+        // while presenting, so that we can put it back once the whole frame
+        // has been presented.
+        glGetIntegerv(GL_CURRENT_PROGRAM, &m_savedGLState.program);
+        glGetBooleanv(GL_DEPTH_TEST, &m_savedGLState.depthTest);
+        glGetBooleanv(GL_CULL_FACE, &m_savedGLState.cullFace);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &m_savedGLState.vertexArray);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &m_savedGLState.activeTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &m_savedGLState.texture);
+#ifndef RM_USE_OPENGLES20
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY,
+                      &m_savedGLState.textureArray);
+        glGetIntegerv(GL_SAMPLER_BINDING, &m_savedGLState.sampler);
+#endif
+        m_savedGLState.saved = true;
+        m_presentDraws.clear();
+        return true;
+    }
+
     bool RenderManagerOpenGL::PresentDisplayInitialize(size_t display) {
         if (display >= GetNumDisplays()) {
             return false;
@@ -718,11 +1928,44 @@ namespace renderkit {
             return false;
         }
 
-        SDL_GL_SwapWindow(m_displays[display].m_window);
+        if (!drawPresentEyes()) {
+            return false;
+        }
+        auto swapStart = std::chrono::steady_clock::now();
+        SwapDisplay(display);
+        AddPresentBlockedTime(std::chrono::steady_clock::now() - swapStart);
         return true;
     }
 
+    void RenderManagerOpenGL::SwapDisplay(size_t display) {
+        SDL_GL_SwapWindow(m_displays[display].m_window);
+    }
+
     bool RenderManagerOpenGL::PresentFrameFinalize() {
+        // Put rendering state back the way the application had it.
+        if (m_savedGLState.saved) {
+            m_savedGLState.saved = false;
+            glUseProgram(m_savedGLState.program);
+            if (m_savedGLState.depthTest) {
+                glEnable(GL_DEPTH_TEST);
+            } else {
+                glDisable(GL_DEPTH_TEST);
+            }
+            if (m_savedGLState.cullFace) {
+                glEnable(GL_CULL_FACE);
+            } else {
+                glDisable(GL_CULL_FACE);
+            }
+            glBindVertexArray(m_savedGLState.vertexArray);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, m_savedGLState.texture);
+#ifndef RM_USE_OPENGLES20
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_savedGLState.textureArray);
+            glBindSampler(0, m_savedGLState.sampler);
+#endif
+            glActiveTexture(m_savedGLState.activeTexture);
+        }
+
         // Let SDL handle any system events that it needs to.
         SDL_Event e;
         while (SDL_PollEvent(&e)) {
@@ -744,214 +1987,272 @@ namespace renderkit {
             return false;
         }
 
-        // Construct the OpenGL viewport based on which eye this is.
-        OSVR_ViewportDescription viewportDesc;
-        if (!ConstructViewportForPresent(
-                params.m_index, viewportDesc,
-                m_params.m_displayConfiguration.getSwapEyes())) {
+        // Get the viewport, the projection that undoes the overfill, the
+        // display rotation/flip and the crop to this eye's part of the
+        // render buffer.  These only change with the configuration and
+        // the cropping viewport, so they are usually already computed.
+        const PresentEyeTransforms* transforms = GetPresentEyeTransforms(
+            params, m_params.m_displayConfiguration.getSwapEyes());
+        if (transforms == nullptr) {
             std::cerr << "RenderManagerOpenGL::PresentEye(): Could not "
-                         "construct viewport"
+                         "construct present transforms"
                       << std::endl;
             return false;
         }
-        // Adjust the viewport based on how much the display window is
-        // rotated with respect to the rendering window.
-        viewportDesc = RotateViewport(viewportDesc);
-        glViewport(static_cast<GLint>(viewportDesc.left),
-                   static_cast<GLint>(viewportDesc.lower),
-                   static_cast<GLsizei>(viewportDesc.width),
-                   static_cast<GLsizei>(viewportDesc.height));
-
-        // Figure out which display we're rendering to for this eye.
-        /// @todo This will need to be generalized when we have multiple
-        /// displays
-        /// per eye.
-        size_t display = GetDisplayUsedByEye(params.m_index);
-
-        /// Switch to our vertex/shader programs
-        /// Store the user program so we can put it back again before
-        /// returning.
-        GLint userProgram;
-        glGetIntegerv(GL_CURRENT_PROGRAM, &userProgram);
-        glUseProgram(m_programId);
-        if (checkForGLError(
-                "RenderManagerOpenGL::PresentEye after use program")) {
-            return false;
-        }
 
-        // Set up a Projection matrix that undoes the scale factor applied
-        // due to our rendering overfill factor.  This will put only the part
-        // of the geometry that should be visible inside the viewing frustum.
-        // @todo think about how we get square pixels, to properly handle
-        // distortion correction.
-        GLfloat myScale = m_params.m_renderOverfillFactor;
-        GLfloat scaleProj[16] = {myScale, 0, 0, 0, 0, myScale, 0, 0,
-                                 0,       0, 1, 0, 0, 0,       0, 1};
-        glUniformMatrix4fv(m_projectionUniformId, 1, GL_FALSE, scaleProj);
-        if (checkForGLError("RenderManagerOpenGL::PresentEye after projection "
-                            "matrix setting")) {
-            return false;
+        // Record the eye to be drawn once all of the eyes on this display
+        // have their matrices, and make room for its matrices.  The
+        // vectors keep their storage from frame to frame.
+        PresentEyeDraw draw;
+        draw.eye = params.m_index;
+        draw.texture = params.m_buffer.OpenGL->colorBufferName;
+        draw.layer = colorBufferLayer(params.m_buffer);
+        draw.viewport = transforms->viewport;
+        size_t slot = m_presentDraws.size();
+        if (m_presentUniformData.size() < (slot + 1) * m_presentUniformStride) {
+            m_presentUniformData.resize((slot + 1) * m_presentUniformStride);
         }
 
-        // Set up a ModelView matrix that handles rotating and flipping the
-        // geometry as needed to match the display scan-out circuitry and/or
-        // any changes needed by the inversion of window coordinates when
-        // switching between graphics systems (OpenGL and Direct3D, for
-        // example).
-        // @todo think about how we get square pixels, to properly handle
-        // distortion correction.
-        matrix16 modelView;
-        if (!ComputeDisplayOrientationMatrix(
-                static_cast<float>(params.m_rotateDegrees), params.m_flipInY,
-                modelView)) {
-            std::cerr << "RenderManagerOpenGL::PresentEye(): "
-                         "ComputeDisplayOrientationMatrix failed"
-                      << std::endl;
-            return false;
-        }
-        glUniformMatrix4fv(m_modelViewUniformId, 1, GL_FALSE, modelView.data);
-        if (checkForGLError("RenderManagerOpenGL::PresentEye after modelView "
-                            "matrix setting")) {
-            return false;
+#ifndef RM_USE_OPENGLES20
+        // With no distortion, no time warp, no multi-resolution packing and
+        // no rotation other than 180 degrees, presenting is a scaled copy
+        // of the part of the texture that is inside the overfill margins,
+        // possibly mirrored.  We blit that rather than drawing the mesh.
+        int rotate = static_cast<int>(params.m_rotateDegrees) % 360;
+        if (params.m_ATW == nullptr && (rotate == 0 || rotate == 180) &&
+            !m_multiResolution.enabled &&
+            params.m_index < m_distortionIsIdentity.size() &&
+            m_distortionIsIdentity[params.m_index]) {
+            const OSVR_ViewportDescription& crop =
+                params.m_normalizedCroppingViewport;
+            OverfillMargins margins = GetOverfillMargins(params.m_index);
+            double xSize = 1 + margins.left + margins.right;
+            double ySize = 1 + margins.bottom + margins.top;
+            draw.blit = true;
+            draw.source.left = crop.left + crop.width * margins.left / xSize;
+            draw.source.lower =
+                crop.lower + crop.height * margins.bottom / ySize;
+            draw.source.width = crop.width / xSize;
+            draw.source.height = crop.height / ySize;
+            // The display orientation flips in Y and then rotates, and a
+            // rotation by 180 degrees flips in both X and Y.
+            draw.flipX = (rotate == 180);
+            draw.flipY = (params.m_flipInY != (rotate == 180));
+            m_presentDraws.push_back(draw);
+            return true;
         }
+#endif
+        m_presentDraws.push_back(draw);
+        PresentEyeUniforms& uniforms = *reinterpret_cast<PresentEyeUniforms*>(
+            &m_presentUniformData[slot * m_presentUniformStride]);
+        // The shader applies projection and ModelView as one matrix.
+        Eigen::Map<Eigen::Matrix4f>(uniforms.positionMatrix) =
+            Eigen::Map<const Eigen::Matrix4f>(transforms->projection.data) *
+            Eigen::Map<const Eigen::Matrix4f>(transforms->modelView.data);
 
         //=========================================================
-        // Asynchronous Time Warp.
-        // Set up the texture matrix to handle asynchronous time warp
-
-        float textureMat[] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        // Asynchronous Time Warp is the only per-frame part of the texture
+        // matrix.  Because the matrix was built in compliance with the
+        // OpenGL spec, we can just directly use it.  Without time warp,
+        // the shader only needs the crop's scale and offset.
+        Eigen::Map<Eigen::Matrix4f> texture(uniforms.textureMatrix);
+        Eigen::Map<const Eigen::Matrix4f> crop(transforms->crop.data);
         if (params.m_ATW != nullptr) {
-            // Because the matrix was built in compliance with the OpenGL
-            // spec, we can just directly use it.
-            memcpy(textureMat, params.m_ATW->data, 15 * sizeof(float));
-        }
-
-        // We now crop to a subregion of the texture.  This is used to handle
-        // the
-        // case where more than one eye is drawn into the same render texture
-        // (for example, as happens in the Unreal game engine).  We base this on
-        // the normalized cropping viewport, which will go from 0 to 1 in both
-        // X and Y for the full display, but which will be cut in half in in one
-        // dimension for the case where two eyes are packed into the same
-        // buffer.
-        // We scale and translate the texture coordinates by multiplying the
-        // texture matrix to map the original range (0..1) to the proper
-        // location.
-        // We read in, multiply, and write out textureMat.
-        matrix16 crop;
-        ComputeRenderBufferCropMatrix(params.m_normalizedCroppingViewport,
-                                      crop);
-        Eigen::Map<Eigen::MatrixXf> textureEigen(textureMat, 4, 4);
-        Eigen::Map<Eigen::MatrixXf> cropEigen(crop.data, 4, 4);
-        Eigen::MatrixXf full(4, 4);
-        full = textureEigen * cropEigen;
-        memcpy(textureMat, full.data(), 16 * sizeof(float));
-
-        glUniformMatrix4fv(m_textureUniformId, 1, GL_FALSE, textureMat);
-        if (checkForGLError("RenderManagerOpenGL::PresentEye after texture "
-                            "matrix setting")) {
-            return false;
+            texture = Eigen::Map<const Eigen::Matrix4f>(params.m_ATW->data) *
+                      crop;
+        } else {
+            texture = crop;
         }
+        const OSVR_ViewportDescription& cropViewport =
+            params.m_normalizedCroppingViewport;
+        uniforms.textureScaleOffset[0] = static_cast<GLfloat>(cropViewport.width);
+        uniforms.textureScaleOffset[1] =
+            static_cast<GLfloat>(cropViewport.height);
+        uniforms.textureScaleOffset[2] = static_cast<GLfloat>(cropViewport.left);
+        uniforms.textureScaleOffset[3] =
+            static_cast<GLfloat>(cropViewport.lower);
+        uniforms.textureLayer = static_cast<GLfloat>(draw.layer);
 
-        // Render the geometry to fill the viewport, with the texture
-        // mapped onto it.
-
-        // NOTE: No need to clear the buffer in color or depth; we're
-        // always overwriting the whole thing.  We do need to store the
-        // value of the depth-test bit and restore it, turning it off for
-        // our use here.
-        // Store the initial values of rendering state that we set, so we
-        // can restore it below.
-        // Disable depth testing.
-        // Enable 2D texturing.
-        // Disable face culling (in case client switched
-        // front-face).
-
-        GLboolean depthTest, texture2D, cullFace;
-        glGetBooleanv(GL_DEPTH_TEST, &depthTest);
-        glGetBooleanv(GL_TEXTURE_2D, &texture2D);
-        glGetBooleanv(GL_CULL_FACE, &cullFace);
-        glDisable(GL_DEPTH_TEST);
-        glEnable(GL_TEXTURE_2D);
-        glDisable(GL_CULL_FACE);
+        return true;
+    }
 
-        if (checkForGLError(
-                "RenderManagerOpenGL::PresentEye after environment setting")) {
-            return false;
+    GLint
+    RenderManagerOpenGL::colorBufferLayer(const RenderBuffer& buffer) const {
+        if (m_colorBufferArray == 0) {
+            return -1;
         }
+        for (size_t i = 0; i < m_colorBuffers.size(); i++) {
+            if (m_colorBuffers[i].OpenGL == buffer.OpenGL) {
+                return static_cast<GLint>(i);
+            }
+        }
+        return -1;
+    }
 
+    bool RenderManagerOpenGL::drawPresentEyes() {
         // Render to the 0th frame buffer, which is the screen.
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
 
-        // @todo save and later restore the state telling which texture is bound
-        // and which vertex attributes are set
+        // Render the geometry to fill each viewport, with the eye's texture
+        // mapped onto it, unless it can just be copied.  The shader state is
+        // only set up if some eye needs it.
+        bool shaderReady = false;
+        unsigned currentVariant = m_presentProgram;
+        for (size_t i = 0; i < m_presentDraws.size(); i++) {
+            const PresentEyeDraw& draw = m_presentDraws[i];
+            if (draw.blit) {
+                if (!blitPresentEye(draw)) {
+                    m_presentDraws.clear();
+                    return false;
+                }
+                continue;
+            }
 
-        // Bind our texture in Texture Unit 0
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, params.m_buffer.OpenGL->colorBufferName);
+            if (!shaderReady) {
+                shaderReady = true;
+                // Switch to our vertex/shader programs.
+                // NOTE: No need to clear the buffer in color or depth; we're
+                // always overwriting the whole thing.  We turn off depth
+                // testing and face culling (in case client switched
+                // front-face); the application's values are put back in
+                // PresentFrameFinalize().
+                currentVariant = m_presentProgram;
+                glUseProgram(m_presentPrograms[currentVariant].id);
+                glDisable(GL_DEPTH_TEST);
+                glDisable(GL_CULL_FACE);
+#ifndef RM_USE_OPENGLES20
+                // Send the matrices for all of the eyes in one update,
+                // orphaning the previous contents so we don't wait for
+                // draws still reading them.
+                glBindSampler(0, m_presentSampler);
+                glBindBuffer(GL_UNIFORM_BUFFER, m_presentUBO);
+                glBufferData(GL_UNIFORM_BUFFER,
+                             m_presentDraws.size() * m_presentUniformStride,
+                             m_presentUniformData.data(), GL_STREAM_DRAW);
+#endif
+                if (checkForGLError("RenderManagerOpenGL::drawPresentEyes "
+                                    "after state setting")) {
+                    m_presentDraws.clear();
+                    return false;
+                }
+            }
 
-        if (checkForGLError(
-                "RenderManagerOpenGL::PresentEye after texture bind")) {
-            return false;
+            // Eyes in a texture array are sampled by a program that knows
+            // to look there.
+            unsigned variant =
+                m_presentProgram |
+                (draw.layer >= 0 ? PRESENT_PROGRAM_TEXTURE_ARRAY : 0);
+            if (variant != currentVariant) {
+                currentVariant = variant;
+                glUseProgram(m_presentPrograms[currentVariant].id);
+            }
+
+            glViewport(static_cast<GLint>(draw.viewport.left),
+                       static_cast<GLint>(draw.viewport.lower),
+                       static_cast<GLsizei>(draw.viewport.width),
+                       static_cast<GLsizei>(draw.viewport.height));
+#ifdef RM_USE_OPENGLES20
+            const PresentEyeUniforms& uniforms =
+                *reinterpret_cast<const PresentEyeUniforms*>(
+                    &m_presentUniformData[i * m_presentUniformStride]);
+            const PresentProgram& program = m_presentPrograms[currentVariant];
+            glUniformMatrix4fv(program.positionMatrixId, 1, GL_FALSE,
+                               uniforms.positionMatrix);
+            glUniformMatrix4fv(program.textureMatrixId, 1, GL_FALSE,
+                               uniforms.textureMatrix);
+            glUniform4fv(program.textureScaleOffsetId, 1,
+                         uniforms.textureScaleOffset);
+            glBindTexture(GL_TEXTURE_2D, draw.texture);
+#else
+            glBindBufferRange(GL_UNIFORM_BUFFER, PRESENT_UNIFORM_BINDING,
+                              m_presentUBO, i * m_presentUniformStride,
+                              sizeof(PresentEyeUniforms));
+            if (draw.layer >= 0) {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, draw.texture);
+            } else {
+                glBindTexture(GL_TEXTURE_2D, draw.texture);
+            }
+#endif
+#ifdef RM_USE_OPENGLES20
+            // Bilinear filtering and clamp to the edge of the texture.  Set
+            // this after we've bound our texture.
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+#endif
+            glBindVertexArray(m_distortVAO[draw.eye]);
+            glDrawArrays(GL_TRIANGLES, 0,
+                         static_cast<GLuint>(m_numTriangles[draw.eye] * 3));
         }
+        m_presentDraws.clear();
 
-        // Bilinear filtering and clamp to the edge of the texture.  Set this
-        // after we've bound our texture.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-        char* base = nullptr;
-        size_t vertBase = 0;
-        size_t redBase =
-            vertBase + m_numTriangles[params.m_index] * 3 * 4 * sizeof(GLfloat);
-        size_t greenBase =
-            redBase + m_numTriangles[params.m_index] * 3 * 2 * sizeof(GLfloat);
-        size_t blueBase =
-            greenBase +
-            m_numTriangles[params.m_index] * 3 * 2 * sizeof(GLfloat);
-        glBindVertexArray(m_distortVAO[params.m_index]);
-        glBindBuffer(GL_ARRAY_BUFFER, m_distortBuffer[params.m_index]);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, base + vertBase);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, base + redBase);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, base + greenBase);
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, base + blueBase);
-        glEnableVertexAttribArray(3);
-        glDrawArrays(GL_TRIANGLES, 0,
-                     static_cast<GLuint>(m_numTriangles[params.m_index] * 3));
-
-        // Put rendering parameters back the way they were before we set them
-        // above.
-        if (depthTest) {
-          glEnable(GL_DEPTH_TEST);
-        } else {
-          glDisable(GL_DEPTH_TEST);
+        if (checkForGLError("RenderManagerOpenGL::drawPresentEyes end")) {
+            return false;
         }
+        return true;
+    }
 
-        if (texture2D) {
-          glEnable(GL_TEXTURE_2D);
+    bool RenderManagerOpenGL::blitPresentEye(const PresentEyeDraw& draw) {
+#ifdef RM_USE_OPENGLES20
+        std::cerr << "RenderManagerOpenGL::blitPresentEye: Not available "
+                     "in OpenGL ES 2.0"
+                  << std::endl;
+        return false;
+#else
+        // Framebuffer objects are not shared between contexts, so we make
+        // the one we read through in whichever context presents.
+        if (m_presentReadFramebuffer == 0) {
+            glGenFramebuffers(1, &m_presentReadFramebuffer);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_presentReadFramebuffer);
+        GLenum target = GL_TEXTURE_2D;
+        if (draw.layer >= 0) {
+            target = GL_TEXTURE_2D_ARRAY;
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                      draw.texture, 0, draw.layer);
         } else {
-          glDisable(GL_TEXTURE_2D);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_2D, draw.texture, 0);
         }
 
-        if (cullFace) {
-          glEnable(GL_CULL_FACE);
-        } else {
-          glDisable(GL_CULL_FACE);
+        // The application owns the texture, so we ask how big it is.
+        GLint texWidth = 0, texHeight = 0;
+        glBindTexture(target, draw.texture);
+        glGetTexLevelParameteriv(target, 0, GL_TEXTURE_WIDTH, &texWidth);
+        glGetTexLevelParameteriv(target, 0, GL_TEXTURE_HEIGHT, &texHeight);
+
+        GLint srcX0 = static_cast<GLint>(draw.source.left * texWidth);
+        GLint srcY0 = static_cast<GLint>(draw.source.lower * texHeight);
+        GLint srcX1 = static_cast<GLint>(
+            (draw.source.left + draw.source.width) * texWidth);
+        GLint srcY1 = static_cast<GLint>(
+            (draw.source.lower + draw.source.height) * texHeight);
+        GLint dstX0 = static_cast<GLint>(draw.viewport.left);
+        GLint dstY0 = static_cast<GLint>(draw.viewport.lower);
+        GLint dstX1 = static_cast<GLint>(draw.viewport.left +
+                                         draw.viewport.width);
+        GLint dstY1 = static_cast<GLint>(draw.viewport.lower +
+                                         draw.viewport.height);
+        // Reversing the destination bounds mirrors the copy.
+        if (draw.flipX) {
+            std::swap(dstX0, dstX1);
+        }
+        if (draw.flipY) {
+            std::swap(dstY0, dstY1);
         }
+        glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1,
+                          dstY1, GL_COLOR_BUFFER_BIT, GL_LINEAR);
 
-        if (checkForGLError("RenderManagerOpenGL::PresentEye end")) {
+        // Don't hold on to the application's texture once we're done.
+        glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        if (checkForGLError("RenderManagerOpenGL::blitPresentEye")) {
             return false;
         }
-
-        // Put back the user's vertex/shader program.
-        glUseProgram(userProgram);
-
         return true;
+#endif
     }
 
 } // namespace renderkit
@@ -53,6 +53,12 @@ Sensics, Inc.
 
 #include <vector>
 #include <string>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <atomic>
 
 namespace osvr {
 namespace renderkit {
@@ -67,6 +73,13 @@ namespace renderkit {
         // Opens the D3D renderer we're going to use.
         OpenResults OpenDisplay() override;
 
+        /// Print a message from the OpenGL debug output, limited to
+        /// GL_DEBUG_LOG_MAX_PER_SECOND messages per second.  Called by the
+        /// debug callback installed by installGLDebugCallback(), possibly
+        /// from a driver thread.
+        void reportGLDebugMessage(GLenum source, GLenum type, GLuint id,
+                                  GLenum severity, const GLchar* message);
+
       protected:
         /// Construct an OpenGL render manager.
         RenderManagerOpenGL(
@@ -80,7 +93,8 @@ namespace renderkit {
                 distort //< Distortion parameters
             ) override;
 
-        bool m_doingOkay;   //< Are we doing okay?
+        /// Are we doing okay?  Cleared by the ATW renderer's thread.
+        std::atomic<bool> m_doingOkay;
         bool m_displayOpen; //< Has our display been opened?
 
         // Methods to open and close a window, used to get
@@ -99,6 +113,7 @@ namespace renderkit {
             int bitsPerPixel;        //< How many bits per pixel?
             unsigned numBuffers;     //< How many buffers (2 = double buffering)
             bool visible;            //< Should the window be initially visible?
+            bool debug;              //< Ask for a debug context?
             GLContextParams() {
                 windowTitle = "OSVR";
                 displayIndex = -1;
@@ -110,6 +125,7 @@ namespace renderkit {
                 bitsPerPixel = 8;
                 numBuffers = 2;
                 visible = true;
+                debug = false;
             }
         };
         bool addOpenGLContext(GLContextParams p);
@@ -123,6 +139,31 @@ namespace renderkit {
         /// them from being in the same window and so bleeding together.
         bool constructRenderBuffers();
 
+        /// Install a callback on the current context that reports OpenGL
+        /// errors asynchronously using KHR_debug (or ARB_debug_output),
+        /// unless synchronous checks were requested in the constructor
+        /// parameters.  Once installed, checkForGLError() does nothing.
+        /// @return True if the callback was installed.
+        bool installGLDebugCallback();
+
+        /// Remove the debug callback from the current context, so that it
+        /// is not called after we are destroyed.
+        void removeGLDebugCallback();
+
+        static const unsigned GL_DEBUG_LOG_MAX_PER_SECOND = 10;
+
+        /// Errors are being reported by the debug callback, so
+        /// checkForGLError() need not call glGetError().
+        bool m_glErrorsAsynchronous = false;
+
+        /// Rate limiting for reportGLDebugMessage().
+        struct {
+            std::mutex lock;
+            std::chrono::steady_clock::time_point windowStart;
+            unsigned reported = 0;   //< Messages printed in this window
+            unsigned suppressed = 0; //< Messages dropped in this window
+        } m_glDebugLog;
+
         // Classes and structures needed to do our rendering.
         bool m_sdl_initialized = false;
         class DisplayInfo {
@@ -136,20 +177,210 @@ namespace renderkit {
 
         // Special vertex/fragment shader information for our shader that
         // handles
-        // asynchronous time warp and/or distortion.
-        GLuint m_programId;           //< Groups the shaders for ATW/distortion
-        GLuint m_projectionUniformId; //< Pointer to projection matrix, vertex
-                                      /// shader
-        GLuint
-            m_modelViewUniformId; //< Pointer to modelView matrix, vertex shader
-        GLuint m_textureUniformId; //< Pointer to texture matrix, vertex shader
+        // asynchronous time warp and/or distortion.  Variants of it are
+        // built when the distortion meshes are, as they are needed.
+        enum {
+            PRESENT_PROGRAM_CHROMATIC = 1, //< Separate R, G, B lookups
+            PRESENT_PROGRAM_TIME_WARP = 2, //< Full texture matrix
+            PRESENT_PROGRAM_TEXTURE_ARRAY = 4, //< Eye is an array layer
+            PRESENT_PROGRAM_MULTI_RES = 8, //< Eye is multi-resolution packed
+            PRESENT_PROGRAM_VARIANTS = 16
+        };
+        struct PresentProgram {
+            GLuint id = 0; //< Groups the shaders for ATW/distortion
+            // Uniform locations, only used with OpenGL ES 2.0
+            GLint positionMatrixId = -1;
+            GLint textureMatrixId = -1;
+            GLint textureScaleOffsetId = -1;
+        };
+        PresentProgram m_presentPrograms[PRESENT_PROGRAM_VARIANTS];
+        unsigned m_presentProgram = 0; //< Variant used for 2D textures
+
+        /// Build, if we haven't already, and select the program variant
+        /// for meshes that do (or don't) distort red, green and blue
+        /// differently, for whether time warp is enabled and for whether
+        /// the eyes are rendered at multiple resolutions, along with
+        /// its texture-array counterpart if the eyes are array layers.
+        bool selectPresentProgram(bool chromatic);
+
+        /// Build the program for a variant if we haven't already.
+        bool buildPresentProgram(unsigned variant);
+
+        /// Record a newly linked or loaded program for a variant.
+        bool finishPresentProgram(unsigned variant, GLuint programId);
         GLuint m_frameBuffer;      //< Groups a color buffer and a depth buffer
 
+        // State for presenting the eyes.  PresentEye() only computes each
+        // eye's matrices and records what to draw; PresentDisplayFinalize()
+        // sends all of the eyes' matrices to the card in one uniform-buffer
+        // update and then draws them.  Everything other than the matrices
+        // and the texture is set up once, when the program and meshes are
+        // built.
+
+        /// Uniform binding point used for the PresentEye uniform block.
+        static const GLuint PRESENT_UNIFORM_BINDING = 0;
+
+        /// Per-eye matrices, laid out to match the std140 PresentEye
+        /// uniform block in the vertex shader.
+        struct PresentEyeUniforms {
+            GLfloat positionMatrix[16];   //< Projection times ModelView
+            GLfloat textureMatrix[16];    //< Time warp times crop
+            GLfloat textureScaleOffset[4]; //< Crop scale (xy), offset (zw)
+            GLfloat textureLayer;          //< Layer, for texture arrays
+            GLfloat padding[3]; //< std140 rounds the block up to a vec4
+        };
+
+        /// An eye recorded by PresentEye() to be drawn by
+        /// PresentDisplayFinalize().
+        struct PresentEyeDraw {
+            size_t eye;
+            GLuint texture;
+            GLint layer = -1; //< Layer of an array texture, -1 if 2D
+            OSVR_ViewportDescription viewport;
+
+            /// When there is nothing to distort or warp, the eye is copied
+            /// with glBlitFramebuffer() rather than drawn with our shader.
+            bool blit = false;
+            OSVR_ViewportDescription source; //< Normalized texture region
+            bool flipX = false;
+            bool flipY = false;
+        };
+
+        GLuint m_presentUBO = 0;     //< Holds the matrices for all eyes
+        GLuint m_presentReadFramebuffer =
+            0; //< Blit source; made in, and freed with, the present context
+        std::vector<bool>
+            m_distortionIsIdentity; //< Per eye, from the last mesh update
+        GLuint m_presentSampler = 0; //< Bilinear, clamp-to-edge sampling
+        size_t m_presentUniformStride =
+            sizeof(PresentEyeUniforms); //< Aligned offset between eyes
+        std::vector<GLubyte>
+            m_presentUniformData; //< Matrices for the recorded eyes
+        std::vector<PresentEyeDraw>
+            m_presentDraws; //< Eyes recorded for the current display
+
+        /// Application state that we change while presenting, saved by
+        /// PresentFrameInitialize() and put back by PresentFrameFinalize().
+        struct {
+            bool saved = false;
+            GLint program;
+            GLboolean depthTest;
+            GLboolean cullFace;
+            GLint vertexArray;
+            GLint activeTexture;
+            GLint texture;
+            GLint textureArray;
+            GLint sampler;
+        } m_savedGLState;
+
+        /// Draw the eyes recorded by PresentEye() into the current display.
+        bool drawPresentEyes();
+
+        /// Copy an eye recorded by PresentEye() for blitting into the
+        /// current display.
+        bool blitPresentEye(const PresentEyeDraw& draw);
+
         std::vector<RenderBuffer>
             m_colorBuffers; //< Color buffers to hand to render callbacks
         std::vector<GLuint> m_depthBuffers; //< Depth/stencil buffers to hand to
                                             /// render callbacks
 
+        /// When ConstructorParameters::m_renderTargetTextureArray is set,
+        /// every entry in m_colorBuffers names this texture array, with
+        /// eye i in layer i, and each eye renders through its own entry
+        /// in m_eyeFramebuffers, which are built and checked once.  The
+        /// eyes then have their own layers of m_depthBufferArray rather
+        /// than sharing a depth buffer, so that m_stereoFramebuffer can
+        /// attach all of them for single-pass stereo.
+        GLuint m_colorBufferArray = 0;
+        GLuint m_depthBufferArray = 0;
+        std::vector<GLuint> m_eyeFramebuffers;
+        GLuint m_stereoFramebuffer = 0; //< Layered; 0 if not available
+
+        /// The layer of m_colorBufferArray that holds a buffer, or -1 if
+        /// it is not one of ours in the array.
+        GLint colorBufferLayer(const RenderBuffer& buffer) const;
+
+        /// With ConstructorParameters::m_parallelEyeRendering, these are
+        /// the depth buffers of the eyes, which can't share one when they
+        /// are rendered at the same time.  Otherwise empty.
+        std::vector<GLuint> m_eyeDepthBuffers;
+
+#ifndef RM_USE_OPENGLES20
+        /// A thread that renders one eye in Render() with its own context,
+        /// which shares objects with m_GLContext.  Framebuffers are not
+        /// shared, so the worker builds the one it renders the eye into.
+        struct EyeWorker {
+            std::thread thread;
+            SDL_Window* window = nullptr; //< Window of the eye's display
+            SDL_GLContext context = nullptr;
+            GLuint framebuffer = 0; //< Only valid in the worker's context
+
+            // Guarded by m_eyeWorkerLock.
+            bool started = false; //< Set once the framebuffer is built
+            bool pending = false; //< An eye has been handed to the worker
+            bool ok = false;      //< Result of startup or the last eye
+            GLsync fence = nullptr; //< Signals when the eye is rendered
+        };
+        std::vector<std::unique_ptr<EyeWorker> > m_eyeWorkers;
+        std::mutex m_eyeWorkerLock;
+        std::condition_variable m_eyeWorkerCondition;
+        bool m_eyeWorkersQuit = false; //< Guarded by m_eyeWorkerLock
+
+        /// What the workers are to render, set before they are woken.
+        const RenderParams* m_eyeWorkerParams = nullptr;
+        bool m_eyeWorkerStereoPerEye = false;
+
+        void eyeWorkerFunc(size_t eye, EyeWorker* worker);
+#endif
+
+        /// Start one worker per eye if parallel eye rendering was asked
+        /// for.  Call with m_GLContext current, after the render buffers
+        /// have been constructed.
+        bool startEyeWorkers();
+
+        /// Stop and join the workers and free their contexts.
+        void stopEyeWorkers();
+
+        /// Render() draws the eyes one after another, so rather than each
+        /// having its own depth buffer, every entry in m_depthBuffers names
+        /// this one, which is sized to the largest eye.  It is kept when
+        /// the render buffers are rebuilt, and only reallocated when a
+        /// larger one is needed.
+        struct {
+            GLuint name = 0;
+            GLsizei width = 0;
+            GLsizei height = 0;
+            GLenum format = GL_DEPTH_COMPONENT;
+        } m_sharedDepthBuffer;
+
+        /// Bytes of depth buffer that sharing avoided allocating.
+        size_t m_depthBytesSaved = 0;
+
+        /// Storage for the eye color buffers and the shared depth buffer,
+        /// filled in by chooseRenderTargetFormats().
+        struct {
+            GLint colorInternalFormat = GL_RGB;
+            GLenum colorFormat = GL_RGB;
+            GLenum colorType = GL_UNSIGNED_BYTE;
+            GLenum depthInternalFormat = GL_DEPTH_COMPONENT;
+            size_t depthBytesPerPixel = 4; //< Estimated for unsized formats
+        } m_renderTargetFormats;
+
+        /// Translate the requested render-target formats into OpenGL ones,
+        /// falling back to the defaults for any that the context cannot
+        /// render to.  Requires m_frameBuffer to be bound.
+        void chooseRenderTargetFormats();
+
+        /// Return the shared depth buffer, grown if needed to be at least
+        /// the given size.
+        GLuint acquireSharedDepthBuffer(GLsizei width, GLsizei height);
+
+        /// Delete the distortion mesh buffers and vertex array objects.
+        /// Vertex array objects belong to the context that made them, so
+        /// this must be called with that context current.
+        void deleteDistortionMeshes();
+
         // Vertex/texture coordinate buffer to render into final windows, one
         // per eye
         // @todo One per eye/display combination in case of multiple displays
@@ -168,6 +399,10 @@ namespace renderkit {
         bool RenderFrameInitialize() override;
         bool RenderDisplayInitialize(size_t display) override;
         bool RenderEyeInitialize(size_t eye) override;
+        /// Clears depth to the near plane in the hidden area with scissored
+        /// clears, which need no program or vertex arrays and so work in
+        /// the per-eye worker contexts as well.
+        bool RenderEyeHiddenArea(size_t eye) override;
         bool RenderSpace(size_t whichSpace //< Index into m_callbacks vector
                          ,
                          size_t whichEye //< Which eye are we rendering for?
@@ -182,16 +417,38 @@ namespace renderkit {
         bool RenderDisplayFinalize(size_t display) override { return true; }
         bool RenderFrameFinalize() override;
 
-        bool PresentFrameInitialize() override { return true; }
+        /// Stereo callbacks render into a layered framebuffer, which is
+        /// only available when the eyes are layers of a texture array.
+        bool CanRenderStereo() override { return m_stereoFramebuffer != 0; }
+        bool RenderStereoInitialize() override;
+
+        /// Hands the eyes to their worker threads when there are any.
+        bool RenderDisplayEyes(size_t display, const RenderParams& params,
+                               bool stereoPerEye) override;
+
+        bool PresentFrameInitialize() override;
         bool PresentDisplayInitialize(size_t display) override;
         bool PresentEye(PresentEyeParameters params) override;
         bool PresentDisplayFinalize(size_t display) override;
         bool PresentFrameFinalize() override;
 
-        /// See if we had an OpenGL error
+        /// Swap the display's window, which can block until vertical sync.
+        /// PresentDisplayFinalize() reports the time spent here to
+        /// AddPresentBlockedTime().
+        virtual void SwapDisplay(size_t display);
+
+        /// See if we had an OpenGL error.  This calls glGetError(), which
+        /// can stall the pipeline, so it does nothing when errors are being
+        /// reported asynchronously by the debug callback.
         /// @return True if there is an error, false if not.
         /// @param [in] message Message to print if there is an error
-        static bool checkForGLError(const std::string& message);
+        bool checkForGLError(const char* message);
+
+        /// Like checkForGLError(), but always calls glGetError(), so that
+        /// errors are reported against the call that caused them.  For
+        /// set-up code that is not run every frame or that waits for the
+        /// driver anyway.
+        bool checkForSetupGLError(const char* message);
 
         friend RenderManager OSVR_RENDERMANAGER_EXPORT*
         createRenderManager(OSVR_ClientContext context,
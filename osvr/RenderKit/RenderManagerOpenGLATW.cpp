@@ -0,0 +1,385 @@
+/** @file
+@brief Source file implementing an asynchronous time warp renderer for the
+OpenGL rendering interface
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <RenderManagerBackends.h>
+#include <GL/glew.h>
+#ifdef _WIN32
+  #include <GL/wglew.h>
+#endif
+#include "RenderManagerOpenGLATW.h"
+#include "GraphicsLibraryOpenGL.h"
+#include <iostream>
+
+/// Convert a std::chrono duration into an OSVR time value.
+template <typename Duration>
+static OSVR_TimeValue durationToTimeValue(Duration d) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    OSVR_TimeValue ret;
+    ret.seconds = static_cast<OSVR_TimeValue_Seconds>(us / 1000000);
+    ret.microseconds = static_cast<OSVR_TimeValue_Microseconds>(us % 1000000);
+    return ret;
+}
+
+namespace osvr {
+namespace renderkit {
+
+    RenderManagerOpenGLATW::RenderManagerOpenGLATW(
+        std::shared_ptr<osvr::clientkit::ClientContext> context,
+        ConstructorParameters p)
+        : RenderManagerOpenGL(context, p) {
+        ATWScheduler::Hooks hooks;
+        hooks.getTimingInfo = [this](RenderTimingInfo& info) {
+            return GetTimingInfo(0, info);
+        };
+        hooks.getThresholdMS = [this]() { return GetTimeWarpThresholdMS(); };
+        hooks.present = [this](const ATWScheduler::Frame& frame) {
+            return presentFrame(frame) ? ATWScheduler::PRESENT_DONE
+                                       : ATWScheduler::PRESENT_FAILED;
+        };
+        hooks.afterPresent = [this]() { waitForRetrace(); };
+        hooks.presentLock = &m_mutex;
+        m_scheduler.reset(new ATWScheduler(hooks));
+    }
+
+    RenderManagerOpenGLATW::~RenderManagerOpenGLATW() {
+        if (m_thread) {
+            stop();
+            m_thread->join();
+        }
+        if (m_renderedFence) {
+            glDeleteSync(m_renderedFence);
+        }
+        if (m_presentedFence) {
+            glDeleteSync(m_presentedFence);
+        }
+        if (m_ATWContext) {
+            SDL_GL_DeleteContext(m_ATWContext);
+            m_ATWContext = nullptr;
+        }
+    }
+
+    RenderManager::OpenResults RenderManagerOpenGLATW::OpenDisplay() {
+        // Open the display as usual, which leaves the application's context
+        // current on this thread.
+        OpenResults ret = RenderManagerOpenGL::OpenDisplay();
+        if (ret.status == FAILURE) {
+            return ret;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        //======================================================
+        // Construct the context to be used by the ATW thread.  It shares
+        // textures, buffers, programs, and sync objects with the
+        // application's context.  Creating it makes it current, so we set
+        // its swap interval while it is and then put the application's
+        // context back.
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+        m_ATWContext = SDL_GL_CreateContext(m_displays[0].m_window);
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+        if (m_ATWContext == nullptr) {
+            std::cerr << "RenderManagerOpenGLATW::OpenDisplay: Could not get "
+                         "OpenGL context for ATW thread: "
+                      << SDL_GetError() << std::endl;
+            m_doingOkay = false;
+            ret.status = FAILURE;
+            return ret;
+        }
+        if (SDL_GL_SetSwapInterval(m_params.m_verticalSync ? 1 : 0) != 0) {
+            std::cerr << "RenderManagerOpenGLATW::OpenDisplay: Warning: Could "
+                         "not set vertical retrace for ATW context"
+                      << std::endl;
+        }
+        // Debug output is per-context, so we need the callback here too
+        // before we can skip the synchronous error checks.
+        if (m_glErrorsAsynchronous && !installGLDebugCallback()) {
+            m_glErrorsAsynchronous = false;
+        }
+        checkForSetupGLError("RenderManagerOpenGLATW::OpenDisplay");
+        SDL_GL_MakeCurrent(m_displays[0].m_window, m_GLContext);
+
+        //======================================================
+        // Start our ATW sub-thread.  It will construct the distortion
+        // meshes requested during the base-class OpenDisplay() in its own
+        // context.
+        start();
+
+        return ret;
+    }
+
+    bool RenderManagerOpenGLATW::GetTimingInfo(size_t whichEye,
+                                               RenderTimingInfo& info) {
+        std::lock_guard<std::mutex> lock(m_ATWLock);
+        if (m_refreshInterval == Clock::duration::zero()) {
+            return false;
+        }
+
+        // If we've not presented for more than a refresh, fold the time
+        // since our last measured retrace into the current refresh.
+        Clock::duration since = Clock::now() - m_lastRetrace;
+        since = since % m_refreshInterval;
+
+        Clock::duration threshold =
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<float, std::milli>(
+                    GetTimeWarpThresholdMS()));
+        Clock::duration until = m_refreshInterval - since - threshold;
+        if (until < Clock::duration::zero()) {
+            until = Clock::duration::zero();
+        }
+
+        info.hardwareDisplayInterval = durationToTimeValue(m_refreshInterval);
+        info.timeSincelastVerticalRetrace = durationToTimeValue(since);
+        info.timeUntilNextPresentRequired = durationToTimeValue(until);
+        return true;
+    }
+
+    bool RenderManagerOpenGLATW::PresentRenderBuffersInternal(
+        const std::vector<RenderBuffer>& buffers,
+        const std::vector<RenderInfo>& renderInfoUsed,
+        const RenderParams& renderParams,
+        const std::vector<OSVR_ViewportDescription>&
+            normalizedCroppingViewports,
+        bool flipInY) {
+        if (!doingOkay()) {
+            std::cerr << "RenderManagerOpenGLATW::PresentRenderBuffers(): "
+                         "Display not opened or ATW thread failed."
+                      << std::endl;
+            return false;
+        }
+        if (!m_renderBuffersRegistered) {
+            std::cerr << "RenderManagerOpenGLATW::PresentRenderBuffers(): "
+                         "Buffers not registered."
+                      << std::endl;
+            return false;
+        }
+        if (buffers.size() < GetNumEyes()) {
+            std::cerr << "RenderManagerOpenGLATW::PresentRenderBuffers(): "
+                         "Given "
+                      << GetNumEyes() << " eyes, but only " << buffers.size()
+                      << " buffers" << std::endl;
+            return false;
+        }
+
+        // The buffers we handed to the ATW thread last time are given back
+        // to the application now.  Make sure that the application's
+        // context does not write into them until the ATW thread's last
+        // present from them has finished.
+        if (m_presentedFence) {
+            glWaitSync(m_presentedFence, 0, GL_TIMEOUT_IGNORED);
+        }
+
+        // Mark the point after which the application's rendering into the
+        // new buffers is complete, and make sure it is submitted so that
+        // the ATW context's wait on it can complete.  If the ATW thread
+        // never got to the previous frame, we drop its fence.
+        if (m_renderedFence) {
+            glDeleteSync(m_renderedFence);
+        }
+        m_renderedFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        // Hand the frame to the scheduler.  We hold m_mutex, which it
+        // locks while presenting, so the previous frame will not be
+        // presented again after this.  Copying into its recycled frame
+        // reuses the storage from an earlier one.
+        ATWScheduler::Frame& frame = m_scheduler->nextFrame();
+        frame.renderBuffers = buffers;
+        frame.renderInfo = renderInfoUsed;
+        frame.renderParams = renderParams;
+        frame.normalizedCroppingViewports = normalizedCroppingViewports;
+        frame.flipInY = flipInY;
+        m_scheduler->submit();
+
+        // Let SDL handle the system events on the application's thread.
+        return RenderManagerOpenGL::PresentFrameFinalize();
+    }
+
+    bool RenderManagerOpenGLATW::UpdateDistortionMeshesInternal(
+        DistortionMeshType type,
+        std::vector<DistortionParameters> const& distort) {
+        if (GetNumEyes() > distort.size()) {
+            std::cerr << "RenderManagerOpenGLATW::UpdateDistortionMesh: Not "
+                         "enough distortion "
+                      << "parameters for all eyes" << std::endl;
+            return false;
+        }
+        m_meshType = type;
+        m_meshDistortion = distort;
+        m_meshUpdatePending = true;
+
+        // Keep any meshes that UpdateDistortionMeshes() computed for us, so
+        // that the ATW thread only has to build the buffers.
+        m_meshPrecomputed.clear();
+        if ((m_precomputedMeshes.distort == &distort) &&
+            (m_precomputedMeshes.type == type)) {
+            m_meshPrecomputed.swap(m_precomputedMeshes.meshes);
+        }
+        return true;
+    }
+
+    bool RenderManagerOpenGLATW::RenderFrameInitialize() {
+        std::cerr << "RenderManagerOpenGLATW::Render: Not supported with "
+                     "asynchronous time warp; render into two sets of "
+                     "registered buffers and alternate between them in "
+                     "PresentRenderBuffers()"
+                  << std::endl;
+        return false;
+    }
+
+    bool RenderManagerOpenGLATW::PresentDisplayInitialize(size_t display) {
+        if (display >= GetNumDisplays()) {
+            return false;
+        }
+
+        // Make the ATW thread's OpenGL context current
+        SDL_GL_MakeCurrent(m_displays[display].m_window, m_ATWContext);
+        return true;
+    }
+
+    void RenderManagerOpenGLATW::start() {
+        std::lock_guard<std::mutex> lock(m_ATWLock);
+        if (m_started) {
+            std::cerr << "RenderManagerOpenGLATW::start() - thread loop "
+                         "already started."
+                      << std::endl;
+            return;
+        }
+        m_started = true;
+        m_thread.reset(
+            new std::thread(&RenderManagerOpenGLATW::threadFunc, this));
+    }
+
+    void RenderManagerOpenGLATW::stop() {
+        std::lock_guard<std::mutex> lock(m_ATWLock);
+        if (!m_started) {
+            std::cerr << "RenderManagerOpenGLATW::stop() - thread loop not "
+                         "already started."
+                      << std::endl;
+        }
+        m_quit = true;
+    }
+
+    bool RenderManagerOpenGLATW::getQuit() {
+        std::lock_guard<std::mutex> lock(m_ATWLock);
+        return m_quit;
+    }
+
+    bool RenderManagerOpenGLATW::presentFrame(
+        const ATWScheduler::Frame& frame) {
+        // Construct any requested distortion meshes in our context, since
+        // vertex array objects are not shared with the application's.
+        if (m_meshUpdatePending) {
+            m_meshUpdatePending = false;
+            m_precomputedMeshes.distort = &m_meshDistortion;
+            m_precomputedMeshes.type = m_meshType;
+            m_precomputedMeshes.meshes.swap(m_meshPrecomputed);
+            bool built = RenderManagerOpenGL::UpdateDistortionMeshesInternal(
+                m_meshType, m_meshDistortion);
+            m_precomputedMeshes.distort = nullptr;
+            m_precomputedMeshes.meshes.clear();
+            m_meshPrecomputed.clear();
+            if (!built) {
+                std::cerr << "RenderManagerOpenGLATW::presentFrame: "
+                             "Could not construct distortion mesh"
+                          << std::endl;
+                return false;
+            }
+        }
+
+        // Don't read from the buffers until the application's rendering
+        // into them has completed.
+        if (m_renderedFence) {
+            glWaitSync(m_renderedFence, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(m_renderedFence);
+            m_renderedFence = nullptr;
+        }
+
+        // Send the rendered results to the screen, using the RenderInfo that
+        // was handed to us by the client the last time they gave us some
+        // images.  The base class reads the current poses to compute the
+        // time warp.
+        if (!RenderManager::PresentRenderBuffersInternal(
+                frame.renderBuffers, frame.renderInfo, frame.renderParams,
+                frame.normalizedCroppingViewports, frame.flipInY)) {
+            std::cerr << "RenderManagerOpenGLATW::presentFrame: "
+                         "PresentRenderBuffers() failed"
+                      << std::endl;
+            return false;
+        }
+
+        // Mark the end of our reads from these buffers, so that the
+        // application can wait for it before rendering into them again.
+        if (m_presentedFence) {
+            glDeleteSync(m_presentedFence);
+        }
+        m_presentedFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        return true;
+    }
+
+    void RenderManagerOpenGLATW::waitForRetrace() {
+        // With vertical sync on, this returns at the retrace, which we use
+        // to estimate the display timing.
+        glFinish();
+        if (!m_params.m_verticalSync) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lock(m_ATWLock);
+        if (m_lastRetrace != Clock::time_point()) {
+            Clock::duration interval = now - m_lastRetrace;
+            if (m_refreshInterval == Clock::duration::zero() ||
+                interval < m_refreshInterval / 2) {
+                m_refreshInterval = interval;
+            } else if (interval < m_refreshInterval * 3 / 2) {
+                // Smooth out jitter, ignoring missed refreshes.
+                m_refreshInterval = (m_refreshInterval * 7 + interval) / 8;
+            }
+        }
+        m_lastRetrace = now;
+    }
+
+    void RenderManagerOpenGLATW::threadFunc() {
+        SDL_GL_MakeCurrent(m_displays[0].m_window, m_ATWContext);
+
+        while (!getQuit()) {
+            if (m_scheduler->tick() == ATWScheduler::FAILED) {
+                m_doingOkay = false;
+                std::lock_guard<std::mutex> lock(m_ATWLock);
+                m_quit = true;
+            }
+        }
+
+        // The distortion meshes' vertex array objects belong to our
+        // context, so they have to be deleted before we let it go, as
+        // does the debug callback that points at us.
+        deleteDistortionMeshes();
+        removeGLDebugCallback();
+        SDL_GL_MakeCurrent(m_displays[0].m_window, nullptr);
+    }
+
+} // namespace renderkit
+} // namespace osvr
@@ -0,0 +1,170 @@
+/** @file
+@brief Header file describing an asynchronous time warp renderer for the
+OpenGL rendering interface
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "RenderManagerOpenGL.h"
+#include "RenderManagerATWScheduler.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <memory>
+
+namespace osvr {
+namespace renderkit {
+
+    /// @brief OpenGL RenderManager that does asynchronous time warp.
+    ///
+    /// The application renders using the context that the base class
+    /// constructs, exactly as it would for RenderManagerOpenGL.  A second
+    /// context that shares objects with it is made current on a separate
+    /// thread, which re-presents the most-recently presented buffers with
+    /// freshly-read poses on every display refresh, whether or not the
+    /// application has handed it a new frame.  The decisions about when
+    /// and what to present are made by an ATWScheduler.
+    ///  Fences are used in place of the keyed mutexes used by the D3D11
+    /// ATW renderer: the application's context inserts one after it renders
+    /// each frame, which the ATW context waits on before reading the buffers;
+    /// the ATW context inserts one after each present, which the
+    /// application's context waits on before buffers handed to the ATW
+    /// thread are given back.  The ATW thread presents with m_mutex
+    /// locked, because the present uses the same state as the
+    /// application's calls, so PresentRenderBuffers() waits for a present
+    /// in progress to be issued; it does not wait for the card.
+    ///  As with the D3D11 ATW renderer, the buffers passed to
+    /// PresentRenderBuffers() are read by the ATW thread until the next
+    /// call, so applications should register twice as many buffers as
+    /// there are eyes and alternate between them to avoid tearing.
+    ///  Render() is not supported, because it would hand the ATW thread
+    /// the same internal buffers every frame and render into them while
+    /// they were being presented.
+    class RenderManagerOpenGLATW : public RenderManagerOpenGL {
+      public:
+        virtual ~RenderManagerOpenGLATW();
+
+        // Opens the display and starts the ATW thread.
+        OpenResults OpenDisplay() override;
+
+        /// Timing is estimated from the times at which the ATW thread's
+        /// buffer swaps complete, which are paced by vertical sync.
+        bool OSVR_RENDERMANAGER_EXPORT GetTimingInfo(
+            size_t whichEye //!< Each eye has a potentially different timing
+            ,
+            RenderTimingInfo& info //!< Info that is returned
+            ) override;
+
+      protected:
+        /// Construct an OpenGL ATW render manager.
+        RenderManagerOpenGLATW(
+            std::shared_ptr<osvr::clientkit::ClientContext> context,
+            ConstructorParameters p);
+
+        /// Hands the buffers to the ATW thread rather than presenting them.
+        bool PresentRenderBuffersInternal(
+            const std::vector<RenderBuffer>& buffers,
+            const std::vector<RenderInfo>& renderInfoUsed,
+            const RenderParams& renderParams = RenderParams(),
+            const std::vector<OSVR_ViewportDescription>&
+                normalizedCroppingViewports =
+                    std::vector<OSVR_ViewportDescription>(),
+            bool flipInY = false) override;
+
+        /// Vertex array objects are not shared between contexts, so the
+        /// meshes are constructed by the ATW thread in its own context.
+        /// This records the request for it to handle.
+        OSVR_RENDERMANAGER_EXPORT bool UpdateDistortionMeshesInternal(
+            DistortionMeshType type //< Type of mesh to produce
+            ,
+            std::vector<DistortionParameters> const&
+                distort //< Distortion parameters
+            ) override;
+
+        /// Render() would draw into the one set of internal buffers while
+        /// the ATW thread was presenting from it, so it is refused.
+        bool RenderFrameInitialize() override;
+
+        /// The ATW context is only used for presenting, so there is no
+        /// application state in it to save and restore.
+        bool PresentFrameInitialize() override { return true; }
+
+        /// Presentation is done on the ATW thread using its own context.
+        bool PresentDisplayInitialize(size_t display) override;
+
+        /// SDL events have to be handled on the application's thread,
+        /// which is done during PresentRenderBuffersInternal().
+        bool PresentFrameFinalize() override { return true; }
+
+        void start();
+        void stop();
+        bool getQuit();
+        void threadFunc();
+
+        /// Presents a frame with the current poses.  Called by the
+        /// scheduler on the ATW thread with m_mutex locked.
+        bool presentFrame(const ATWScheduler::Frame& frame);
+
+        /// Waits for the swap to complete and updates the timing estimate.
+        /// Called by the scheduler on the ATW thread after m_mutex has been
+        /// unlocked, so that the application can hand us a new frame in
+        /// the meantime.
+        void waitForRetrace();
+
+        SDL_GLContext m_ATWContext = nullptr; //< Context used by ATW thread
+        std::unique_ptr<std::thread> m_thread;
+        std::unique_ptr<ATWScheduler> m_scheduler;
+
+        /// Guards the thread state and the timing estimates below; never
+        /// held while locking m_mutex.
+        std::mutex m_ATWLock;
+        bool m_quit = false;
+        bool m_started = false;
+
+        /// Fences, accessed with m_mutex locked.
+        GLsync m_renderedFence = nullptr; //< Inserted by the app context
+        GLsync m_presentedFence = nullptr; //< Inserted by the ATW context
+
+        /// Distortion mesh request to be handled by the ATW thread.
+        /// Accessed with m_mutex locked.
+        bool m_meshUpdatePending = false;
+        DistortionMeshType m_meshType = SQUARE;
+        std::vector<DistortionParameters> m_meshDistortion;
+        std::vector<std::vector<DistortionMeshVertex> > m_meshPrecomputed;
+
+        /// Estimate of the display refresh timing, based on when the
+        /// ATW thread's swaps complete.
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point m_lastRetrace;
+        Clock::duration m_refreshInterval = Clock::duration::zero();
+
+        friend RenderManager OSVR_RENDERMANAGER_EXPORT*
+        createRenderManager(OSVR_ClientContext context,
+                            const std::string& renderLibraryName,
+                            GraphicsLibrary graphicsLibrary);
+    };
+
+} // namespace renderkit
+} // namespace osvr
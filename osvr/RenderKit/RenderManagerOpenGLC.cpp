@@ -107,6 +107,26 @@ OSVR_ReturnCode osvrRenderManagerGetRenderInfoOpenGL(
                                               renderParams, renderInfoOut);
 }
 
+OSVR_ReturnCode osvrRenderManagerGetFrameRenderInfoOpenGL(
+    OSVR_RenderManagerOpenGL renderManager, OSVR_RenderParams renderParams,
+    OSVR_RenderInfoCount renderInfoCapacity,
+    OSVR_RenderInfoOpenGL* renderInfoOut,
+    OSVR_RenderInfoCount* numRenderInfoOut,
+    OSVR_RenderFrameInfo* frameInfoOut) {
+    return osvrRenderManagerGetFrameRenderInfoImpl(
+        renderManager, renderParams, renderInfoCapacity, renderInfoOut,
+        numRenderInfoOut, frameInfoOut);
+}
+
+OSVR_ReturnCode
+osvrRenderManagerGetRenderRegionOpenGL(
+    OSVR_RenderManagerOpenGL renderManager,
+    const OSVR_RenderInfoOpenGL* eyeInfo, OSVR_RenderInfoCount regionIndex,
+    OSVR_RenderInfoOpenGL* regionOut) {
+    return osvrRenderManagerGetRenderRegionImpl(renderManager, eyeInfo,
+                                                regionIndex, regionOut);
+}
+
 OSVR_ReturnCode
 osvrRenderManagerOpenDisplayOpenGL(OSVR_RenderManagerOpenGL renderManager,
                                    OSVR_OpenResultsOpenGL* openResultsOut) {
@@ -71,6 +71,28 @@ OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode osvrRenderManagerGetRenderInfoOpenGL(
     OSVR_RenderInfoCount renderInfoIndex, OSVR_RenderParams renderParams,
     OSVR_RenderInfoOpenGL* renderInfoOut);
 
+/// Gets the render info for all surfaces, along with the frame it was
+/// latched for, in one call.  The client context is updated at most once
+/// per frame: later calls in the same frame get the poses read by the
+/// first, with their own render parameters applied.
+/// numRenderInfoOut is set to the number of surfaces; if that is more than
+/// renderInfoCapacity, none are copied and failure is returned.
+OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
+osvrRenderManagerGetFrameRenderInfoOpenGL(
+    OSVR_RenderManagerOpenGL renderManager, OSVR_RenderParams renderParams,
+    OSVR_RenderInfoCount renderInfoCapacity,
+    OSVR_RenderInfoOpenGL* renderInfoOut,
+    OSVR_RenderInfoCount* numRenderInfoOut,
+    OSVR_RenderFrameInfo* frameInfoOut);
+
+/// Gets the render info for one region of a surface, which is eyeInfo with
+/// its viewport and projection replaced by those of the region.
+OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
+osvrRenderManagerGetRenderRegionOpenGL(
+    OSVR_RenderManagerOpenGL renderManager,
+    const OSVR_RenderInfoOpenGL* eyeInfo, OSVR_RenderInfoCount regionIndex,
+    OSVR_RenderInfoOpenGL* regionOut);
+
 OSVR_RENDERMANAGER_EXPORT OSVR_ReturnCode
 osvrRenderManagerOpenDisplayOpenGL(OSVR_RenderManagerOpenGL renderManager,
                                    OSVR_OpenResultsOpenGL* openResultsOut);
@@ -0,0 +1,106 @@
+/** @file
+@brief Header file describing a lock-free triple buffer for handing the
+most-recent value from one thread to another
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Standard includes
+#include <atomic>
+#include <cstdint>
+
+namespace osvr {
+namespace renderkit {
+
+    /// @brief Lock-free single-producer, single-consumer slot that always
+    /// gives the consumer the most-recently published value.
+    ///
+    /// There are three copies of T: one being filled in by the producer,
+    /// one being read by the consumer, and one holding the most-recently
+    /// published value.  Publishing swaps the producer's copy with the
+    /// published one, and taking swaps the consumer's copy with it, each
+    /// with a single atomic exchange, so neither side ever waits for the
+    /// other.  Values published faster than they are taken are replaced;
+    /// publish() reports when that happens so that the producer can
+    /// reclaim anything the replaced value refers to.
+    ///  Exactly one thread at a time may use the producer methods
+    /// (writeBuffer() and publish()) and exactly one thread at a time may
+    /// use the consumer methods (take() and readBuffer()).  The slots are
+    /// reused, so assigning into writeBuffer() can reuse the storage of
+    /// containers in T rather than allocating.
+    template <typename T> class TripleBuffer {
+      public:
+        TripleBuffer() : m_state(INITIAL_PUBLISHED) {}
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        /// Producer: The copy to fill in before calling publish().  After
+        /// publish() returns true, this holds the value that was replaced
+        /// without ever having been taken.
+        T& writeBuffer() { return m_slots[m_writeIndex]; }
+
+        /// Producer: Make the contents of writeBuffer() the newest value.
+        /// Returns true if the value it replaced had not been taken.
+        bool publish() {
+            uint8_t prev = m_state.exchange(m_writeIndex | FRESH_BIT,
+                                            std::memory_order_acq_rel);
+            m_writeIndex = prev & INDEX_MASK;
+            return (prev & FRESH_BIT) != 0;
+        }
+
+        /// Consumer: Move the newest published value into readBuffer(), if
+        /// one has been published since the last call.  Returns true if
+        /// readBuffer() changed.
+        bool take() {
+            // Only the consumer clears the fresh bit, so if it is set here
+            // it will still be set when we do the exchange.
+            if ((m_state.load(std::memory_order_relaxed) & FRESH_BIT) == 0) {
+                return false;
+            }
+            uint8_t prev =
+                m_state.exchange(m_readIndex, std::memory_order_acq_rel);
+            m_readIndex = prev & INDEX_MASK;
+            return true;
+        }
+
+        /// Consumer: The value most-recently taken.  This is not modified
+        /// by the producer, so it remains valid until the next take().
+        T& readBuffer() { return m_slots[m_readIndex]; }
+
+      private:
+        static const uint8_t INDEX_MASK = 0x3;
+        static const uint8_t FRESH_BIT = 0x4;
+        static const uint8_t INITIAL_PUBLISHED = 2;
+
+        T m_slots[3];
+        uint8_t m_writeIndex = 0; //< Only touched by the producer
+        uint8_t m_readIndex = 1;  //< Only touched by the consumer
+
+        /// Index of the published slot, plus FRESH_BIT if it has not been
+        /// taken since it was published.
+        std::atomic<uint8_t> m_state;
+    };
+
+} // namespace renderkit
+} // namespace osvr
@@ -0,0 +1,166 @@
+/** @file
+@brief Stress test of the frame handoff between an application thread and
+an asynchronous time warp thread, meant to be run under ThreadSanitizer
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "TripleBuffer.h"
+#include "RenderManagerATWScheduler.h"
+
+// Standard includes
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+using osvr::renderkit::ATWScheduler;
+using osvr::renderkit::TripleBuffer;
+using osvr::renderkit::OSVR_ViewportDescription;
+
+/// Number of values handed over in each part of the test.
+static const uint64_t ITERATIONS = 200000;
+
+/// Producer publishes vectors whose entries all hold the sequence number;
+/// the consumer must only ever see whole values, in increasing order.
+static void testTripleBuffer() {
+    TripleBuffer<std::vector<uint64_t> > buffer;
+    std::atomic<bool> done(false);
+
+    std::thread producer([&]() {
+        for (uint64_t seq = 1; seq <= ITERATIONS; seq++) {
+            std::vector<uint64_t>& value = buffer.writeBuffer();
+            value.assign(16, seq);
+            buffer.publish();
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint64_t last = 0;
+    bool finished = false;
+    while (!finished) {
+        // Read done before taking, so that the last value is seen.
+        finished = done.load(std::memory_order_acquire);
+        if (!buffer.take()) {
+            continue;
+        }
+        const std::vector<uint64_t>& value = buffer.readBuffer();
+        if (!OSVRRM_CHECK(value.size() == 16)) {
+            break;
+        }
+        for (size_t i = 1; i < value.size(); i++) {
+            OSVRRM_CHECK(value[i] == value[0]);
+        }
+        OSVRRM_CHECK(value[0] > last);
+        last = value[0];
+    }
+    producer.join();
+    OSVRRM_CHECK(last == ITERATIONS);
+}
+
+/// Races the first submit() against tick() on many fresh schedulers: the
+/// empty frame a scheduler starts with must never be presented.
+static void testFirstFrame() {
+    for (int round = 0; round < 2000; round++) {
+        uint64_t presented = 0;
+        ATWScheduler::Hooks hooks;
+        hooks.sleepUntil = [](ATWScheduler::Clock::time_point) {
+            std::this_thread::yield();
+        };
+        hooks.present = [&](const ATWScheduler::Frame& frame) {
+            presented = frame.index;
+            return ATWScheduler::PRESENT_DONE;
+        };
+        ATWScheduler scheduler(hooks);
+
+        std::thread application([&]() { scheduler.submit(); });
+        while (scheduler.tick() == ATWScheduler::IDLE) {
+        }
+        application.join();
+        if (!OSVRRM_CHECK(presented == 1)) {
+            break;
+        }
+    }
+}
+
+/// The application thread submits frames as fast as it can while the ATW
+/// thread ticks with no sleeping.  The present hook plays the part of a
+/// renderer that can tell when its frame has been replaced.  Frames must
+/// arrive whole, in order, never before one has been submitted, and the
+/// last one must be presented.
+static void testScheduler() {
+    std::atomic<uint64_t> latestSubmitted(0);
+    uint64_t lastPresented = 0;
+
+    ATWScheduler::Hooks hooks;
+    hooks.sleepUntil = [](ATWScheduler::Clock::time_point) {
+        std::this_thread::yield();
+    };
+    hooks.present = [&](const ATWScheduler::Frame& frame) {
+        OSVRRM_CHECK(frame.index != 0);
+        OSVRRM_CHECK(frame.index >= lastPresented);
+        if (OSVRRM_CHECK(frame.normalizedCroppingViewports.size() == 2)) {
+            for (size_t i = 0; i < 2; i++) {
+                OSVRRM_CHECK(frame.normalizedCroppingViewports[i].left ==
+                             static_cast<double>(frame.index));
+            }
+        }
+        if (frame.index < latestSubmitted.load()) {
+            return ATWScheduler::PRESENT_SUPERSEDED;
+        }
+        lastPresented = frame.index;
+        return ATWScheduler::PRESENT_DONE;
+    };
+    ATWScheduler scheduler(hooks);
+
+    std::thread application([&]() {
+        for (uint64_t seq = 1; seq <= ITERATIONS; seq++) {
+            ATWScheduler::Frame& frame = scheduler.nextFrame();
+            OSVR_ViewportDescription viewport = {};
+            viewport.left = static_cast<double>(seq);
+            frame.normalizedCroppingViewports.assign(2, viewport);
+            scheduler.submit();
+            latestSubmitted.store(seq);
+        }
+    });
+
+    while (lastPresented < ITERATIONS) {
+        ATWScheduler::TickResult result = scheduler.tick();
+        if (!OSVRRM_CHECK(result != ATWScheduler::FAILED)) {
+            break;
+        }
+    }
+    application.join();
+
+    ATWScheduler::Statistics stats = scheduler.getStatistics();
+    OSVRRM_CHECK(stats.presents == stats.newFrames + stats.repeatedFrames);
+    OSVRRM_CHECK(stats.newFrames + stats.droppedFrames <= ITERATIONS);
+    OSVRRM_CHECK(stats.newFrames > 0);
+}
+
+int main(int argc, char* argv[]) {
+    testTripleBuffer();
+    testFirstFrame();
+    testScheduler();
+    return osvr::renderkit::test::result();
+}
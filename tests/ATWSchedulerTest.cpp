@@ -0,0 +1,286 @@
+/** @file
+@brief Tests of the asynchronous time warp scheduler, driven by a simulated
+clock and display
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "RenderManagerATWScheduler.h"
+
+// Standard includes
+#include <chrono>
+#include <functional>
+#include <vector>
+
+using osvr::renderkit::ATWScheduler;
+using osvr::renderkit::RenderTimingInfo;
+typedef ATWScheduler::Clock Clock;
+typedef std::chrono::milliseconds ms;
+
+/// A display that refreshes every 16 ms starting at time zero, a clock
+/// that only moves when the scheduler sleeps or presents, and a present
+/// sink that takes a set time.
+class SimulatedDisplay {
+  public:
+    SimulatedDisplay() {
+        m_hooks.now = [this]() { return now; };
+        m_hooks.sleepUntil = [this](Clock::time_point when) {
+            sleeps.push_back(when);
+            if (when > now) {
+                now = when;
+            }
+        };
+        m_hooks.getTimingInfo = [this](RenderTimingInfo& info) {
+            if (!timingAvailable) {
+                return false;
+            }
+            Clock::duration since = now.time_since_epoch() % refresh;
+            info.hardwareDisplayInterval = toTimeValue(refresh);
+            info.timeSincelastVerticalRetrace = toTimeValue(since);
+            info.timeUntilNextPresentRequired = toTimeValue(refresh - since);
+            return true;
+        };
+        m_hooks.getThresholdMS = [this]() { return thresholdMS; };
+        m_hooks.present = [this](const ATWScheduler::Frame& frame) {
+            presentTimes.push_back(now);
+            presentedIndices.push_back(frame.index);
+            now += presentDuration;
+            if (duringPresent) {
+                duringPresent();
+            }
+            if (!results.empty()) {
+                ATWScheduler::PresentResult ret = results.front();
+                results.erase(results.begin());
+                return ret;
+            }
+            return ATWScheduler::PRESENT_DONE;
+        };
+    }
+
+    ATWScheduler::Hooks hooks() const { return m_hooks; }
+
+    static OSVR_TimeValue toTimeValue(Clock::duration d) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(d);
+        OSVR_TimeValue ret;
+        ret.seconds = static_cast<OSVR_TimeValue_Seconds>(us.count() / 1000000);
+        ret.microseconds =
+            static_cast<OSVR_TimeValue_Microseconds>(us.count() % 1000000);
+        return ret;
+    }
+
+    Clock::duration refresh = ms(16);
+    Clock::duration presentDuration = ms(1);
+    float thresholdMS = 2.0f;
+    bool timingAvailable = true;
+
+    /// Results for the present hook to return, in order, before it goes
+    /// back to PRESENT_DONE.
+    std::vector<ATWScheduler::PresentResult> results;
+
+    /// Called from the present hook, to act as the application would
+    /// while a present is in progress.
+    std::function<void()> duringPresent;
+
+    Clock::time_point now = Clock::time_point(ms(3));
+    std::vector<Clock::time_point> sleeps;
+    std::vector<Clock::time_point> presentTimes;
+    std::vector<uint64_t> presentedIndices;
+
+  private:
+    ATWScheduler::Hooks m_hooks;
+};
+
+/// With no frame submitted, tick() sleeps briefly and presents nothing.
+static void testIdle() {
+    SimulatedDisplay display;
+    ATWScheduler scheduler(display.hooks());
+    Clock::time_point start = display.now;
+
+    OSVRRM_CHECK(!scheduler.hasFrame());
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::IDLE);
+    OSVRRM_CHECK(display.presentTimes.empty());
+    OSVRRM_CHECK(display.sleeps.size() == 1);
+    OSVRRM_CHECK(display.now == start + ms(1));
+    OSVRRM_CHECK(scheduler.getStatistics().presents == 0);
+}
+
+/// The present happens the threshold before the next retrace, and one
+/// that is already inside the threshold does not sleep.
+static void testSleepsToThreshold() {
+    SimulatedDisplay display;
+    ATWScheduler scheduler(display.hooks());
+    scheduler.submit(ATWScheduler::Frame());
+
+    // 3 ms into a 16 ms refresh, with a 2 ms threshold: present at 14 ms.
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    if (OSVRRM_CHECK(display.presentTimes.size() == 1)) {
+        OSVRRM_CHECK(display.presentTimes[0] == Clock::time_point(ms(14)));
+    }
+
+    // Now 15 ms, inside the threshold of the retrace at 16 ms.
+    display.sleeps.clear();
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    OSVRRM_CHECK(display.sleeps.empty());
+    if (OSVRRM_CHECK(display.presentTimes.size() == 2)) {
+        OSVRRM_CHECK(display.presentTimes[1] == Clock::time_point(ms(15)));
+    }
+
+    // A non-positive threshold is replaced by the default.
+    display.thresholdMS = 0;
+    display.now = Clock::time_point(ms(16 + 4));
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    if (OSVRRM_CHECK(display.presentTimes.size() == 3)) {
+        OSVRRM_CHECK(display.presentTimes[2] ==
+                     Clock::time_point(ms(32)) -
+                         std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<float, std::milli>(
+                                 ATWScheduler::DEFAULT_THRESHOLD_MS)));
+    }
+
+    // Without timing information, present straight away.
+    display.timingAvailable = false;
+    display.sleeps.clear();
+    Clock::time_point before = display.now;
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    OSVRRM_CHECK(display.sleeps.empty());
+    OSVRRM_CHECK(display.presentTimes.back() == before);
+}
+
+/// A frame that is not replaced is presented again on later refreshes.
+static void testRepeatedFrames() {
+    SimulatedDisplay display;
+    ATWScheduler scheduler(display.hooks());
+    scheduler.submit(ATWScheduler::Frame());
+    for (int i = 0; i < 3; i++) {
+        OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    }
+    ATWScheduler::Statistics stats = scheduler.getStatistics();
+    OSVRRM_CHECK(stats.presents == 3);
+    OSVRRM_CHECK(stats.newFrames == 1);
+    OSVRRM_CHECK(stats.repeatedFrames == 2);
+    OSVRRM_CHECK(stats.droppedFrames == 0);
+    for (size_t i = 0; i < display.presentedIndices.size(); i++) {
+        OSVRRM_CHECK(display.presentedIndices[i] == 1);
+    }
+
+    // Latency runs from submit to the end of the first present.
+    OSVRRM_CHECK(stats.lastLatency == ms(14 + 1 - 3));
+    OSVRRM_CHECK(stats.maxLatency == stats.lastLatency);
+}
+
+/// Frames replaced before the scheduler takes them are dropped, and the
+/// newest one is presented.
+static void testDroppedFrames() {
+    SimulatedDisplay display;
+    ATWScheduler scheduler(display.hooks());
+    OSVRRM_CHECK(!scheduler.submit(ATWScheduler::Frame()));
+    OSVRRM_CHECK(scheduler.submit(ATWScheduler::Frame()));
+    OSVRRM_CHECK(scheduler.submit(ATWScheduler::Frame()));
+    OSVRRM_CHECK(scheduler.getStatistics().droppedFrames == 2);
+
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    if (OSVRRM_CHECK(display.presentedIndices.size() == 1)) {
+        OSVRRM_CHECK(display.presentedIndices[0] == 3);
+    }
+
+    // A frame submitted after the last one was taken is not dropped.
+    OSVRRM_CHECK(!scheduler.submit(ATWScheduler::Frame()));
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    ATWScheduler::Statistics stats = scheduler.getStatistics();
+    OSVRRM_CHECK(stats.droppedFrames == 2);
+    OSVRRM_CHECK(stats.newFrames == 2);
+}
+
+/// Presents that run past the retrace are counted as missed deadlines.
+static void testMissedDeadlines() {
+    SimulatedDisplay display;
+    ATWScheduler scheduler(display.hooks());
+    scheduler.submit(ATWScheduler::Frame());
+
+    // Starts 2 ms before the retrace and takes 1 ms.
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    OSVRRM_CHECK(scheduler.getStatistics().missedDeadlines == 0);
+
+    // Takes 3 ms, running past the retrace.
+    display.presentDuration = ms(3);
+    display.now = Clock::time_point(ms(16 + 5));
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    OSVRRM_CHECK(scheduler.getStatistics().missedDeadlines == 1);
+
+    // Without timing information there is no deadline to miss.
+    display.timingAvailable = false;
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    OSVRRM_CHECK(scheduler.getStatistics().missedDeadlines == 1);
+}
+
+/// A superseded frame is replaced by the newer one within the same tick,
+/// and is not counted as presented when there is no newer one.
+static void testSupersededFrames() {
+    SimulatedDisplay display;
+    ATWScheduler scheduler(display.hooks());
+    scheduler.submit(ATWScheduler::Frame());
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+
+    // The application submits frame 2 while frame 1 is being re-presented,
+    // so the renderer gives up on frame 1.
+    display.results.push_back(ATWScheduler::PRESENT_SUPERSEDED);
+    display.duringPresent = [&]() {
+        display.duringPresent = nullptr;
+        scheduler.submit(ATWScheduler::Frame());
+    };
+    display.now = Clock::time_point(ms(16 + 3));
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::PRESENTED);
+    if (OSVRRM_CHECK(display.presentedIndices.size() == 3)) {
+        OSVRRM_CHECK(display.presentedIndices[1] == 1);
+        OSVRRM_CHECK(display.presentedIndices[2] == 2);
+    }
+    // Both attempts were made before the retrace.
+    OSVRRM_CHECK(display.presentTimes.back() < Clock::time_point(ms(32)));
+    ATWScheduler::Statistics stats = scheduler.getStatistics();
+    OSVRRM_CHECK(stats.presents == 2);
+    OSVRRM_CHECK(stats.newFrames == 2);
+    OSVRRM_CHECK(stats.repeatedFrames == 0);
+    OSVRRM_CHECK(stats.supersededFrames == 1);
+
+    // With no newer frame to take, nothing is presented.
+    display.results.push_back(ATWScheduler::PRESENT_SUPERSEDED);
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::SKIPPED);
+    stats = scheduler.getStatistics();
+    OSVRRM_CHECK(stats.presents == 2);
+    OSVRRM_CHECK(stats.supersededFrames == 2);
+
+    // Failures are reported.
+    display.results.push_back(ATWScheduler::PRESENT_FAILED);
+    OSVRRM_CHECK(scheduler.tick() == ATWScheduler::FAILED);
+    OSVRRM_CHECK(scheduler.getStatistics().presents == 2);
+}
+
+int main(int argc, char* argv[]) {
+    testIdle();
+    testSleepsToThreshold();
+    testRepeatedFrames();
+    testDroppedFrames();
+    testMissedDeadlines();
+    testSupersededFrames();
+    return osvr::renderkit::test::result();
+}
@@ -0,0 +1,135 @@
+/** @file
+@brief Test that the adaptive time-warp threshold follows the cost of
+presenting, not the time that buffer swaps spend waiting for vertical sync
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include <GL/glew.h>
+#include "RenderManagerOpenGL.h"
+
+// Standard includes
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using osvr::renderkit::RenderManager;
+using osvr::renderkit::RenderManagerOpenGL;
+using osvr::renderkit::test::SKIPPED;
+typedef std::chrono::steady_clock Clock;
+
+/// Refresh interval of the simulated display.
+static const std::chrono::microseconds REFRESH(16667);
+
+/// Bounds on the adaptive threshold, and the window it is taken over.
+static const float MIN_MS = 1.0f;
+static const float MAX_MS = 12.0f;
+static const unsigned WINDOW = 30;
+
+/// Frames presented, enough to fill the window several times over.
+static const size_t FRAMES = 120;
+
+/// Two eyes side by side on a display small enough for a software OpenGL
+/// to present quickly.
+static const char* DISPLAY =
+    "{\"hmd\": {"
+    " \"field_of_view\": {\"monocular_horizontal\": 90,"
+    "  \"monocular_vertical\": 90},"
+    " \"device\": {\"vendor\": \"OSVR\", \"model\": \"Test\"},"
+    " \"resolutions\": [{\"width\": 320, \"height\": 180,"
+    "  \"video_inputs\": 1, \"display_mode\": \"horz_side_by_side\"}],"
+    " \"eyes\": [{}, {}]}}";
+
+/// The OpenGL renderer, built from our own parameters rather than from a
+/// server's configuration, whose swaps block until the next refresh of a
+/// simulated display as they do with vertical sync.
+class BlockingSwapRenderManager : public RenderManagerOpenGL {
+  public:
+    BlockingSwapRenderManager(
+        std::shared_ptr<osvr::clientkit::ClientContext> context,
+        ConstructorParameters p)
+        : RenderManagerOpenGL(context, p), m_start(Clock::now()) {}
+
+  protected:
+    void SwapDisplay(size_t display) override {
+        RenderManagerOpenGL::SwapDisplay(display);
+        Clock::duration intoRefresh = (Clock::now() - m_start) % REFRESH;
+        std::this_thread::sleep_for(REFRESH - intoRefresh);
+    }
+
+  private:
+    Clock::time_point m_start;
+};
+
+int main(int argc, char* argv[]) {
+    std::shared_ptr<osvr::clientkit::ClientContext> context =
+        std::make_shared<osvr::clientkit::ClientContext>(
+            "com.osvr.renderManager.AdaptiveTimeWarpTest");
+    RenderManager::ConstructorParameters p;
+    p.m_renderLibrary = "OpenGL";
+    p.m_verticalSync = false;
+    p.m_enableTimeWarp = true;
+    p.m_adaptiveTimeWarpThreshold = true;
+    p.m_adaptiveTimeWarpMinMS = MIN_MS;
+    p.m_adaptiveTimeWarpMaxMS = MAX_MS;
+    p.m_adaptiveTimeWarpWindow = WINDOW;
+    std::unique_ptr<RenderManager> render;
+    try {
+        p.m_displayConfiguration.parse(DISPLAY);
+        render.reset(new BlockingSwapRenderManager(context, p));
+    } catch (std::exception& e) {
+        std::cerr << "Could not make a RenderManager: " << e.what()
+                  << std::endl;
+        return SKIPPED;
+    }
+    if (!render->doingOkay() ||
+        render->OpenDisplay().status == RenderManager::OpenStatus::FAILURE) {
+        std::cerr << "Could not open an offscreen display, skipping"
+                  << std::endl;
+        return SKIPPED;
+    }
+
+    Clock::time_point start = Clock::now();
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        if (!OSVRRM_CHECK(render->Render())) {
+            break;
+        }
+    }
+    Clock::duration perFrame = (Clock::now() - start) / FRAMES;
+
+    // The swaps did hold each frame to the refresh, most of which was
+    // spent blocked in them; none of that should have been counted.
+    float thresholdMS = render->GetTimeWarpThresholdMS();
+    std::cout << "Frame interval "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                     perFrame)
+                     .count()
+              << " us, time-warp threshold " << thresholdMS << " ms"
+              << std::endl;
+    OSVRRM_CHECK(perFrame >= REFRESH * 9 / 10);
+    OSVRRM_CHECK(thresholdMS >= MIN_MS);
+    OSVRRM_CHECK(thresholdMS < MAX_MS / 2);
+    return osvr::renderkit::test::result();
+}
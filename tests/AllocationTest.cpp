@@ -0,0 +1,268 @@
+/** @file
+@brief Test that the per-frame paths that are meant not to allocate do
+not, using a counting global operator new
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "TestServer.h"
+#include "RenderManagerATWScheduler.h"
+#include <osvr/RenderKit/RenderManager.h>
+#include <osvr/RenderKit/RenderManagerOpenGLC.h>
+
+// Standard includes
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+using osvr::renderkit::ATWScheduler;
+using osvr::renderkit::RenderInfo;
+using osvr::renderkit::RenderManager;
+using osvr::renderkit::RenderTimingInfo;
+using osvr::renderkit::test::SKIPPED;
+
+/// Number of frames over which allocations are counted.
+static const size_t FRAMES = 200;
+
+/// Frames run before counting, so that buffers that are kept for reuse
+/// have been made.
+static const size_t WARM_UP_FRAMES = 10;
+
+//==========================================================================
+// Global operator new and delete, counting allocations made by the thread
+// that is being measured.
+
+static size_t g_allocations = 0;
+static thread_local bool g_counting = false;
+
+static void* countedAllocate(size_t size) {
+    if (g_counting) {
+        g_allocations++;
+    }
+    void* ret = std::malloc(size == 0 ? 1 : size);
+    if (ret == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ret;
+}
+
+void* operator new(size_t size) { return countedAllocate(size); }
+void* operator new[](size_t size) { return countedAllocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocate(size);
+    } catch (std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocate(size);
+    } catch (std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+
+/// Counts the allocations this thread makes while it is in scope.
+class AllocationCounter {
+  public:
+    AllocationCounter() {
+        g_allocations = 0;
+        g_counting = true;
+    }
+    ~AllocationCounter() { g_counting = false; }
+    size_t count() const { return g_allocations; }
+};
+
+//==========================================================================
+// The time-warp scheduler, driven by a simulated clock and display whose
+// hooks do not allocate themselves.
+
+static void testScheduler() {
+    typedef ATWScheduler::Clock Clock;
+    const Clock::duration refresh = std::chrono::milliseconds(16);
+    Clock::time_point now = Clock::time_point(std::chrono::milliseconds(3));
+
+    ATWScheduler::Hooks hooks;
+    hooks.now = [&now]() { return now; };
+    hooks.sleepUntil = [&now](Clock::time_point when) {
+        if (when > now) {
+            now = when;
+        }
+    };
+    hooks.getTimingInfo = [&now, refresh](RenderTimingInfo& info) {
+        auto us = [](Clock::duration d) {
+            auto count =
+                std::chrono::duration_cast<std::chrono::microseconds>(d)
+                    .count();
+            OSVR_TimeValue ret;
+            ret.seconds =
+                static_cast<OSVR_TimeValue_Seconds>(count / 1000000);
+            ret.microseconds =
+                static_cast<OSVR_TimeValue_Microseconds>(count % 1000000);
+            return ret;
+        };
+        Clock::duration since = now.time_since_epoch() % refresh;
+        info.hardwareDisplayInterval = us(refresh);
+        info.timeSincelastVerticalRetrace = us(since);
+        info.timeUntilNextPresentRequired = us(refresh - since);
+        return true;
+    };
+    size_t presented = 0;
+    hooks.present = [&now, &presented](const ATWScheduler::Frame&) {
+        now += std::chrono::milliseconds(1);
+        presented++;
+        return ATWScheduler::PRESENT_DONE;
+    };
+    ATWScheduler scheduler(hooks);
+
+    // What the application hands over each frame, for two eyes.
+    std::vector<osvr::renderkit::RenderBuffer> buffers(2);
+    std::vector<RenderInfo> renderInfo(2);
+    std::vector<osvr::renderkit::OSVR_ViewportDescription> viewports(2);
+
+    auto frame = [&]() {
+        ATWScheduler::Frame& next = scheduler.nextFrame();
+        next.renderBuffers = buffers;
+        next.renderInfo = renderInfo;
+        next.normalizedCroppingViewports = viewports;
+        scheduler.submit();
+        return scheduler.tick();
+    };
+    for (size_t i = 0; i < WARM_UP_FRAMES; i++) {
+        frame();
+    }
+
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        for (size_t i = 0; i < FRAMES; i++) {
+            if (frame() != ATWScheduler::PRESENTED) {
+                break;
+            }
+        }
+        allocations = counter.count();
+    }
+    std::cout << "ATWScheduler submit() and tick(): " << allocations
+              << " allocations in " << FRAMES << " frames" << std::endl;
+    OSVRRM_CHECK(presented == WARM_UP_FRAMES + FRAMES);
+    OSVRRM_CHECK(allocations == 0);
+}
+
+//==========================================================================
+// Latching and reading render info, through the C++ and C interfaces.
+
+/// Count the allocations that osvrClientUpdate() makes on a context of our
+/// own, which RenderManager has no say in: it may allocate as reports
+/// arrive from the server.  Render info is latched at most once per
+/// frame here, so this is what latching may add per frame.
+static size_t
+clientUpdateAllocations(osvr::clientkit::ClientContext& context) {
+    for (size_t i = 0; i < WARM_UP_FRAMES; i++) {
+        context.update();
+    }
+    AllocationCounter counter;
+    for (size_t i = 0; i < FRAMES; i++) {
+        context.update();
+    }
+    return counter.count();
+}
+
+/// @return False if there is no server or display to test with.
+static bool testRenderInfo() {
+    osvr::clientkit::ClientContext context(
+        "com.osvr.renderManager.AllocationTest");
+    if (!osvr::renderkit::test::waitForServer(context)) {
+        std::cerr << "No OSVR server is describing a display, skipping"
+                  << std::endl;
+        return false;
+    }
+    std::unique_ptr<RenderManager> render(
+        osvr::renderkit::createRenderManager(context.get(), "OpenGL"));
+    if (!render || !render->doingOkay() ||
+        render->OpenDisplay().status == RenderManager::OpenStatus::FAILURE) {
+        std::cerr << "Could not open a display, skipping" << std::endl;
+        return false;
+    }
+
+    // The C interface's handle is the RenderManager itself.
+    OSVR_RenderManager renderC = reinterpret_cast<OSVR_RenderManager>(
+        static_cast<RenderManager*>(render.get()));
+    OSVR_RenderParams paramsC;
+    osvrRenderManagerGetDefaultRenderParams(&paramsC);
+
+    size_t numEyes = 0;
+    auto frame = [&]() {
+        numEyes = render->LatchRenderInfo();
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            RenderInfo info = render->GetRenderInfo(eye);
+            (void)info;
+        }
+        OSVR_RenderInfoCount numEyesC = 0;
+        osvrRenderManagerGetNumRenderInfo(renderC, paramsC, &numEyesC);
+        for (OSVR_RenderInfoCount eye = 0; eye < numEyesC; eye++) {
+            OSVR_RenderInfoOpenGL infoC;
+            OSVRRM_CHECK(osvrRenderManagerGetRenderInfoOpenGL(
+                             renderC, eye, paramsC, &infoC) ==
+                         OSVR_RETURN_SUCCESS);
+        }
+    };
+    for (size_t i = 0; i < WARM_UP_FRAMES; i++) {
+        frame();
+    }
+
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        for (size_t i = 0; i < FRAMES; i++) {
+            frame();
+        }
+        allocations = counter.count();
+    }
+    size_t allowed = clientUpdateAllocations(context);
+    std::cout << "LatchRenderInfo(), GetRenderInfo(index) and the C "
+                 "osvrRenderManagerGetRenderInfoOpenGL(): "
+              << allocations << " allocations in " << FRAMES
+              << " frames; osvrClientUpdate() made " << allowed << std::endl;
+    OSVRRM_CHECK(numEyes > 0);
+    OSVRRM_CHECK(allocations <= allowed);
+    return true;
+}
+
+/// Runs the scheduler part, which needs nothing, or with the argument
+/// renderInfo the part that needs a server and a display.
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "renderInfo") {
+        if (!testRenderInfo()) {
+            return SKIPPED;
+        }
+    } else {
+        testScheduler();
+    }
+    return osvr::renderkit::test::result();
+}
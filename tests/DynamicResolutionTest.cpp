@@ -0,0 +1,180 @@
+/** @file
+@brief Tests of the dynamic resolution controller, driven by a simulated
+clock
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "RenderManagerDynamicResolution.h"
+
+// Standard includes
+#include <chrono>
+#include <cmath>
+
+using osvr::renderkit::DynamicResolutionController;
+typedef DynamicResolutionController::Clock Clock;
+typedef std::chrono::microseconds us;
+
+/// Target frame time used throughout.
+static const float TARGET_MS = 10.0f;
+
+static bool near(float a, float b) { return std::abs(a - b) < 1e-4f; }
+
+/// A controller and a clock that moves by each frame's time as it is
+/// presented.
+class SimulatedFrames {
+  public:
+    explicit SimulatedFrames(DynamicResolutionController::Settings settings)
+        : controller(settings) {
+        // The first present only starts the timing.
+        OSVRRM_CHECK(!controller.framePresented(now, us(0), TARGET_MS));
+    }
+
+    /// Present frames that each took frameMS, of which waitedMS was spent
+    /// waiting.  @return How many of them changed the scale.
+    int present(int frames, float frameMS, float waitedMS = 0) {
+        int changes = 0;
+        for (int i = 0; i < frames; i++) {
+            now += us(static_cast<long>(frameMS * 1000));
+            if (controller.framePresented(
+                    now, us(static_cast<long>(waitedMS * 1000)), TARGET_MS)) {
+                changes++;
+            }
+        }
+        return changes;
+    }
+
+    DynamicResolutionController controller;
+    Clock::time_point now;
+};
+
+static DynamicResolutionController::Settings settings() {
+    DynamicResolutionController::Settings ret;
+    ret.minScale = 0.5f;
+    ret.maxScale = 1.0f;
+    ret.headroom = 0.2f;
+    ret.step = 0.1f;
+    ret.holdFrames = 5;
+    return ret;
+}
+
+/// Frames over the target shrink the scale one step per hold period.
+static void testShrinksWhenOverTarget() {
+    SimulatedFrames f(settings());
+    OSVRRM_CHECK(near(f.controller.scale(), 1.0f));
+    OSVRRM_CHECK(f.present(4, 15) == 0);
+    OSVRRM_CHECK(near(f.controller.scale(), 1.0f));
+    OSVRRM_CHECK(f.present(1, 15) == 1);
+    OSVRRM_CHECK(near(f.controller.scale(), 0.9f));
+
+    // Held for another holdFrames frames before the next step.
+    OSVRRM_CHECK(f.present(4, 15) == 0);
+    OSVRRM_CHECK(f.present(1, 15) == 1);
+    OSVRRM_CHECK(near(f.controller.scale(), 0.8f));
+}
+
+/// Between the target and the headroom below it, nothing changes in
+/// either direction.
+static void testHysteresis() {
+    SimulatedFrames f(settings());
+    OSVRRM_CHECK(f.present(5, 10.5f) == 1);
+    OSVRRM_CHECK(near(f.controller.scale(), 0.9f));
+
+    // 9 ms is under the 10 ms target but not 20% under it.
+    OSVRRM_CHECK(f.present(100, 9) == 0);
+    OSVRRM_CHECK(near(f.controller.scale(), 0.9f));
+
+    // 7 ms is, so the scale grows back.
+    OSVRRM_CHECK(f.present(100, 7) > 0);
+    OSVRRM_CHECK(near(f.controller.scale(), 1.0f));
+}
+
+/// The smoothing keeps a single slow frame from changing the scale.
+static void testSmoothing() {
+    SimulatedFrames f(settings());
+    OSVRRM_CHECK(f.present(20, 8.5f) == 0);
+    OSVRRM_CHECK(f.present(1, 12) == 0);
+    OSVRRM_CHECK(f.present(20, 8.5f) == 0);
+    OSVRRM_CHECK(near(f.controller.scale(), 1.0f));
+}
+
+/// The scale stays within the configured bounds however far off the
+/// frame time is.
+static void testClamp() {
+    SimulatedFrames f(settings());
+    f.present(1000, 50);
+    OSVRRM_CHECK(near(f.controller.scale(), 0.5f));
+    OSVRRM_CHECK(f.present(100, 50) == 0);
+
+    f.present(1000, 1);
+    OSVRRM_CHECK(near(f.controller.scale(), 1.0f));
+    OSVRRM_CHECK(f.present(100, 1) == 0);
+
+    // Out-of-range bounds are clamped, and the scale starts at the top.
+    DynamicResolutionController::Settings s = settings();
+    s.minScale = 0.0f;
+    s.maxScale = 2.0f;
+    DynamicResolutionController wide(s);
+    OSVRRM_CHECK(near(wide.settings().minScale,
+                      DynamicResolutionController::SMALLEST_SCALE));
+    OSVRRM_CHECK(near(wide.settings().maxScale, 1.0f));
+    OSVRRM_CHECK(near(wide.scale(), 1.0f));
+
+    s.minScale = 0.8f;
+    s.maxScale = 0.6f;
+    DynamicResolutionController inverted(s);
+    OSVRRM_CHECK(near(inverted.settings().minScale, 0.6f));
+    OSVRRM_CHECK(near(inverted.scale(), 0.6f));
+}
+
+/// Time spent waiting for the time-warp threshold is not counted, so a
+/// frame paced to the display with time to spare is under budget.
+static void testWaitNotCounted() {
+    SimulatedFrames f(settings());
+    OSVRRM_CHECK(f.present(5, 15) == 1);
+    OSVRRM_CHECK(f.present(100, 15, 10) > 0);
+    OSVRRM_CHECK(near(f.controller.scale(), 1.0f));
+    OSVRRM_CHECK(near(f.controller.smoothedFrameMS(), 5.0f));
+}
+
+/// Without a target, frames are measured but the scale is left alone.
+static void testNoTarget() {
+    DynamicResolutionController controller(settings());
+    Clock::time_point now;
+    for (int i = 0; i < 100; i++) {
+        now += us(50000);
+        OSVRRM_CHECK(!controller.framePresented(now, us(0), 0));
+    }
+    OSVRRM_CHECK(near(controller.scale(), 1.0f));
+    OSVRRM_CHECK(near(controller.smoothedFrameMS(), 50.0f));
+}
+
+int main(int argc, char* argv[]) {
+    testShrinksWhenOverTarget();
+    testHysteresis();
+    testSmoothing();
+    testClamp();
+    testWaitNotCounted();
+    testNoTarget();
+    return osvr::renderkit::test::result();
+}
@@ -0,0 +1,204 @@
+/** @file
+@brief Benchmark comparing the frame time of checking for OpenGL errors with
+glGetError() after each step against having them reported by a debug
+callback, as RenderManagerOpenGL does
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "TestTiming.h"
+#include <GL/glew.h>
+#include <SDL.h>
+
+// Standard includes
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+using osvr::renderkit::test::Durations;
+using osvr::renderkit::test::SKIPPED;
+typedef std::chrono::steady_clock Clock;
+
+/// Number of frames timed for each way of checking.
+static const size_t FRAMES = 500;
+
+/// Size of each eye's render texture.
+static const GLsizei EYE_SIZE = 1024;
+
+/// Errors the debug callback has been told about.
+static std::atomic<int> g_debugErrors(0);
+
+static void GLAPIENTRY countDebugError(GLenum, GLenum type, GLuint, GLenum,
+                                       GLsizei, const GLchar*, const void*) {
+    if (type == GL_DEBUG_TYPE_ERROR) {
+        g_debugErrors++;
+    }
+}
+
+/// The buffers for two eyes.
+struct Eyes {
+    GLuint framebuffer = 0;
+    GLuint color[2] = {0, 0};
+    GLuint depth = 0;
+};
+
+/// The error checks, or nothing when the callback is reporting errors.
+static bool g_synchronous = true;
+static void check() {
+    if (g_synchronous && glGetError() != GL_NO_ERROR) {
+        std::cerr << "Unexpected OpenGL error" << std::endl;
+    }
+}
+
+/// The OpenGL calls RenderManagerOpenGL makes for a frame, with an error
+/// check after each step as it does: set up each eye's framebuffer, clear
+/// it, then put each eye onto the screen and swap.
+static void frame(SDL_Window* window, const Eyes& eyes) {
+    check();
+    for (int eye = 0; eye < 2; eye++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, eyes.framebuffer);
+        check();
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, eyes.color[eye], 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                  GL_RENDERBUFFER, eyes.depth);
+        check();
+        glViewport(0, 0, EYE_SIZE, EYE_SIZE);
+        glClearColor(eye ? 1.0f : 0.0f, 0.5f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        check();
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    for (int eye = 0; eye < 2; eye++) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, eyes.color[eye], 0);
+        glBlitFramebuffer(0, 0, EYE_SIZE, EYE_SIZE, eye * 320, 0,
+                          (eye + 1) * 320, 480, GL_COLOR_BUFFER_BIT,
+                          GL_LINEAR);
+        check();
+    }
+    check();
+    SDL_GL_SwapWindow(window);
+}
+
+static Durations timeFrames(SDL_Window* window, const Eyes& eyes) {
+    Durations ret;
+    for (size_t i = 0; i < FRAMES; i++) {
+        Clock::time_point start = Clock::now();
+        frame(window, eyes);
+        ret.add(Clock::now() - start);
+    }
+    return ret;
+}
+
+static void report(const char* what, const Durations& d) {
+    std::cout << what << ": median " << d.median() << " us, 99% "
+              << d.percentile(0.99) << " us, max " << d.max() << " us"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        std::cerr << "Could not initialize SDL video, skipping: "
+                  << SDL_GetError() << std::endl;
+        return SKIPPED;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                        SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_Window* window = SDL_CreateWindow(
+        "GLErrorCheckBenchmark", 0, 0, 640, 480,
+        SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context = window ? SDL_GL_CreateContext(window) : nullptr;
+    if (context == nullptr) {
+        std::cerr << "Could not get an OpenGL 3.3 debug context, skipping: "
+                  << SDL_GetError() << std::endl;
+        SDL_Quit();
+        return SKIPPED;
+    }
+    glewExperimental = GL_TRUE;
+    bool haveDebug = (glewInit() == GLEW_OK) &&
+                     (GLEW_KHR_debug || GLEW_VERSION_4_3);
+    if (haveDebug) {
+        GLint contextFlags = 0;
+        glGetIntegerv(GL_CONTEXT_FLAGS, &contextFlags);
+        haveDebug = (contextFlags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+    }
+    if (!haveDebug) {
+        std::cerr << "No KHR_debug debug context, skipping" << std::endl;
+        SDL_GL_DeleteContext(context);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return SKIPPED;
+    }
+    // Don't let the swap wait for vsync, which would hide the difference.
+    SDL_GL_SetSwapInterval(0);
+    glGetError();
+
+    Eyes eyes;
+    glGenFramebuffers(1, &eyes.framebuffer);
+    glGenTextures(2, eyes.color);
+    for (int eye = 0; eye < 2; eye++) {
+        glBindTexture(GL_TEXTURE_2D, eyes.color[eye]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, EYE_SIZE, EYE_SIZE, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+    glGenRenderbuffers(1, &eyes.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, eyes.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, EYE_SIZE,
+                          EYE_SIZE);
+    OSVRRM_CHECK(glGetError() == GL_NO_ERROR);
+
+    // Warm up, then time each way of checking.
+    timeFrames(window, eyes);
+    g_synchronous = true;
+    Durations synchronous = timeFrames(window, eyes);
+
+    g_synchronous = false;
+    glDebugMessageCallback(countDebugError, nullptr);
+    glEnable(GL_DEBUG_OUTPUT);
+    Durations callback = timeFrames(window, eyes);
+
+    report("glGetError() after each step", synchronous);
+    report("Debug callback", callback);
+    OSVRRM_CHECK(g_debugErrors == 0);
+
+    // Make sure errors do reach the callback in this context.  Binding a
+    // name that was never generated is an error in a core profile.
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0x7fffffff);
+    OSVRRM_CHECK(g_debugErrors > 0);
+
+    glDebugMessageCallback(nullptr, nullptr);
+    glDeleteRenderbuffers(1, &eyes.depth);
+    glDeleteTextures(2, eyes.color);
+    glDeleteFramebuffers(1, &eyes.framebuffer);
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return osvr::renderkit::test::result();
+}
@@ -0,0 +1,197 @@
+/** @file
+@brief Test of the multi-resolution layout: the pixels each profile renders
+against the analytical fraction, and the regions' viewports for both
+viewport origins
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include <GL/glew.h>
+#include "RenderManagerOpenGL.h"
+
+// Standard includes
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using osvr::renderkit::RenderInfo;
+using osvr::renderkit::RenderManager;
+using osvr::renderkit::RenderManagerOpenGL;
+using osvr::renderkit::test::SKIPPED;
+typedef RenderManager::ConstructorParameters Parameters;
+
+/// Two eyes side by side on a 1920x1080 display.
+static const char* DISPLAY =
+    "{\"hmd\": {"
+    " \"field_of_view\": {\"monocular_horizontal\": 90,"
+    "  \"monocular_vertical\": 90},"
+    " \"device\": {\"vendor\": \"OSVR\", \"model\": \"Test\"},"
+    " \"resolutions\": [{\"width\": 1920, \"height\": 1080,"
+    "  \"video_inputs\": 1, \"display_mode\": \"horz_side_by_side\"}],"
+    " \"eyes\": [{}, {}]}}";
+
+/// Center fraction and border scale used for the custom profile.
+static const double CUSTOM_CENTER = 0.4;
+static const double CUSTOM_BORDER = 0.25;
+
+/// The OpenGL renderer, built from our own parameters rather than from a
+/// server's configuration, with the viewport origin chosen by the test.
+/// Nothing is opened, so no OpenGL calls are made.
+class TestRenderManager : public RenderManagerOpenGL {
+  public:
+    TestRenderManager(std::shared_ptr<osvr::clientkit::ClientContext> context,
+                      ConstructorParameters p, bool originIsTop)
+        : RenderManagerOpenGL(context, p), m_originIsTop(originIsTop) {}
+
+  protected:
+    bool ViewportOriginIsTop() const override { return m_originIsTop; }
+
+  private:
+    bool m_originIsTop;
+};
+
+static std::unique_ptr<RenderManager>
+makeRenderManager(Parameters::Multi_Resolution_Profile profile,
+                  bool originIsTop) {
+    std::shared_ptr<osvr::clientkit::ClientContext> context =
+        std::make_shared<osvr::clientkit::ClientContext>(
+            "com.osvr.renderManager.MultiResolutionTest");
+    Parameters p;
+    p.m_renderLibrary = "OpenGL";
+    p.m_multiResolutionProfile = profile;
+    p.m_multiResolutionCenterFraction = static_cast<float>(CUSTOM_CENTER);
+    p.m_multiResolutionBorderScale = static_cast<float>(CUSTOM_BORDER);
+    std::unique_ptr<RenderManager> ret;
+    try {
+        p.m_displayConfiguration.parse(DISPLAY);
+        ret.reset(new TestRenderManager(context, p, originIsTop));
+    } catch (std::exception& e) {
+        std::cerr << "Could not make a RenderManager: " << e.what()
+                  << std::endl;
+    }
+    return ret;
+}
+
+/// Each profile renders about (c + (1 - c) s)^2 of the pixels, for a center
+/// fraction c and border scale s, less only the rounding of the regions to
+/// whole pixels.
+static void testPixelCounts(RenderManager& render) {
+    struct Expected {
+        Parameters::Multi_Resolution_Profile profile;
+        const char* name;
+        double center;
+        double border;
+    };
+    const Expected expected[] = {
+        {Parameters::MultiResolution_Off, "Off", 1, 1},
+        {Parameters::MultiResolution_Conservative, "Conservative", 0.7, 0.75},
+        {Parameters::MultiResolution_Balanced, "Balanced", 0.6, 0.5},
+        {Parameters::MultiResolution_Aggressive, "Aggressive", 0.5,
+         1.0 / 3.0},
+        {Parameters::MultiResolution_Custom, "Custom", CUSTOM_CENTER,
+         CUSTOM_BORDER}};
+
+    std::vector<RenderManager::MultiResolutionPixelCounts> counts =
+        render.GetMultiResolutionPixelCounts();
+    if (!OSVRRM_CHECK(counts.size() ==
+                      sizeof(expected) / sizeof(expected[0]))) {
+        return;
+    }
+    for (size_t i = 0; i < counts.size(); i++) {
+        const Expected& e = expected[i];
+        OSVRRM_CHECK(counts[i].profile == e.profile);
+        OSVRRM_CHECK(counts[i].fullPixels > 0);
+        double linear = e.center + (1 - e.center) * e.border;
+        double analytical = linear * linear;
+        double ratio = static_cast<double>(counts[i].renderedPixels) /
+                       static_cast<double>(counts[i].fullPixels);
+        std::cout << e.name << " (" << e.center * 100 << "% center, borders "
+                  << e.border << "): " << counts[i].renderedPixels << " of "
+                  << counts[i].fullPixels << " pixels, " << ratio * 100
+                  << "% (analytically " << analytical * 100 << "%), saving "
+                  << (1 - ratio) * 100 << "%" << std::endl;
+        OSVRRM_CHECK(std::abs(ratio - analytical) < 0.005);
+    }
+}
+
+/// The regions of the first eye, from one that measures viewports from
+/// the bottom and one that measures them from the top.
+static void testRegions(RenderManager& fromBottom, RenderManager& fromTop) {
+    if (!OSVRRM_CHECK(fromBottom.LatchRenderInfo() > 0) ||
+        !OSVRRM_CHECK(fromTop.LatchRenderInfo() > 0)) {
+        return;
+    }
+    RenderInfo eye = fromBottom.GetRenderInfo(0);
+    OSVRRM_CHECK(fromBottom.GetNumRenderRegions() == 9);
+    OSVRRM_CHECK(fromTop.GetNumRenderRegions() == 9);
+    OSVRRM_CHECK(eye.viewport.left == 0 && eye.viewport.lower == 0);
+
+    double area = 0;
+    for (size_t r = 0; r < 9; r++) {
+        RenderInfo bottom, top;
+        if (!OSVRRM_CHECK(fromBottom.GetRenderRegion(eye, r, bottom)) ||
+            !OSVRRM_CHECK(fromTop.GetRenderRegion(eye, r, top))) {
+            return;
+        }
+        area += bottom.viewport.width * bottom.viewport.height;
+
+        // Region 0 is at the lower left of the view, so it is at the
+        // bottom of the texture for OpenGL and at the top for D3D, which
+        // is the same rows of pixels.  The layout is symmetric, so each
+        // region is the same size either way.
+        if (r / 3 == 0) {
+            OSVRRM_CHECK(bottom.viewport.lower == 0);
+        }
+        OSVRRM_CHECK(top.viewport.left == bottom.viewport.left);
+        OSVRRM_CHECK(top.viewport.width == bottom.viewport.width);
+        OSVRRM_CHECK(top.viewport.height == bottom.viewport.height);
+        OSVRRM_CHECK(top.viewport.lower == eye.viewport.height -
+                                               bottom.viewport.lower -
+                                               bottom.viewport.height);
+
+        // The frustum doesn't depend on where the viewport is measured
+        // from.
+        OSVRRM_CHECK(top.projection.left == bottom.projection.left);
+        OSVRRM_CHECK(top.projection.right == bottom.projection.right);
+        OSVRRM_CHECK(top.projection.bottom == bottom.projection.bottom);
+        OSVRRM_CHECK(top.projection.top == bottom.projection.top);
+    }
+
+    // The regions tile the packed texture.
+    OSVRRM_CHECK(area == eye.viewport.width * eye.viewport.height);
+}
+
+int main(int argc, char* argv[]) {
+    std::unique_ptr<RenderManager> fromBottom =
+        makeRenderManager(Parameters::MultiResolution_Balanced, false);
+    std::unique_ptr<RenderManager> fromTop =
+        makeRenderManager(Parameters::MultiResolution_Balanced, true);
+    if (!fromBottom || !fromTop) {
+        return SKIPPED;
+    }
+    testPixelCounts(*fromBottom);
+    testRegions(*fromBottom, *fromTop);
+    return osvr::renderkit::test::result();
+}
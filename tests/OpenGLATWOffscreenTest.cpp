@@ -0,0 +1,162 @@
+/** @file
+@brief Test of the OpenGL asynchronous time warp renderer on an offscreen
+window, meant to be run with a software OpenGL such as llvmpipe
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "TestServer.h"
+#include <GL/glew.h>
+#include "RenderManagerOpenGLATW.h"
+#include <osvr/RenderKit/GraphicsLibraryOpenGL.h>
+
+// Standard includes
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using osvr::renderkit::RenderManager;
+using osvr::renderkit::RenderManagerOpenGLATW;
+using osvr::renderkit::RenderBuffer;
+using osvr::renderkit::RenderInfo;
+using osvr::renderkit::test::SKIPPED;
+typedef std::chrono::steady_clock Clock;
+
+/// Number of frames the application presents.
+static const size_t FRAMES = 120;
+
+/// One set of color buffers for all of the eyes.
+static std::vector<RenderBuffer>
+makeBuffers(const std::vector<RenderInfo>& renderInfo) {
+    std::vector<RenderBuffer> ret;
+    for (size_t i = 0; i < renderInfo.size(); i++) {
+        RenderBuffer rb;
+        rb.OpenGL = new osvr::renderkit::RenderBufferOpenGL;
+        glGenTextures(1, &rb.OpenGL->colorBufferName);
+        glBindTexture(GL_TEXTURE_2D, rb.OpenGL->colorBufferName);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                     static_cast<GLsizei>(renderInfo[i].viewport.width),
+                     static_cast<GLsizei>(renderInfo[i].viewport.height), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        ret.push_back(rb);
+    }
+    return ret;
+}
+
+/// The textures go away with the RenderManager's contexts, which the ATW
+/// thread may be presenting from until it is destroyed.
+static void deleteBuffers(std::vector<RenderBuffer>& buffers) {
+    for (size_t i = 0; i < buffers.size(); i++) {
+        delete buffers[i].OpenGL;
+    }
+    buffers.clear();
+}
+
+int main(int argc, char* argv[]) {
+    osvr::clientkit::ClientContext context(
+        "com.osvr.renderManager.OpenGLATWOffscreenTest");
+    if (!osvr::renderkit::test::waitForServer(context)) {
+        std::cerr << "No OSVR server is describing a display, skipping"
+                  << std::endl;
+        return SKIPPED;
+    }
+
+    std::unique_ptr<RenderManager> render(
+        osvr::renderkit::createRenderManager(context.get(), "OpenGL"));
+    if (!render || !render->doingOkay() ||
+        dynamic_cast<RenderManagerOpenGLATW*>(render.get()) == nullptr) {
+        std::cerr << "The server's configuration does not ask for OpenGL "
+                     "asynchronous time warp, skipping"
+                  << std::endl;
+        return SKIPPED;
+    }
+    RenderManager::OpenResults opened = render->OpenDisplay();
+    if (opened.status == RenderManager::OpenStatus::FAILURE) {
+        std::cerr << "Could not open an offscreen display, skipping"
+                  << std::endl;
+        return SKIPPED;
+    }
+
+    // Render() would draw into buffers that the ATW thread is presenting.
+    OSVRRM_CHECK(!render->Render());
+
+    // Two sets of buffers, used on alternate frames.
+    context.update();
+    std::vector<RenderInfo> renderInfo = render->GetRenderInfo();
+    std::vector<RenderBuffer> buffers[2] = {makeBuffers(renderInfo),
+                                            makeBuffers(renderInfo)};
+    std::vector<RenderBuffer> registered = buffers[0];
+    registered.insert(registered.end(), buffers[1].begin(), buffers[1].end());
+    OSVRRM_CHECK(render->RegisterRenderBuffers(registered));
+
+    GLuint frameBuffer;
+    glGenFramebuffers(1, &frameBuffer);
+    Clock::duration longestPresent = Clock::duration::zero();
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        context.update();
+        renderInfo = render->GetRenderInfo();
+        std::vector<RenderBuffer>& set = buffers[frame % 2];
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+        for (size_t i = 0; i < renderInfo.size(); i++) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_2D,
+                                   set[i].OpenGL->colorBufferName, 0);
+            glViewport(0, 0,
+                       static_cast<GLsizei>(renderInfo[i].viewport.width),
+                       static_cast<GLsizei>(renderInfo[i].viewport.height));
+            glClearColor(frame % 2 ? 1.0f : 0.0f, 0.5f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        Clock::time_point start = Clock::now();
+        if (!OSVRRM_CHECK(render->PresentRenderBuffers(set, renderInfo))) {
+            break;
+        }
+        Clock::duration took = Clock::now() - start;
+        if (took > longestPresent) {
+            longestPresent = took;
+        }
+        OSVRRM_CHECK(render->doingOkay());
+    }
+    std::cout << "Longest PresentRenderBuffers(): "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                     longestPresent)
+                     .count()
+              << " us" << std::endl;
+
+    // Let the ATW thread re-present the last frame for a while, then shut
+    // it down, which deletes its vertex array objects in its own context.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    OSVRRM_CHECK(render->doingOkay());
+    glDeleteFramebuffers(1, &frameBuffer);
+    render.reset();
+    deleteBuffers(buffers[0]);
+    deleteBuffers(buffers[1]);
+
+    return osvr::renderkit::test::result();
+}
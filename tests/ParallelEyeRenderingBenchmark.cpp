@@ -0,0 +1,468 @@
+/** @file
+@brief Benchmark of how frame time scales with the number of eyes when the
+eyes are rendered in turn and when they are rendered in parallel
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "TestTiming.h"
+#include <GL/glew.h>
+#include "RenderManagerOpenGL.h"
+
+// Standard includes
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using osvr::renderkit::RenderManager;
+using osvr::renderkit::RenderManagerOpenGL;
+using osvr::renderkit::test::Durations;
+using osvr::renderkit::test::SKIPPED;
+typedef std::chrono::steady_clock Clock;
+
+/// Number of frames timed for each configuration.
+static const size_t FRAMES = 200;
+
+/// Time each eye's render callback spends on the CPU, standing in for an
+/// application walking its scene.
+static const std::chrono::microseconds SCENE_TIME(2000);
+
+/// Size of each eye's buffers.
+static const int EYE_WIDTH = 960;
+static const int EYE_HEIGHT = 1080;
+
+/// Eye counts timed with synthetic eyes.  RenderManager only describes
+/// displays with one or two eyes (GetNumDisplays() and
+/// GetNumEyesPerDisplay() handle no others), so four and six eyes are
+/// timed by rendering the eyes the way its eye workers do, outside it.
+static const size_t SYNTHETIC_EYES[] = {2, 4, 6};
+
+/// Display descriptors with one eye, two eyes on one display and two eyes
+/// on two displays, which is the case where the eyes' contexts belong to
+/// different windows.
+static const char* MONO_DISPLAY =
+    "{\"hmd\": {"
+    " \"field_of_view\": {\"monocular_horizontal\": 90,"
+    "  \"monocular_vertical\": 90},"
+    " \"device\": {\"vendor\": \"OSVR\", \"model\": \"Benchmark\"},"
+    " \"resolutions\": [{\"width\": 960, \"height\": 1080,"
+    "  \"video_inputs\": 1}],"
+    " \"eyes\": [{}]}}";
+static const char* SIDE_BY_SIDE_DISPLAY =
+    "{\"hmd\": {"
+    " \"field_of_view\": {\"monocular_horizontal\": 90,"
+    "  \"monocular_vertical\": 90},"
+    " \"device\": {\"vendor\": \"OSVR\", \"model\": \"Benchmark\"},"
+    " \"resolutions\": [{\"width\": 1920, \"height\": 1080,"
+    "  \"video_inputs\": 1, \"display_mode\": \"horz_side_by_side\"}],"
+    " \"eyes\": [{}, {}]}}";
+static const char* TWO_DISPLAYS =
+    "{\"hmd\": {"
+    " \"field_of_view\": {\"monocular_horizontal\": 90,"
+    "  \"monocular_vertical\": 90},"
+    " \"device\": {\"vendor\": \"OSVR\", \"model\": \"Benchmark\"},"
+    " \"resolutions\": [{\"width\": 960, \"height\": 1080,"
+    "  \"video_inputs\": 2, \"display_mode\": \"full_screen\"}],"
+    " \"eyes\": [{}, {}]}}";
+
+/// The OpenGL renderer, built from our own parameters rather than from a
+/// server's configuration.
+class BenchmarkRenderManager : public RenderManagerOpenGL {
+  public:
+    BenchmarkRenderManager(
+        std::shared_ptr<osvr::clientkit::ClientContext> context,
+        ConstructorParameters p)
+        : RenderManagerOpenGL(context, p) {}
+};
+
+/// Keep the CPU busy for SCENE_TIME, then clear the bound framebuffer.
+static void drawEye() {
+    Clock::time_point end = Clock::now() + SCENE_TIME;
+    while (Clock::now() < end) {
+    }
+    glClearColor(0.0f, 0.5f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/// Render callback that draws an eye.
+static void drawScene(void*, osvr::renderkit::GraphicsLibrary,
+                      osvr::renderkit::RenderBuffer,
+                      osvr::renderkit::OSVR_ViewportDescription,
+                      OSVR_PoseState, osvr::renderkit::OSVR_ProjectionMatrix,
+                      OSVR_TimeValue) {
+    drawEye();
+}
+
+/// Time Render() on a display, with the eyes in turn or in parallel.
+/// @return False if the display could not be opened.
+static bool timeRender(const char* display, bool parallel, size_t& numEyes,
+                       Durations& frames) {
+    std::shared_ptr<osvr::clientkit::ClientContext> context =
+        std::make_shared<osvr::clientkit::ClientContext>(
+            "com.osvr.renderManager.ParallelEyeRenderingBenchmark");
+    RenderManager::ConstructorParameters p;
+    p.m_renderLibrary = "OpenGL";
+    p.m_verticalSync = false;
+    p.m_enableTimeWarp = false;
+    p.m_parallelEyeRendering = parallel;
+    std::unique_ptr<RenderManager> render;
+    try {
+        p.m_displayConfiguration.parse(display);
+        render.reset(new BenchmarkRenderManager(context, p));
+    } catch (std::exception& e) {
+        std::cerr << "Could not make a RenderManager: " << e.what()
+                  << std::endl;
+        return false;
+    }
+    if (!render->doingOkay() ||
+        render->OpenDisplay().status == RenderManager::OpenStatus::FAILURE) {
+        return false;
+    }
+    numEyes = render->LatchRenderInfo();
+    render->AddRenderCallback("/", drawScene);
+
+    // Warm up, then time.
+    for (size_t frame = 0; frame < 10; frame++) {
+        if (!OSVRRM_CHECK(render->Render())) {
+            return true;
+        }
+    }
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        Clock::time_point start = Clock::now();
+        if (!OSVRRM_CHECK(render->Render())) {
+            break;
+        }
+        frames.add(Clock::now() - start);
+    }
+    OSVRRM_CHECK(render->doingOkay());
+    return true;
+}
+
+/// Any number of eyes, each with a color texture and depth renderbuffer,
+/// rendered either in turn from the main context or by one worker thread
+/// per eye with its own context shared with the main one, as
+/// RenderManagerOpenGL's eye workers render them.
+class SyntheticEyes {
+  public:
+    /// Call with context current on window.
+    SyntheticEyes(SDL_Window* window, SDL_GLContext context, size_t numEyes)
+        : m_window(window), m_context(context) {
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            std::unique_ptr<Eye> e(new Eye);
+            glGenTextures(1, &e->color);
+            glBindTexture(GL_TEXTURE_2D, e->color);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, EYE_WIDTH, EYE_HEIGHT, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glGenRenderbuffers(1, &e->depth);
+            glBindRenderbuffer(GL_RENDERBUFFER, e->depth);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
+                                  EYE_WIDTH, EYE_HEIGHT);
+            glGenFramebuffers(1, &e->framebuffer);
+            m_ok = attach(e->framebuffer, *e) && m_ok;
+            m_eyes.push_back(std::move(e));
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glFinish();
+
+        for (size_t eye = 0; eye < numEyes; eye++) {
+            Eye& e = *m_eyes[eye];
+            SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+            e.context = SDL_GL_CreateContext(m_window);
+            SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+            SDL_GL_MakeCurrent(m_window, m_context);
+            if (e.context == nullptr) {
+                std::cerr << "Could not get an OpenGL context for eye " << eye
+                          << ": " << SDL_GetError() << std::endl;
+                m_ok = false;
+                return;
+            }
+            e.thread = std::thread(&SyntheticEyes::workerFunc, this, &e);
+        }
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_condition.wait(lock, [&]() {
+            for (size_t eye = 0; eye < m_eyes.size(); eye++) {
+                if (!m_eyes[eye]->started) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        for (size_t eye = 0; eye < m_eyes.size(); eye++) {
+            m_ok = m_eyes[eye]->ok && m_ok;
+        }
+    }
+
+    ~SyntheticEyes() {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_quit = true;
+        }
+        m_condition.notify_all();
+        for (size_t eye = 0; eye < m_eyes.size(); eye++) {
+            Eye& e = *m_eyes[eye];
+            if (e.thread.joinable()) {
+                e.thread.join();
+            }
+            if (e.fence != nullptr) {
+                glDeleteSync(e.fence);
+            }
+            if (e.context != nullptr) {
+                SDL_GL_DeleteContext(e.context);
+            }
+            glDeleteFramebuffers(1, &e.framebuffer);
+            glDeleteRenderbuffers(1, &e.depth);
+            glDeleteTextures(1, &e.color);
+        }
+    }
+
+    bool ok() const { return m_ok; }
+
+    /// Render the eyes one after another and wait for the card to finish.
+    void renderInTurn() {
+        for (size_t eye = 0; eye < m_eyes.size(); eye++) {
+            glBindFramebuffer(GL_FRAMEBUFFER, m_eyes[eye]->framebuffer);
+            glViewport(0, 0, EYE_WIDTH, EYE_HEIGHT);
+            drawEye();
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glFinish();
+    }
+
+    /// Hand every eye to its worker, make the main context wait for each
+    /// worker's fence, and wait for the card to finish.
+    void renderParallel() {
+        std::unique_lock<std::mutex> lock(m_lock);
+        for (size_t eye = 0; eye < m_eyes.size(); eye++) {
+            m_eyes[eye]->pending = true;
+        }
+        m_condition.notify_all();
+        m_condition.wait(lock, [&]() {
+            for (size_t eye = 0; eye < m_eyes.size(); eye++) {
+                if (m_eyes[eye]->pending) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        for (size_t eye = 0; eye < m_eyes.size(); eye++) {
+            Eye& e = *m_eyes[eye];
+            glWaitSync(e.fence, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(e.fence);
+            e.fence = nullptr;
+        }
+        lock.unlock();
+        glFinish();
+    }
+
+  private:
+    struct Eye {
+        GLuint color = 0;
+        GLuint depth = 0;
+        GLuint framebuffer = 0; //< Only valid in the main context
+        SDL_GLContext context = nullptr;
+        std::thread thread;
+
+        // Guarded by m_lock.
+        bool started = false; //< Set once the worker's framebuffer is built
+        bool ok = false;      //< Whether it was
+        bool pending = false; //< The eye has been handed to the worker
+        GLsync fence = nullptr; //< Signals when the eye is rendered
+    };
+
+    /// Bind a framebuffer and attach an eye's buffers to it.
+    static bool attach(GLuint framebuffer, const Eye& e) {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, e.color, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                  GL_RENDERBUFFER, e.depth);
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+               GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void workerFunc(Eye* e) {
+        SDL_GL_MakeCurrent(m_window, e->context);
+
+        // Framebuffers are not shared, so each worker builds its own.
+        GLuint framebuffer = 0;
+        glGenFramebuffers(1, &framebuffer);
+        bool ok = attach(framebuffer, *e);
+        glViewport(0, 0, EYE_WIDTH, EYE_HEIGHT);
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        e->started = true;
+        e->ok = ok;
+        m_condition.notify_all();
+        while (true) {
+            m_condition.wait(lock, [&]() { return m_quit || e->pending; });
+            if (m_quit) {
+                break;
+            }
+            lock.unlock();
+
+            drawEye();
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+
+            lock.lock();
+            e->fence = fence;
+            e->pending = false;
+            m_condition.notify_all();
+        }
+        lock.unlock();
+        glDeleteFramebuffers(1, &framebuffer);
+        SDL_GL_MakeCurrent(m_window, nullptr);
+    }
+
+    SDL_Window* m_window;
+    SDL_GLContext m_context;
+    std::vector<std::unique_ptr<Eye> > m_eyes;
+    std::mutex m_lock;
+    std::condition_variable m_condition;
+    bool m_quit = false; //< Guarded by m_lock
+    bool m_ok = true;
+};
+
+/// Time frames of synthetic eyes, in turn and in parallel.
+/// @return False if the eyes could not be set up.
+static bool timeSynthetic(SDL_Window* window, SDL_GLContext context,
+                          size_t numEyes, Durations& inTurn,
+                          Durations& parallel) {
+    SyntheticEyes eyes(window, context, numEyes);
+    if (!eyes.ok()) {
+        return false;
+    }
+    for (size_t frame = 0; frame < 10; frame++) {
+        eyes.renderInTurn();
+        eyes.renderParallel();
+    }
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        Clock::time_point start = Clock::now();
+        eyes.renderInTurn();
+        inTurn.add(Clock::now() - start);
+    }
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        Clock::time_point start = Clock::now();
+        eyes.renderParallel();
+        parallel.add(Clock::now() - start);
+    }
+    return true;
+}
+
+/// Time two, four and six synthetic eyes in a hidden window's context.
+/// @return False if no OpenGL context could be made.
+static bool benchmarkSyntheticEyes() {
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        return false;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                        SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_Window* window = SDL_CreateWindow(
+        "ParallelEyeRenderingBenchmark", 0, 0, 64, 64,
+        SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context = window ? SDL_GL_CreateContext(window) : nullptr;
+    glewExperimental = true; // Needed for core profile
+    if (context == nullptr || glewInit() != GLEW_OK) {
+        if (context != nullptr) {
+            SDL_GL_DeleteContext(context);
+        }
+        if (window != nullptr) {
+            SDL_DestroyWindow(window);
+        }
+        SDL_Quit();
+        return false;
+    }
+
+    for (size_t numEyes : SYNTHETIC_EYES) {
+        Durations inTurn;
+        Durations parallel;
+        if (!OSVRRM_CHECK(
+                timeSynthetic(window, context, numEyes, inTurn, parallel))) {
+            continue;
+        }
+        std::cout << "Synthetic, " << numEyes << " eyes: in turn, median "
+                  << inTurn.median() << " us, 99% " << inTurn.percentile(0.99)
+                  << " us; in parallel, median " << parallel.median()
+                  << " us, 99% " << parallel.percentile(0.99)
+                  << " us; speedup " << inTurn.median() / parallel.median()
+                  << std::endl;
+    }
+
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    struct Configuration {
+        const char* name;
+        const char* display;
+    };
+    const Configuration configurations[] = {
+        {"One eye", MONO_DISPLAY},
+        {"Two eyes, one display", SIDE_BY_SIDE_DISPLAY},
+        {"Two eyes, two displays", TWO_DISPLAYS}};
+
+    bool ranAny = false;
+    for (const Configuration& c : configurations) {
+        size_t numEyes = 0;
+        Durations inTurn;
+        Durations parallel;
+        if (!timeRender(c.display, false, numEyes, inTurn) ||
+            !timeRender(c.display, true, numEyes, parallel)) {
+            std::cerr << c.name << ": could not open the display, skipping"
+                      << std::endl;
+            continue;
+        }
+        ranAny = true;
+        if (inTurn.size() == 0 || parallel.size() == 0) {
+            continue;
+        }
+        std::cout << c.name << " (" << numEyes << " eyes): in turn, median "
+                  << inTurn.median() << " us, 99% " << inTurn.percentile(0.99)
+                  << " us; in parallel, median " << parallel.median()
+                  << " us, 99% " << parallel.percentile(0.99)
+                  << " us; speedup " << inTurn.median() / parallel.median()
+                  << std::endl;
+    }
+    if (benchmarkSyntheticEyes()) {
+        ranAny = true;
+    } else {
+        std::cerr << "Synthetic eyes: could not get an OpenGL context, "
+                     "skipping"
+                  << std::endl;
+    }
+    if (!ranAny) {
+        return SKIPPED;
+    }
+    return osvr::renderkit::test::result();
+}
@@ -0,0 +1,199 @@
+/** @file
+@brief Test of the Eigen pose math in RenderKitPoseMath.h against the
+quatlib routines it replaced, on random poses
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "RenderKitPoseMath.h"
+
+// Library/third-party includes
+#include <quat.h>
+
+// Standard includes
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace posemath = osvr::renderkit::posemath;
+
+/// Number of random cases for each operation.
+static const int CASES = 1000;
+
+/// Largest difference allowed from quatlib, which works in double.
+static const double DOUBLE_TOLERANCE = 1e-12;
+static const double FLOAT_TOLERANCE = 1e-4;
+
+static std::mt19937 g_random(20160301);
+
+static double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(g_random);
+}
+
+/// A random pose whose rotation has the given length, since the inverse
+/// must not depend on it being a unit quaternion.
+static q_xyz_quat_type randomPose(double rotationLength = 1.0) {
+    q_xyz_quat_type ret;
+    std::normal_distribution<double> normal;
+    double length = 0;
+    do {
+        for (int i = 0; i < 4; i++) {
+            ret.quat[i] = normal(g_random);
+        }
+        length = std::sqrt(ret.quat[Q_X] * ret.quat[Q_X] +
+                           ret.quat[Q_Y] * ret.quat[Q_Y] +
+                           ret.quat[Q_Z] * ret.quat[Q_Z] +
+                           ret.quat[Q_W] * ret.quat[Q_W]);
+    } while (length < 1e-3);
+    for (int i = 0; i < 4; i++) {
+        ret.quat[i] *= rotationLength / length;
+    }
+    for (int i = 0; i < 3; i++) {
+        ret.xyz[i] = uniform(-10, 10);
+    }
+    return ret;
+}
+
+template <typename Scalar>
+static posemath::Pose<Scalar> fromQuatlib(const q_xyz_quat_type& q) {
+    posemath::Pose<Scalar> ret;
+    ret.rotation = typename posemath::Pose<Scalar>::Quaternion(
+        static_cast<Scalar>(q.quat[Q_W]), static_cast<Scalar>(q.quat[Q_X]),
+        static_cast<Scalar>(q.quat[Q_Y]), static_cast<Scalar>(q.quat[Q_Z]));
+    ret.translation = typename posemath::Pose<Scalar>::Vector(
+        static_cast<Scalar>(q.xyz[Q_X]), static_cast<Scalar>(q.xyz[Q_Y]),
+        static_cast<Scalar>(q.xyz[Q_Z]));
+    return ret;
+}
+
+/// Largest difference between a pose and quatlib's.  q and -q are the same
+/// rotation, so the rotation is compared against whichever is closer.
+template <typename Scalar>
+static double difference(const posemath::Pose<Scalar>& pose,
+                         const q_xyz_quat_type& q) {
+    const double mine[4] = {static_cast<double>(pose.rotation.x()),
+                            static_cast<double>(pose.rotation.y()),
+                            static_cast<double>(pose.rotation.z()),
+                            static_cast<double>(pose.rotation.w())};
+    double same = 0;
+    double negated = 0;
+    for (int i = 0; i < 4; i++) {
+        same = std::max(same, std::abs(mine[i] - q.quat[i]));
+        negated = std::max(negated, std::abs(mine[i] + q.quat[i]));
+    }
+    double ret = std::min(same, negated);
+    for (int i = 0; i < 3; i++) {
+        ret = std::max(ret, std::abs(static_cast<double>(pose.translation[i]) -
+                                     q.xyz[i]));
+    }
+    return ret;
+}
+
+template <typename Scalar> static void testCompose(double tolerance) {
+    for (int i = 0; i < CASES; i++) {
+        q_xyz_quat_type aFromB = randomPose();
+        q_xyz_quat_type bFromC = randomPose();
+        q_xyz_quat_type expected;
+        q_xyz_quat_compose(&expected, &aFromB, &bFromC);
+        posemath::Pose<Scalar> aFromC = posemath::compose(
+            fromQuatlib<Scalar>(aFromB), fromQuatlib<Scalar>(bFromC));
+        OSVRRM_CHECK(difference(aFromC, expected) < tolerance);
+    }
+}
+
+template <typename Scalar> static void testInvert(double tolerance) {
+    for (int i = 0; i < CASES; i++) {
+        q_xyz_quat_type aFromB = randomPose(uniform(0.5, 2.0));
+        q_xyz_quat_type expected;
+        q_xyz_quat_invert(&expected, &aFromB);
+        posemath::Pose<Scalar> bFromA =
+            posemath::invert(fromQuatlib<Scalar>(aFromB));
+        OSVRRM_CHECK(difference(bFromA, expected) < tolerance);
+    }
+}
+
+template <typename Scalar> static void testFromAxisAngle(double tolerance) {
+    for (int i = 0; i < CASES; i++) {
+        // quatlib normalizes the axis, so it need not be of unit length.
+        double x = uniform(-1, 1);
+        double y = uniform(-1, 1);
+        double z = uniform(-1, 1);
+        double angle = uniform(-Q_PI, Q_PI);
+        if (std::sqrt(x * x + y * y + z * z) < 1e-3) {
+            continue;
+        }
+        q_xyz_quat_type expected;
+        q_vec_set(expected.xyz, 0, 0, 0);
+        q_from_axis_angle(expected.quat, x, y, z, angle);
+        posemath::Pose<Scalar> pose = posemath::fromAxisAngle<Scalar>(
+            typename posemath::Pose<Scalar>::Vector(static_cast<Scalar>(x),
+                                                    static_cast<Scalar>(y),
+                                                    static_cast<Scalar>(z)),
+            static_cast<Scalar>(angle));
+        OSVRRM_CHECK(difference(pose, expected) < tolerance);
+    }
+}
+
+template <typename Scalar> static void testToMatrix(double tolerance) {
+    for (int i = 0; i < CASES; i++) {
+        // Both normalize the rotation before making the matrix.
+        q_xyz_quat_type pose = randomPose(uniform(0.5, 2.0));
+        qogl_matrix_type expected;
+        q_xyz_quat_to_ogl_matrix(expected, &pose);
+        Eigen::Matrix<Scalar, 4, 4> matrix =
+            posemath::toMatrix(fromQuatlib<Scalar>(pose));
+        double worst = 0;
+        for (int j = 0; j < 16; j++) {
+            worst = std::max(
+                worst,
+                std::abs(static_cast<double>(matrix.data()[j]) - expected[j]));
+        }
+        OSVRRM_CHECK(worst < tolerance);
+    }
+}
+
+/// Reading and writing OSVR_PoseState in double loses nothing.
+static void testOSVRRoundTrip() {
+    for (int i = 0; i < CASES; i++) {
+        q_xyz_quat_type q = randomPose();
+        OSVR_PoseState state;
+        posemath::toOSVR(state, fromQuatlib<double>(q));
+        OSVRRM_CHECK(osvrQuatGetW(&state.rotation) == q.quat[Q_W]);
+        OSVRRM_CHECK(osvrQuatGetX(&state.rotation) == q.quat[Q_X]);
+        OSVRRM_CHECK(osvrVec3GetZ(&state.translation) == q.xyz[Q_Z]);
+        OSVRRM_CHECK(difference(posemath::fromOSVR<double>(state), q) == 0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    testCompose<double>(DOUBLE_TOLERANCE);
+    testCompose<float>(FLOAT_TOLERANCE);
+    testInvert<double>(DOUBLE_TOLERANCE);
+    testInvert<float>(FLOAT_TOLERANCE);
+    testFromAxisAngle<double>(DOUBLE_TOLERANCE);
+    testFromAxisAngle<float>(FLOAT_TOLERANCE);
+    testToMatrix<double>(DOUBLE_TOLERANCE);
+    testToMatrix<float>(FLOAT_TOLERANCE);
+    testOSVRRoundTrip();
+    return osvr::renderkit::test::result();
+}
@@ -0,0 +1,146 @@
+/** @file
+@brief Benchmark of how long render-info queries from another thread take
+while the application thread is rendering and presenting
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "TestCheck.h"
+#include "TestServer.h"
+#include "TestTiming.h"
+#include <osvr/RenderKit/RenderManager.h>
+
+// Standard includes
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using osvr::renderkit::RenderManager;
+using osvr::renderkit::test::Durations;
+using osvr::renderkit::test::SKIPPED;
+typedef std::chrono::steady_clock Clock;
+
+/// Number of frames rendered while the other thread queries.
+static const size_t FRAMES = 300;
+
+/// Render callback that draws nothing, so that the frame time is that of
+/// RenderManager itself.
+static void drawNothing(void*, osvr::renderkit::GraphicsLibrary,
+                        osvr::renderkit::RenderBuffer,
+                        osvr::renderkit::OSVR_ViewportDescription,
+                        OSVR_PoseState, osvr::renderkit::OSVR_ProjectionMatrix,
+                        OSVR_TimeValue) {}
+
+/// Query timings, for latching and for reading the latched values.
+struct QueryTimes {
+    Durations latch;
+    Durations read;
+};
+
+/// Query from this thread until told to stop.
+static void query(RenderManager& render, std::atomic<bool>& stop,
+                  QueryTimes& times) {
+    size_t numEyes = render.LatchRenderInfo();
+    while (!stop.load()) {
+        Clock::time_point start = Clock::now();
+        OSVRRM_CHECK(render.LatchRenderInfo() == numEyes);
+        Clock::time_point latched = Clock::now();
+        render.GetRenderInfo(0);
+        Clock::time_point read = Clock::now();
+        times.latch.add(latched - start);
+        times.read.add(read - latched);
+    }
+}
+
+static void report(const char* what, const Durations& d) {
+    std::cout << what << ": " << d.size() << " calls, median " << d.median()
+              << " us, 99% " << d.percentile(0.99) << " us, max " << d.max()
+              << " us" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    osvr::clientkit::ClientContext context(
+        "com.osvr.renderManager.RenderInfoContentionBenchmark");
+    if (!osvr::renderkit::test::waitForServer(context)) {
+        std::cerr << "No OSVR server is describing a display, skipping"
+                  << std::endl;
+        return SKIPPED;
+    }
+    std::unique_ptr<RenderManager> render(
+        osvr::renderkit::createRenderManager(context.get(), "OpenGL"));
+    if (!render || !render->doingOkay() ||
+        render->OpenDisplay().status == RenderManager::OpenStatus::FAILURE) {
+        std::cerr << "Could not open a display, skipping" << std::endl;
+        return SKIPPED;
+    }
+    render->AddRenderCallback("/", drawNothing);
+    if (!render->Render()) {
+        std::cerr << "This configuration does not support Render(), skipping"
+                  << std::endl;
+        return SKIPPED;
+    }
+
+    // Queries with nothing else going on.
+    QueryTimes idle;
+    {
+        std::atomic<bool> stop(false);
+        std::thread querier(query, std::ref(*render), std::ref(stop),
+                            std::ref(idle));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        stop = true;
+        querier.join();
+    }
+
+    // Queries while this thread renders, which holds the graphics
+    // submission lock for each whole frame, including any wait for vsync.
+    QueryTimes contended;
+    Durations frames;
+    {
+        std::atomic<bool> stop(false);
+        std::thread querier(query, std::ref(*render), std::ref(stop),
+                            std::ref(contended));
+        for (size_t frame = 0; frame < FRAMES; frame++) {
+            Clock::time_point start = Clock::now();
+            if (!OSVRRM_CHECK(render->Render())) {
+                break;
+            }
+            frames.add(Clock::now() - start);
+        }
+        stop = true;
+        querier.join();
+    }
+
+    report("Render()", frames);
+    report("LatchRenderInfo(), idle", idle.latch);
+    report("LatchRenderInfo(), while rendering", contended.latch);
+    report("GetRenderInfo(index), idle", idle.read);
+    report("GetRenderInfo(index), while rendering", contended.read);
+
+    // The queries must have kept going while frames were being rendered,
+    // rather than only getting in between them.
+    OSVRRM_CHECK(contended.latch.size() > frames.size());
+
+    return osvr::renderkit::test::result();
+}
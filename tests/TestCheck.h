@@ -0,0 +1,75 @@
+/** @file
+@brief Header file with the minimal checking used by the RenderManager
+tests
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Standard includes
+#include <atomic>
+#include <iostream>
+
+namespace osvr {
+namespace renderkit {
+    namespace test {
+
+        /// Exit code that tells CTest that a test was skipped, used when
+        /// a test needs an OSVR server or a display that is not there.
+        static const int SKIPPED = 77;
+
+        /// Number of checks that have failed so far, on any thread.
+        inline std::atomic<int>& failures() {
+            static std::atomic<int> count(0);
+            return count;
+        }
+
+        /// Report a failed check.  Use OSVRRM_CHECK() rather than calling
+        /// this directly.
+        inline bool check(bool ok, const char* what, const char* file,
+                          int line) {
+            if (!ok) {
+                failures()++;
+                std::cerr << file << ":" << line << ": check failed: " << what
+                          << std::endl;
+            }
+            return ok;
+        }
+
+        /// Exit code for main(): zero if every check passed.
+        inline int result() {
+            int count = failures();
+            if (count != 0) {
+                std::cerr << count << " check(s) failed" << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+
+    } // namespace test
+} // namespace renderkit
+} // namespace osvr
+
+/// Check that a condition holds, reporting it and carrying on if not.
+/// Evaluates to the condition.
+#define OSVRRM_CHECK(cond)                                                     \
+    ::osvr::renderkit::test::check((cond), #cond, __FILE__, __LINE__)
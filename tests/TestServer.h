@@ -0,0 +1,62 @@
+/** @file
+@brief Header file with helpers for RenderManager tests that need an OSVR
+server
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Internal Includes
+#include <osvr/ClientKit/Context.h>
+#include <osvr/ClientKit/DisplayC.h>
+
+// Standard includes
+#include <chrono>
+#include <thread>
+
+namespace osvr {
+namespace renderkit {
+    namespace test {
+
+        /// Wait a few seconds for a server to describe the display, which
+        /// createRenderManager() would otherwise wait for forever.
+        /// @return True if a server did so.
+        inline bool waitForServer(osvr::clientkit::ClientContext& context) {
+            typedef std::chrono::steady_clock Clock;
+            Clock::time_point deadline =
+                Clock::now() + std::chrono::seconds(3);
+            while (Clock::now() < deadline) {
+                context.update();
+                OSVR_DisplayConfig display;
+                if (osvrClientGetDisplay(context.get(), &display) ==
+                    OSVR_RETURN_SUCCESS) {
+                    osvrClientFreeDisplay(display);
+                    return true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            return false;
+        }
+
+    } // namespace test
+} // namespace renderkit
+} // namespace osvr
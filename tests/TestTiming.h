@@ -0,0 +1,69 @@
+/** @file
+@brief Header file with timing helpers for the RenderManager benchmarks
+
+@date 2016
+
+@author
+Sensics, Inc.
+<http://sensics.com/osvr>
+*/
+
+// Copyright 2016 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Standard includes
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace osvr {
+namespace renderkit {
+    namespace test {
+
+        /// Durations measured by a benchmark, in microseconds.
+        class Durations {
+          public:
+            template <typename Duration> void add(Duration d) {
+                m_us.push_back(static_cast<double>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(d)
+                        .count()) /
+                               1e3);
+            }
+
+            size_t size() const { return m_us.size(); }
+
+            /// The given fraction of the durations are no longer than this,
+            /// or 0 if there are none.
+            double percentile(double fraction) const {
+                if (m_us.empty()) {
+                    return 0;
+                }
+                std::vector<double> sorted(m_us);
+                std::sort(sorted.begin(), sorted.end());
+                size_t i = static_cast<size_t>(fraction * (sorted.size() - 1));
+                return sorted[i];
+            }
+
+            double median() const { return percentile(0.5); }
+            double max() const { return percentile(1.0); }
+
+          private:
+            std::vector<double> m_us;
+        };
+
+    } // namespace test
+} // namespace renderkit
+} // namespace osvr